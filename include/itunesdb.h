@@ -33,6 +33,8 @@ typedef struct _dblist {
   void *data;
   struct _dblist *prev;
   struct _dblist *next;
+
+  struct _dblist *last; /* only kept up to date in the first entry */
 } db_list_t;
 
 db_list_t *db_list_first (db_list_t *);
@@ -41,6 +43,20 @@ db_list_t *db_list_prev (db_list_t *);
 db_list_t *db_list_prepend (db_list_t *p, void *d);
 db_list_t *db_list_append (db_list_t *p, void *d);
 
+/* contiguous growable list with O(1) append and indexed access */
+typedef struct _dbarray {
+  void **data;
+  int num_entries;
+  int size;
+} db_array_t;
+
+#define db_array_index(a, i) ((a)->data[(i)])
+
+int  db_array_init (db_array_t *array, int size);
+int  db_array_append (db_array_t *array, void *d);
+void db_array_free (db_array_t *array);
+db_list_t *db_list_from_array (db_array_t *array);
+
 #define ITUNESDB     "iPod_Control/iTunes/iTunesDB"
 #define ITUNESSD     "iPod_Control/iTunes/iTunesSD"
 #define ARTWORKDB    "iPod_Control/Artwork/ArtworkDB"
@@ -104,6 +120,13 @@ enum itunesdb_flags {
 
   /* this flag tells libupod to parse the database in place (speeds up loading under ipodlinux -- in theory) */
   FLAG_INPLACE = 0x4,
+
+  /* count every frame of an mp3 when adding it instead of trusting VBR
+     headers or estimating from the first few frames. slower but exact. */
+  FLAG_EXACT_DURATION = 0x8,
+
+  /* dither artwork when reducing it to 16 bits. set on the ArtworkDB. */
+  FLAG_DITHER_ARTWORK = 0x10,
 };
 
 typedef enum {UPOD_NOART=0, UPOD_PHOTOART, UPOD_NANOART, UPOD_VIDEOART} artwork_flag_t;
@@ -120,6 +143,13 @@ typedef struct _ipoddatabase {
   int type; /* 0 == iTunesDB, 1 == ArtworkDB */
 
   artwork_flag_t supports_artwork; /* field might not remain to v1 */
+
+  int num_threads; /* worker threads used for batch operations (0 == one per cpu) */
+
+  struct string_pool *string_pool; /* see db_string_pool_enable */
+
+  struct ithmb_writer *ithmb_writer; /* open thumbnail files (ArtworkDB only) */
+  struct photo_queue *photo_queue;   /* see db_photo_queue (ArtworkDB only) */
 } ipoddb_t;
 
 typedef struct _ipod {
@@ -213,6 +243,8 @@ struct song_info {
   int num_dohm;
 
   dohm_t *dohms;
+  /* dohm strings belong to the database's string pool and are not freed */
+  char pooled_strings;
 
   char is_video;
   char is_podcast;
@@ -222,6 +254,55 @@ struct song_info {
 
 typedef struct song_info tihm_t;
 
+/* numeric track fields (see db_track_cursor_get_u32) */
+enum track_fields {
+  TRACK_ID = 0,
+  TRACK_TYPE,
+  TRACK_BITRATE,
+  TRACK_SAMPLERATE,
+  TRACK_SIZE,
+  TRACK_TIME,          /* In milliseconds */
+  TRACK_NUMBER,
+  TRACK_ALBUM_TRACKS,
+  TRACK_DISK_NUM,
+  TRACK_DISK_TOTAL,
+  TRACK_YEAR,
+  TRACK_START_TIME,
+  TRACK_STOP_TIME,
+  TRACK_VOLUME_ADJUSTMENT,
+  TRACK_TIMES_PLAYED,
+  TRACK_STARS,
+  TRACK_BPM,
+  TRACK_PLAYED_DATE,
+  TRACK_MOD_DATE,
+  TRACK_CREATION_DATE,
+  TRACK_RELEASE_DATE,
+  TRACK_HAS_ARTWORK,
+  TRACK_NUM_FIELDS
+};
+
+/* iterates over the song list without copying it. the cursor is owned by the
+   caller and is only valid until the database is modified. */
+typedef struct _track_cursor {
+  ipoddb_t *itunesdb;
+  struct tree_node *track_list;
+  int index;
+} db_track_cursor_t;
+
+/* field selection mask for db_song_list_fields */
+#define FIELD_STRING(dohm_type) ((u_int64_t)1 << (dohm_type))
+#define FIELD_VALUE(track_field) ((u_int64_t)1 << (32 + (track_field)))
+
+#define TRACK_NUM_STRINGS (IPOD_DESCRIPTION + 1)
+
+/* one entry of a projected song list. only the requested fields are filled
+   in; strings that were not requested (or are missing) are NULL. */
+typedef struct _track_fields {
+  u_int32_t num;
+  u_int32_t values[TRACK_NUM_FIELDS];
+  char *strings[TRACK_NUM_STRINGS];
+} db_track_fields_t;
+
 typedef tihm_t mhit_t;
 typedef tihm_t ipod_track_t;
 
@@ -244,6 +325,8 @@ int    sd_create (ipoddb_t *ipodsd, u_int8_t *path, int flags);
 
 int    sd_write (ipoddb_t ipodsd, char *path);
 int    sd_song_add (ipoddb_t *ipodsd, char *ipod_path, int start, int stop, int volume);
+int    sd_song_list (ipoddb_t *ipodsd, db_list_t **head);
+int    sd_song_list_array (ipoddb_t *ipodsd, db_array_t *songs);
 
 /* itunesdb2/create.c */
 int    db_create (ipoddb_t *ipoddb, u_int8_t *db_name, u_int8_t *path, int flags);
@@ -251,22 +334,54 @@ int    db_photo_create (ipoddb_t *photodb, u_int8_t *path);
 
 /* itunesdb2/song_list.c */
 int  db_song_remove(ipoddb_t *itunesdb, u_int32_t tihm_num);
+int  db_song_remove_many (ipoddb_t *itunesdb, u_int32_t tihm_nums[], int num_tihms);
 int  db_song_add   (ipoddb_t *itunesdb, ipoddb_t *artworkdb, char *path, char *mac_path, int stars, int show);
+int  db_song_add_batch (ipoddb_t *itunesdb, ipoddb_t *artworkdb, char *paths[], char *mac_paths[],
+			int num_paths, int results[]);
+/* db_song_probe_batch flags */
+#define PROBE_EXISTING 0x1 /* also probe paths that are already in the database */
+int  db_song_probe_batch (ipoddb_t *itunesdb, char *paths[], char *mac_paths[], int num_paths,
+			  int flags, tihm_t tihms[], int results[]);
+int  db_song_add_probed (ipoddb_t *itunesdb, ipoddb_t *artworkdb, tihm_t *tihm, int show);
 int  db_song_dohm_tihm_modify (ipoddb_t *itunesdb, int tihm_num, dohm_t *dohm);
 /* eq is an integer specifier from TunesEQPresets */
 int  db_song_modify_eq(ipoddb_t *itunesdb, u_int32_t tihm_num, int eq);
 int  db_song_list (ipoddb_t *itunesdb, db_list_t **head);
 void db_song_list_free (db_list_t **head);
+int  db_song_list_array (ipoddb_t *itunesdb, db_array_t *songs);
+void db_song_list_array_free (db_array_t *songs);
+int  db_song_list_sorted (ipoddb_t *itunesdb, int sort_by, int offset, int limit, db_array_t *songs);
 int  db_song_hide (ipoddb_t *itunesdb, u_int32_t tihm_num);
 int  db_song_unhide (ipoddb_t *itunesdb, u_int32_t tihm_num);
 
+int       db_track_cursor_open (ipoddb_t *itunesdb, db_track_cursor_t *cursor);
+int       db_track_cursor_next (db_track_cursor_t *cursor);
+u_int32_t db_track_cursor_get_u32 (db_track_cursor_t *cursor, int field);
+int       db_track_cursor_get_string (db_track_cursor_t *cursor, int dohm_type, char *buf, size_t buf_len);
+
+int  db_song_list_fields (ipoddb_t *itunesdb, u_int64_t mask, db_track_fields_t **tracks);
+void db_song_list_fields_free (db_track_fields_t **tracks);
+
 /* itunesdb2/image_list.c */
 int  db_photo_add (ipoddb_t *artworkdb, u_int8_t *image_data, size_t image_size, u_int64_t id);
+int  db_photo_add_batch (ipoddb_t *artworkdb, u_int8_t *image_data[], size_t image_sizes[], u_int64_t ids[],
+			 int num_images, int results[]);
+int  db_photo_queue (ipoddb_t *artworkdb, u_int8_t *image_data, size_t image_size, u_int64_t id);
+int  db_photo_flush (ipoddb_t *artworkdb);
 int  db_photo_list (ipoddb_t *artworkdb, db_list_t **head);
 void db_photo_list_free (db_list_t **head);
+int  db_photo_list_array (ipoddb_t *artworkdb, db_array_t *photos);
+void db_photo_list_array_free (db_array_t *photos);
 
 int    db_set_debug (ipoddb_t *itunesdb, int level, FILE *out);
 
+/* defer size updates (and index maintenance) while making many changes */
+int    db_begin_batch (ipoddb_t *ipod_db);
+int    db_commit_batch (ipoddb_t *ipod_db);
+
+/* share identical strings between the songs returned by the song list functions */
+int    db_string_pool_enable (ipoddb_t *itunesdb);
+
 /* make sure all the values contained in the tihm are correct, there is currently no
    checks so you could screw up a working song entry */
 int    db_song_modify (ipoddb_t *itunesdb, int tihm_num, tihm_t *tihm);
@@ -282,6 +397,10 @@ int db_playlist_rename      (ipoddb_t *itunesdb, int playlist, int data_section,
 int db_playlist_delete      (ipoddb_t *itunesdb, int playlist, int data_section);
 int db_playlist_tihm_add    (ipoddb_t *itunesdb, int playlist, int data_section, int tihm_num);
 int db_playlist_tihm_remove (ipoddb_t *itunesdb, int playlist, int data_section, int tihm_num);
+int db_playlist_tihm_add_many    (ipoddb_t *itunesdb, int playlist, int data_section, int tihm_nums[],
+				  int num_tihms);
+int db_playlist_tihm_remove_many (ipoddb_t *itunesdb, int playlist, int data_section, int tihm_nums[],
+				  int num_tihms);
 int db_playlist_clear       (ipoddb_t *itunesdb, int playlist, int data_section);
 int db_playlist_fill        (ipoddb_t *itunesdb, int playlist, int data_section);
 int db_playlist_remove_all  (ipoddb_t *itunesdb, int tihm_num);
@@ -303,6 +422,9 @@ int db_playlist_column_list_shown (ipoddb_t *itunesdb, int playlist, int data_se
 int db_playlist_list (ipoddb_t *itunesdb, db_list_t **head, int data_section);
 int db_playlist_song_list (ipoddb_t *itunesdb, int playlist, db_list_t **head);
 int db_playlist_video_list (ipoddb_t *itunesdb, int playlist, db_list_t **head);
+int db_playlist_track_list (ipoddb_t *itunesdb, int playlist, db_list_t **head, int data_section);
+int db_playlist_list_array (ipoddb_t *itunesdb, db_array_t *playlists, int data_section);
+int db_playlist_track_list_array (ipoddb_t *itunesdb, int playlist, db_array_t *tracks, int data_section);
 
 int db_album_number       (ipoddb_t *photodb);
 int db_album_list         (ipoddb_t *photodb, db_list_t **head);
@@ -320,6 +442,7 @@ void inhm_free (inhm_t *inhm);
 void db_free   (ipoddb_t *itunesdb);
 
 void db_playlist_list_free (db_list_t **head);
+void db_playlist_list_array_free (db_array_t *playlists);
 void db_album_list_free (db_list_t **head);
 void db_playlist_song_list_free (db_list_t **head);
 
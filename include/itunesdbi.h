@@ -46,6 +46,12 @@
 #include <wand/magick_wand.h>
 #endif
 
+/* artwork is decoded with ImageMagick or (without it) libjpeg and libpng */
+#if defined(HAVE_LIBWAND) || (defined(HAVE_LIBJPEG) && defined(HAVE_JPEGLIB_H)) || \
+  (defined(HAVE_LIBPNG) && defined(HAVE_PNG_H))
+#define HAVE_ARTWORK 1
+#endif
+
 #include "itunesdb.h"
 
 void db_log (ipoddb_t *itunesdb, int error, char *format, ...);
@@ -458,6 +464,16 @@ typedef struct tree_node {
   
   /* Only affects dohm entries containing unicode string. */
   int string_header_size;
+
+  /* size of this sub-tree is out of date (only set inside a batch) */
+  int dirty;
+  /* root node only: number of open batches (see db_begin_batch) */
+  int batch_depth;
+
+  /* incremented every time a node is attached to or removed from this sub-tree */
+  unsigned int generation;
+  /* track list (dshm 1) only: generation the master playlist indices were built from */
+  unsigned int indices_generation;
 } tree_node_t;
 
 /* Macro definitions */
@@ -603,17 +619,22 @@ void db_free_tree (tree_node_t *ptr);
 int db_attach    (tree_node_t *parent, tree_node_t *new_child);
 int db_attach_at (tree_node_t *parent, tree_node_t *new_child, int index);
 int db_detach    (tree_node_t *parent, int child_num, tree_node_t **entry);
+int db_attach_many (tree_node_t *parent, tree_node_t **new_children, int num_children);
+int db_remove_children (tree_node_t *parent, int first, int (*match)(tree_node_t *, void *),
+			void *arg);
+void db_batch_flush (tree_node_t *root);
 int db_node_allocate (tree_node_t **entry, unsigned long type, size_t size, int subtree);
 
 /* tihm.c */
 int db_tihm_search (tree_node_t *entry, u_int32_t tihm_num);
 int db_tihm_create (tree_node_t **entry, tihm_t *tihm, int flags);
-int db_tihm_fill (tree_node_t *tihm_header, tihm_t *tihm);
+int db_tihm_fill (tree_node_t *tihm_header, tihm_t *tihm, struct string_pool *strings);
+u_int32_t db_tihm_get_u32 (tree_node_t *tihm_header, int field);
 int db_tihm_retrieve (ipoddb_t *itunesdb, tree_node_t **entry, tree_node_t **parent, int tihm_num);
 int db_tihm_get_sorted_indices (ipoddb_t *itunesdb, int sort_by, u_int32_t **indices, u_int32_t *num_indices);
 
 tihm_t *tihm_create (tihm_t *tihm, char *filename, char *path, int num);
-int tihm_fill_from_file (tihm_t *tihm, char *path, char *ipod_path, int stars, int tihm_num);
+int tihm_fill_from_file (tihm_t *tihm, char *path, char *ipod_path, int stars, int tihm_num, int flags);
 void    tihm_free (tihm_t *tihm);
 
 
@@ -649,11 +670,13 @@ void    dohm_free       (dohm_t *dohm, int num_dohm);
 int db_dohm_retrieve (tree_node_t *entry, tree_node_t **dohm_header, int dohm_type);
 int db_dohm_compare (tree_node_t *dohm_header1, tree_node_t *dohm_header2);
 int db_dohm_get_string (tree_node_t *dohm_header, u_int8_t **str);
-int db_dohm_fill (tree_node_t *entry, dohm_t **dohms);
+int db_dohm_get_string_buf (tree_node_t *dohm_header, u_int8_t *buf, size_t buf_len);
+int db_dohm_fill (tree_node_t *entry, dohm_t **dohms, struct string_pool *strings);
 int db_dohm_create_generic (tree_node_t **entry, size_t size, int type);
 int db_dohm_create_pihm (tree_node_t **entry, int order);
 int db_dohm_create_eq (tree_node_t **entry, u_int8_t eq);
 int db_dohm_index_create (tree_node_t **entry, int sort_by, int num_tracks, u_int32_t tracks[]);
+int db_dohm_index_type (int sort_by);
 int db_dohm_create (tree_node_t **entry, dohm_t dohm, int string_header_size, int flags);
 
 /* Operations on a wierd dohm */
@@ -666,18 +689,56 @@ int db_dohm_itunes_hide (tree_node_t *entry, int column_id);
 int db_dshm_retrieve (ipoddb_t *itunesdb, tree_node_t **dshm_header, int index);
 int db_dshm_add (ipoddb_t *ipod_db, u_int32_t list_type, int index);
 
+/* string_pool.c */
+struct string_pool *db_string_pool_create (void);
+u_int8_t *db_string_pool_intern (struct string_pool *pool, u_int8_t *raw, int raw_length,
+				 char *encoding);
+void db_string_pool_free (struct string_pool *pool);
+
 /* unicode.c */
 void libupod_convstr (void **dst, size_t *dst_len, void *src, size_t src_len,
 		      char *src_encoding, char *dst_encoding);
 #define to_utf8(dst, src, src_len, src_encoding) libupod_convstr((void **)dst, NULL, (void *)src, src_len, src_encoding, "UTF-8")
+size_t libupod_to_utf8_buf (u_int8_t *dst, size_t dst_size, void *src, size_t src_len,
+			    char *src_encoding);
 
 void to_unicode_hack (u_int16_t **dst, size_t *dst_len, u_int8_t *src,
 		      size_t src_len, char *src_encoding);
 
 
-/* mp3.c/mp4.c */
-int mp3_fill_tihm (char *, tihm_t *);
-int mp4_fill_tihm (char *, tihm_t *);
+/* probe.c */
+/* number of bytes at the start of a media file that are read when it is opened */
+#define MEDIA_HEAD_SIZE 65536
+
+enum media_type {
+  MEDIA_UNKNOWN = 0,
+  MEDIA_MPEG,
+  MEDIA_MP4,
+  MEDIA_RIFF,
+  MEDIA_AIFF
+};
+
+/* a media file opened for probing. every parser shares the handle and head */
+struct media_file {
+  char *path;
+  FILE *fh;
+  struct stat statinfo;
+
+  int type; /* enum media_type */
+
+  u_int8_t *head;
+  size_t head_length;
+};
+
+int media_open (char *path, struct media_file *media);
+size_t media_read (struct media_file *media, off_t offset, void *buffer, size_t length);
+void media_close (struct media_file *media);
+int media_fill_tihm (char *path, tihm_t *tihm, int flags);
+
+/* mp3.c/mp4.c/pcm.c */
+int mp3_fill_tihm (struct media_file *media, tihm_t *tihm, int flags);
+int mp4_fill_tihm (struct media_file *media, tihm_t *tihm);
+int pcm_fill_tihm (struct media_file *media, tihm_t *tihm);
 
 #if defined(MP3_DEBUG)
 void mp3_debug (char *, ...);
@@ -686,32 +747,110 @@ void mp3_debug (char *, ...);
 #endif
 
 /* id3.c */
-int get_id3_info (FILE *fd, char *file_name, tihm_t *tihm);
+/* id3v1 tag and Lyrics3 v2.00 block at the end of an mp3 file */
+struct id3_trailer {
+  int has_v1;
+  u_int8_t v1[128];
+
+  /* bytes used by the trailing tags */
+  int size;
+};
+
+int id3_read_trailer (struct media_file *media, struct id3_trailer *trailer);
+int id3_parse_tags (struct media_file *media, struct id3_trailer *trailer, tihm_t *tihm);
 
 /* playlist.c */
 int db_playlist_retrieve (ipoddb_t *, db_plhm_t **, tree_node_t **, int, int, tree_node_t **);
 int db_playlist_strip_indices (ipoddb_t *itunesdb);
 int db_playlist_add_indices (ipoddb_t *itunesdb);
+int db_playlist_indices_stale (ipoddb_t *itunesdb);
+int db_playlist_get_index (ipoddb_t *itunesdb, int sort_by, u_int32_t **tracks);
 int db_playlist_create_podcast (ipoddb_t *itunesdb, char *name, int data_section);
+int db_playlist_tihm_append (ipoddb_t *itunesdb, tree_node_t *pyhm_header, u_int32_t tihm_nums[],
+			     int num_tihms);
+int db_playlist_purge_tihms (ipoddb_t *itunesdb, u_int32_t *tihm_nums, int num_tihms);
+
+/* artwork.c */
+#if defined(HAVE_ARTWORK)
+/* images larger than this in either dimension are not decoded */
+#define UPOD_IMAGE_MAX_DIMENSION 8192
+
+/* a decoded image. pixels is packed 8-bit RGB */
+struct upod_image {
+  int width, height;
+  u_int8_t *pixels;
+#if defined(HAVE_LIBWAND)
+  MagickWand *magick_wand; /* pixels is only filled by upod_image_pixels */
+#endif
+};
+
+int upod_image_decode (struct upod_image *image, u_int8_t *data, size_t length, int box_width,
+		       int box_height);
+int upod_image_probe (u_int8_t *data, size_t length, int box_width, int box_height);
+int upod_image_copy (struct upod_image *dst, struct upod_image *src);
+int upod_image_resize (struct upod_image *image, int width, int height);
+int upod_image_border (struct upod_image *image, int border_width, int border_height);
+u_int8_t *upod_image_pixels (struct upod_image *image);
+void upod_image_free (struct upod_image *image);
 
 /* inhm.c */
-#if defined(HAVE_LIBWAND)
-int db_inhm_create (tree_node_t **entry, int file_id, char *file_name,
-		    char *rel_mac_path, MagickWand *magick_wand);
+int db_inhm_create (tree_node_t **entry, ipoddb_t *photodb, int file_id, char *rel_mac_path,
+		    struct upod_image *image, off_t offset);
 #endif
 
+/* image_list.c */
+/* most thumbnails a device needs for one image */
+#define THUMB_MAX_SIZES 8
+
+int db_thumb_add (ipoddb_t *photodb, int iihm_identifier, unsigned char *image_data,
+		  size_t image_size, int file_id);
+int db_thumb_add_sizes (ipoddb_t *photodb, int iihm_identifier, unsigned char *image_data,
+			size_t image_size, int file_ids[], int num_file_ids);
+int db_thumb_add_artwork_photo (ipoddb_t *photodb, int iihm_identifier, unsigned char *image_data,
+				size_t image_size);
+int db_thumb_add_artwork_nano (ipoddb_t *photodb, int iihm_identifier, unsigned char *image_data,
+			       size_t image_size);
+int db_thumb_add_artwork_video (ipoddb_t *photodb, int iihm_identifier, unsigned char *image_data,
+				size_t image_size);
+void db_photo_queue_free (ipoddb_t *photodb);
+
 /* iihm.c */
 int db_iihm_create (tree_node_t **entry, int identifier, u_int64_t id);
 int db_iihm_search (tree_node_t *entry, u_int32_t iihm_identifier);
 int db_iihm_retrieve (ipoddb_t *photodb, tree_node_t **entry,
                       tree_node_t **parent, int iihm_identifier);
 
+/* ithmb.c */
+int db_ithmb_open (ipoddb_t *photodb);
+int db_ithmb_reserve (ipoddb_t *photodb, int file_id, size_t length, off_t *offset);
+int db_ithmb_write_at (ipoddb_t *photodb, int file_id, u_int8_t *data, size_t length, off_t offset);
+int db_ithmb_write (ipoddb_t *photodb, int file_id, u_int8_t *data, size_t length, off_t *offset);
+off_t db_ithmb_size (ipoddb_t *photodb, int file_id);
+int db_ithmb_flush (ipoddb_t *photodb);
+void db_ithmb_close (ipoddb_t *photodb);
+
 /* fihm.c */
 int db_fihm_create (tree_node_t **entry, unsigned int file_id);
-int db_fihm_register (ipoddb_t *photodb, char *file_name, unsigned long file_id);
+int db_fihm_register (ipoddb_t *photodb, unsigned long file_id);
 
 
 /* crc */
+struct crc32_context {
+  u_int32_t crc;
+};
+
+struct crc64_context {
+  u_int64_t crc;
+};
+
+void upod_crc32_init (struct crc32_context *context);
+void upod_crc32_update (struct crc32_context *context, u_int8_t *buf, size_t length);
+u_int32_t upod_crc32_final (struct crc32_context *context);
+
+void upod_crc64_init (struct crc64_context *context);
+void upod_crc64_update (struct crc64_context *context, u_int8_t *buf, size_t length);
+u_int64_t upod_crc64_final (struct crc64_context *context);
+
 u_int32_t upod_crc32 (u_int8_t *buf, size_t length);
 u_int64_t upod_crc64 (u_int8_t *buf, size_t length);
 
@@ -721,6 +860,25 @@ int sysinfo_read (ipod_t *ipod, char *filename);
 /* db_lookup.c */
 int db_lookup_image (ipoddb_t *photodb, u_int64_t id);
 
+struct path_index {
+  int num_entries;
+
+  struct path_index_entry {
+    u_int8_t *path;
+    u_int32_t tihm_num;
+  } *entries;
+};
+
+int  db_path_index_build (ipoddb_t *itunesdb, struct path_index *index);
+int  db_path_index_lookup (struct path_index *index, u_int8_t *path);
+void db_path_index_free (struct path_index *index);
+
+/* thread_pool.c */
+typedef void (*upod_work_fn) (void *arg, int index);
+
+int upod_thread_count (int requested);
+int upod_parallel_for (int num_threads, int count, upod_work_fn func, void *arg);
+
 
 int get_uint24 (unsigned char *buf, int block);
 
@@ -0,0 +1,627 @@
+/**
+ *   (c) 2007 Nathan Hjelm <hjelmn@users.sourceforge.net>
+ *   v0.1.0 artwork.c
+ *
+ *   Decodes and scales artwork for thumbnails. ImageMagick (libWand) is used
+ *   when it is available. Otherwise jpeg and png images are decoded with
+ *   libjpeg and libpng and scaled with a box (reduce) or bilinear (enlarge)
+ *   filter.
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the Lesser GNU Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the Lesser GNU Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ **/
+
+#include "itunesdbi.h"
+
+#if defined(HAVE_ARTWORK)
+
+/*
+  image_size (internal):
+
+  Returns the size in bytes of a packed RGB image or 0 if either dimension is
+  out of range (less than 1 or more than UPOD_IMAGE_MAX_DIMENSION) or the
+  size does not fit in a size_t.
+*/
+static size_t image_size (int width, int height) {
+  if (width < 1 || height < 1 || width > UPOD_IMAGE_MAX_DIMENSION ||
+      height > UPOD_IMAGE_MAX_DIMENSION)
+    return 0;
+
+  if ((size_t)width > (size_t)-1 / 3 / (size_t)height)
+    return 0;
+
+  return (size_t)width * (size_t)height * 3;
+}
+
+#if defined(HAVE_LIBWAND)
+
+/* older versions of ImageMagick only have the (now deprecated) get function */
+#if !defined(HAVE_MAGICKEXPORTIMAGEPIXELS)
+#define MagickExportImagePixels MagickGetImagePixels
+#endif
+
+/* the size hint is not used. ImageMagick always decodes the whole image */
+int upod_image_decode (struct upod_image *image, u_int8_t *data, size_t length, int box_width,
+		       int box_height) {
+  memset (image, 0, sizeof (struct upod_image));
+
+  image->magick_wand = NewMagickWand ();
+
+  if (MagickReadImageBlob (image->magick_wand, data, length) == MagickFalse) {
+    upod_image_free (image);
+
+    return -1;
+  }
+
+  if (image_size (MagickGetImageWidth (image->magick_wand),
+		  MagickGetImageHeight (image->magick_wand)) == 0) {
+    upod_image_free (image);
+
+    return -1;
+  }
+
+  image->width  = MagickGetImageWidth (image->magick_wand);
+  image->height = MagickGetImageHeight (image->magick_wand);
+
+  return 0;
+}
+
+/* ImageMagick has no header-only read in every version. decode the whole image */
+int upod_image_probe (u_int8_t *data, size_t length, int box_width, int box_height) {
+  struct upod_image image;
+  int ret;
+
+  if ((ret = upod_image_decode (&image, data, length, box_width, box_height)) == 0)
+    upod_image_free (&image);
+
+  return ret;
+}
+
+int upod_image_copy (struct upod_image *dst, struct upod_image *src) {
+  memset (dst, 0, sizeof (struct upod_image));
+
+  if ((dst->magick_wand = CloneMagickWand (src->magick_wand)) == NULL)
+    return -ENOMEM;
+
+  dst->width  = src->width;
+  dst->height = src->height;
+
+  return 0;
+}
+
+int upod_image_resize (struct upod_image *image, int width, int height) {
+  if (MagickResizeImage (image->magick_wand, width, height, LanczosFilter, 0.9) == MagickFalse)
+    return -1;
+
+  /* any exported pixels are stale */
+  free (image->pixels);
+  image->pixels = NULL;
+
+  image->width  = width;
+  image->height = height;
+
+  return 0;
+}
+
+int upod_image_border (struct upod_image *image, int border_width, int border_height) {
+  PixelWand *pixel_wand;
+  MagickBooleanType ret;
+
+  pixel_wand = NewPixelWand ();
+  PixelSetColor (pixel_wand, "black");
+
+  ret = MagickBorderImage (image->magick_wand, pixel_wand, border_width, border_height);
+
+  DestroyPixelWand (pixel_wand);
+
+  if (ret == MagickFalse)
+    return -1;
+
+  free (image->pixels);
+  image->pixels = NULL;
+
+  image->width  += 2 * border_width;
+  image->height += 2 * border_height;
+
+  return 0;
+}
+
+u_int8_t *upod_image_pixels (struct upod_image *image) {
+  size_t size;
+
+  if (image->pixels)
+    return image->pixels;
+
+  if ((size = image_size (image->width, image->height)) == 0 ||
+      (image->pixels = (u_int8_t *) malloc (size)) == NULL)
+    return NULL;
+
+  if (MagickExportImagePixels (image->magick_wand, 0, 0, image->width, image->height, "RGB",
+			       CharPixel, image->pixels) == MagickFalse) {
+    free (image->pixels);
+    image->pixels = NULL;
+  }
+
+  return image->pixels;
+}
+
+void upod_image_free (struct upod_image *image) {
+  if (image->magick_wand)
+    DestroyMagickWand (image->magick_wand);
+
+  free (image->pixels);
+
+  memset (image, 0, sizeof (struct upod_image));
+}
+
+#else /* !HAVE_LIBWAND */
+
+#include <setjmp.h>
+
+#if defined(HAVE_LIBJPEG) && defined(HAVE_JPEGLIB_H)
+#define ARTWORK_JPEG 1
+#include <jpeglib.h>
+#endif
+
+#if defined(HAVE_LIBPNG) && defined(HAVE_PNG_H)
+#define ARTWORK_PNG 1
+#include <png.h>
+#endif
+
+#if defined(ARTWORK_JPEG)
+struct jpeg_error {
+  struct jpeg_error_mgr pub;
+  jmp_buf env;
+};
+
+static void jpeg_error_exit (j_common_ptr cinfo) {
+  struct jpeg_error *error = (struct jpeg_error *)cinfo->err;
+
+  longjmp (error->env, 1);
+}
+
+static void jpeg_output_message (j_common_ptr cinfo) {
+  char buffer[JMSG_LENGTH_MAX];
+
+  cinfo->err->format_message (cinfo, buffer);
+  mp3_debug ("artwork.c: libjpeg: %s\n", buffer);
+}
+
+/* the whole image is in memory so the source manager only has to hand it over */
+static void jpeg_source_nop (j_decompress_ptr cinfo) {
+  (void)cinfo;
+}
+
+static boolean jpeg_source_fill (j_decompress_ptr cinfo) {
+  static const JOCTET eoi[2] = {0xff, JPEG_EOI};
+
+  /* truncated image. end it so libjpeg can finish with a warning */
+  cinfo->src->next_input_byte = eoi;
+  cinfo->src->bytes_in_buffer = 2;
+
+  return TRUE;
+}
+
+static void jpeg_source_skip (j_decompress_ptr cinfo, long num_bytes) {
+  if (num_bytes <= 0)
+    return;
+
+  if ((size_t)num_bytes > cinfo->src->bytes_in_buffer)
+    num_bytes = cinfo->src->bytes_in_buffer;
+
+  cinfo->src->next_input_byte += num_bytes;
+  cinfo->src->bytes_in_buffer -= num_bytes;
+}
+
+/*
+  jpeg_decode (internal):
+
+  Decodes a jpeg to packed RGB. libjpeg can reduce an image by 1/2, 1/4 or
+  1/8 while decoding it. The largest reduction that leaves the image at
+  least as large as the box it will be fit into is used, so most cover art
+  is never decoded at full size. If header_only is set only the header is
+  read and checked.
+*/
+static int jpeg_decode (struct upod_image *image, u_int8_t *data, size_t length, int box_width,
+			int box_height, int header_only) {
+  struct jpeg_decompress_struct cinfo;
+  struct jpeg_source_mgr source;
+  struct jpeg_error error;
+  JSAMPROW row;
+  size_t size;
+  int denom;
+
+  cinfo.err = jpeg_std_error (&error.pub);
+  error.pub.error_exit     = jpeg_error_exit;
+  error.pub.output_message = jpeg_output_message;
+
+  if (setjmp (error.env)) {
+    jpeg_destroy_decompress (&cinfo);
+    free (image->pixels);
+    image->pixels = NULL;
+
+    return -1;
+  }
+
+  jpeg_create_decompress (&cinfo);
+
+  source.next_input_byte   = data;
+  source.bytes_in_buffer   = length;
+  source.init_source       = jpeg_source_nop;
+  source.fill_input_buffer = jpeg_source_fill;
+  source.skip_input_data   = jpeg_source_skip;
+  source.resync_to_restart = jpeg_resync_to_restart;
+  source.term_source       = jpeg_source_nop;
+  cinfo.src = &source;
+
+  (void)jpeg_read_header (&cinfo, TRUE);
+
+  cinfo.out_color_space = JCS_RGB;
+  cinfo.scale_num       = 1;
+
+  for (denom = 8 ; denom >= 1 ; denom /= 2) {
+    cinfo.scale_denom = denom;
+    jpeg_calc_output_dimensions (&cinfo);
+
+    if (denom == 1 || (int)cinfo.output_width >= box_width || (int)cinfo.output_height >= box_height)
+      break;
+  }
+
+  mp3_debug ("artwork.c/jpeg_decode: %ix%i decoded at 1/%i\n", cinfo.image_width, cinfo.image_height,
+	     denom);
+
+  if (cinfo.output_width > UPOD_IMAGE_MAX_DIMENSION || cinfo.output_height > UPOD_IMAGE_MAX_DIMENSION) {
+    mp3_debug ("artwork.c/jpeg_decode: image is too large\n");
+    jpeg_destroy_decompress (&cinfo);
+
+    return -1;
+  }
+
+  if (header_only) {
+    jpeg_destroy_decompress (&cinfo);
+
+    return 0;
+  }
+
+  (void)jpeg_start_decompress (&cinfo);
+
+  image->width  = cinfo.output_width;
+  image->height = cinfo.output_height;
+
+  if ((size = image_size (image->width, image->height)) == 0) {
+    jpeg_destroy_decompress (&cinfo);
+
+    return -1;
+  }
+
+  if ((image->pixels = (u_int8_t *) malloc (size)) == NULL) {
+    jpeg_destroy_decompress (&cinfo);
+
+    return -ENOMEM;
+  }
+
+  while (cinfo.output_scanline < cinfo.output_height) {
+    row = image->pixels + (size_t)cinfo.output_scanline * image->width * 3;
+    (void)jpeg_read_scanlines (&cinfo, &row, 1);
+  }
+
+  (void)jpeg_finish_decompress (&cinfo);
+  jpeg_destroy_decompress (&cinfo);
+
+  return 0;
+}
+#endif
+
+#if defined(ARTWORK_PNG)
+struct png_source {
+  u_int8_t *data;
+  size_t length;
+};
+
+static void png_source_read (png_structp png_ptr, png_bytep buffer, png_size_t length) {
+  struct png_source *source = (struct png_source *) png_get_io_ptr (png_ptr);
+
+  if (length > source->length)
+    png_error (png_ptr, "truncated image");
+
+  memcpy (buffer, source->data, length);
+
+  source->data   += length;
+  source->length -= length;
+}
+
+/* decodes a png to packed RGB. alpha is dropped. if header_only is set only the header is read */
+static int png_decode (struct upod_image *image, u_int8_t *data, size_t length, int header_only) {
+  png_structp png_ptr;
+  png_infop info_ptr;
+  png_bytep *volatile rows = NULL;
+  struct png_source source;
+  size_t size;
+  int i;
+
+  if ((png_ptr = png_create_read_struct (PNG_LIBPNG_VER_STRING, NULL, NULL, NULL)) == NULL)
+    return -ENOMEM;
+
+  if ((info_ptr = png_create_info_struct (png_ptr)) == NULL) {
+    png_destroy_read_struct (&png_ptr, NULL, NULL);
+
+    return -ENOMEM;
+  }
+
+  if (setjmp (png_jmpbuf (png_ptr))) {
+    png_destroy_read_struct (&png_ptr, &info_ptr, NULL);
+    free (rows);
+    free (image->pixels);
+    image->pixels = NULL;
+
+    return -1;
+  }
+
+  source.data   = data;
+  source.length = length;
+  png_set_read_fn (png_ptr, &source, png_source_read);
+
+  /* libpng rejects larger images in png_read_info */
+  png_set_user_limits (png_ptr, UPOD_IMAGE_MAX_DIMENSION, UPOD_IMAGE_MAX_DIMENSION);
+
+  png_read_info (png_ptr, info_ptr);
+
+  if (header_only) {
+    png_destroy_read_struct (&png_ptr, &info_ptr, NULL);
+
+    return 0;
+  }
+
+  /* reduce everything to 8-bit RGB */
+  png_set_strip_16 (png_ptr);
+  png_set_strip_alpha (png_ptr);
+  png_set_packing (png_ptr);
+  png_set_palette_to_rgb (png_ptr);
+  png_set_gray_to_rgb (png_ptr);
+  if (png_get_bit_depth (png_ptr, info_ptr) < 8 &&
+      png_get_color_type (png_ptr, info_ptr) == PNG_COLOR_TYPE_GRAY)
+    png_set_expand_gray_1_2_4_to_8 (png_ptr);
+  (void)png_set_interlace_handling (png_ptr);
+
+  png_read_update_info (png_ptr, info_ptr);
+
+  image->width  = png_get_image_width (png_ptr, info_ptr);
+  image->height = png_get_image_height (png_ptr, info_ptr);
+
+  if ((size = image_size (image->width, image->height)) == 0 ||
+      png_get_rowbytes (png_ptr, info_ptr) != (size_t)image->width * 3)
+    png_error (png_ptr, "unsupported image size");
+
+  image->pixels = (u_int8_t *) malloc (size);
+  rows          = (png_bytep *) calloc (image->height, sizeof (png_bytep));
+  if (image->pixels == NULL || rows == NULL)
+    png_error (png_ptr, "out of memory");
+
+  for (i = 0 ; i < image->height ; i++)
+    rows[i] = image->pixels + (size_t)i * image->width * 3;
+
+  png_read_image (png_ptr, rows);
+  png_read_end (png_ptr, NULL);
+
+  png_destroy_read_struct (&png_ptr, &info_ptr, NULL);
+  free (rows);
+
+  return 0;
+}
+#endif
+
+/*
+  upod_image_decode:
+
+  Decodes an encoded (jpeg or png) image.
+
+  Arguments:
+   image      - decoded image
+   data       - encoded image
+   length     - length of data
+   box_width  - the image will be scaled to fit in a box this size. jpegs
+   box_height   are decoded at the smallest size that still covers it
+
+  Returns:
+   < 0 on error (or unsupported format)
+     0 on success
+*/
+static int image_decode (struct upod_image *image, u_int8_t *data, size_t length, int box_width,
+			 int box_height, int header_only) {
+  memset (image, 0, sizeof (struct upod_image));
+
+#if defined(ARTWORK_JPEG)
+  if (length > 2 && data[0] == 0xff && data[1] == 0xd8)
+    return jpeg_decode (image, data, length, box_width, box_height, header_only);
+#endif
+
+#if defined(ARTWORK_PNG)
+  if (length > 8 && memcmp (data, "\211PNG\r\n\032\n", 8) == 0)
+    return png_decode (image, data, length, header_only);
+#endif
+
+  mp3_debug ("artwork.c/upod_image_decode: unsupported image format\n");
+
+  return -1;
+}
+
+int upod_image_decode (struct upod_image *image, u_int8_t *data, size_t length, int box_width,
+		       int box_height) {
+  return image_decode (image, data, length, box_width, box_height, 0);
+}
+
+/*
+  upod_image_probe:
+
+  Reads the header of an encoded image without decoding it. An image that
+  passes can still fail to decode if its data is damaged.
+
+  Returns:
+   < 0 if the image is not supported (see upod_image_decode)
+     0 otherwise
+*/
+int upod_image_probe (u_int8_t *data, size_t length, int box_width, int box_height) {
+  struct upod_image image;
+
+  return image_decode (&image, data, length, box_width, box_height, 1);
+}
+
+int upod_image_copy (struct upod_image *dst, struct upod_image *src) {
+  size_t size = image_size (src->width, src->height);
+
+  memset (dst, 0, sizeof (struct upod_image));
+
+  if (size == 0)
+    return -EINVAL;
+
+  if ((dst->pixels = (u_int8_t *) malloc (size)) == NULL)
+    return -errno;
+
+  memcpy (dst->pixels, src->pixels, size);
+
+  dst->width  = src->width;
+  dst->height = src->height;
+
+  return 0;
+}
+
+/*
+  resample_line (internal):
+
+  Resamples count RGB pixels from src (stride bytes apart) into new_count
+  pixels in dst (dst_stride apart). Lines are reduced by averaging the
+  source pixels under each destination pixel and enlarged by linear
+  interpolation.
+*/
+static void resample_line (u_int8_t *src, int count, int src_stride, u_int8_t *dst, int new_count,
+			   int dst_stride) {
+  u_int32_t sum[3];
+  int i, j, c, first, last, position, weight;
+
+  if (new_count <= count) {
+    for (i = 0 ; i < new_count ; i++, dst += dst_stride) {
+      first = i * count / new_count;
+      last  = (i + 1) * count / new_count;
+
+      sum[0] = sum[1] = sum[2] = 0;
+
+      for (j = first ; j < last ; j++)
+	for (c = 0 ; c < 3 ; c++)
+	  sum[c] += src[j * src_stride + c];
+
+      for (c = 0 ; c < 3 ; c++)
+	dst[c] = (sum[c] + (last - first) / 2) / (last - first);
+    }
+  } else {
+    for (i = 0 ; i < new_count ; i++, dst += dst_stride) {
+      /* source position of the pixel center in 16.16 fixed point */
+      position = (int)(((2 * i + 1) * (int64_t)count << 16) / (2 * new_count)) - 0x8000;
+      if (position < 0)
+	position = 0;
+
+      j      = position >> 16;
+      weight = position & 0xffff;
+
+      if (j >= count - 1) {
+	j      = count - 1;
+	weight = 0;
+      }
+
+      for (c = 0 ; c < 3 ; c++)
+	dst[c] = (src[j * src_stride + c] * (0x10000 - weight) +
+		  (weight ? src[(j + 1) * src_stride + c] * weight : 0) + 0x8000) >> 16;
+    }
+  }
+}
+
+int upod_image_resize (struct upod_image *image, int width, int height) {
+  u_int8_t *rows, *pixels;
+  size_t rows_size, size;
+  int i;
+
+  if ((rows_size = image_size (width, image->height)) == 0 || (size = image_size (width, height)) == 0)
+    return -EINVAL;
+
+  if (width == image->width && height == image->height)
+    return 0;
+
+  /* horizontal then vertical */
+  rows   = (u_int8_t *) malloc (rows_size);
+  pixels = (u_int8_t *) malloc (size);
+  if (rows == NULL || pixels == NULL) {
+    free (rows);
+    free (pixels);
+
+    return -ENOMEM;
+  }
+
+  for (i = 0 ; i < image->height ; i++)
+    resample_line (image->pixels + (size_t)i * image->width * 3, image->width, 3,
+		   rows + (size_t)i * width * 3, width, 3);
+
+  for (i = 0 ; i < width ; i++)
+    resample_line (rows + i * 3, image->height, width * 3, pixels + i * 3, height, width * 3);
+
+  free (rows);
+  free (image->pixels);
+
+  image->pixels = pixels;
+  image->width  = width;
+  image->height = height;
+
+  return 0;
+}
+
+int upod_image_border (struct upod_image *image, int border_width, int border_height) {
+  int width  = image->width + 2 * border_width;
+  int height = image->height + 2 * border_height;
+  u_int8_t *pixels;
+  size_t size;
+  int i;
+
+  if (border_width == 0 && border_height == 0)
+    return 0;
+
+  if (border_width < 0 || border_height < 0 || (size = image_size (width, height)) == 0)
+    return -EINVAL;
+
+  if ((pixels = (u_int8_t *) calloc (size, 1)) == NULL)
+    return -ENOMEM;
+
+  for (i = 0 ; i < image->height ; i++)
+    memcpy (pixels + ((size_t)(i + border_height) * width + border_width) * 3,
+	    image->pixels + (size_t)i * image->width * 3, (size_t)image->width * 3);
+
+  free (image->pixels);
+
+  image->pixels = pixels;
+  image->width  = width;
+  image->height = height;
+
+  return 0;
+}
+
+u_int8_t *upod_image_pixels (struct upod_image *image) {
+  return image->pixels;
+}
+
+void upod_image_free (struct upod_image *image) {
+  free (image->pixels);
+
+  memset (image, 0, sizeof (struct upod_image));
+}
+
+#endif /* HAVE_LIBWAND */
+
+#endif /* HAVE_ARTWORK */
@@ -10,79 +10,1287 @@
 #define CRC32POLY 	0x04C11DB7l
 #define CRC64POLY 	0xd800000000000000ll
 
-static void crc32_init_table(void);
-static void crc64_init_table(void);
+/* the tables are constant so the crc functions can be called from any thread
+   without initialization */
+/* crc32_table[0][i] is the crc of the byte i. crc32_table[k][i] is the crc
+   of the byte i followed by k zero bytes, which lets the update functions
+   consume eight bytes per step (slice-by-8). generated with CRC32POLY */
+static const u_int32_t crc32_table[8][256] = {
+  {
+    0x00000000u, 0x06233697u, 0x05c45641u, 0x03e760d6u, 0x020a97edu, 0x0429a17au,
+    0x07cec1acu, 0x01edf73bu, 0x04152fdau, 0x0236194du, 0x01d1799bu, 0x07f24f0cu,
+    0x061fb837u, 0x003c8ea0u, 0x03dbee76u, 0x05f8d8e1u, 0x01a864dbu, 0x078b524cu,
+    0x046c329au, 0x024f040du, 0x03a2f336u, 0x0581c5a1u, 0x0666a577u, 0x004593e0u,
+    0x05bd4b01u, 0x039e7d96u, 0x00791d40u, 0x065a2bd7u, 0x07b7dcecu, 0x0194ea7bu,
+    0x02738aadu, 0x0450bc3au, 0x0350c9b6u, 0x0573ff21u, 0x06949ff7u, 0x00b7a960u,
+    0x015a5e5bu, 0x077968ccu, 0x049e081au, 0x02bd3e8du, 0x0745e66cu, 0x0166d0fbu,
+    0x0281b02du, 0x04a286bau, 0x054f7181u, 0x036c4716u, 0x008b27c0u, 0x06a81157u,
+    0x02f8ad6du, 0x04db9bfau, 0x073cfb2cu, 0x011fcdbbu, 0x00f23a80u, 0x06d10c17u,
+    0x05366cc1u, 0x03155a56u, 0x06ed82b7u, 0x00ceb420u, 0x0329d4f6u, 0x050ae261u,
+    0x04e7155au, 0x02c423cdu, 0x0123431bu, 0x0700758cu, 0x06a1936cu, 0x0082a5fbu,
+    0x0365c52du, 0x0546f3bau, 0x04ab0481u, 0x02883216u, 0x016f52c0u, 0x074c6457u,
+    0x02b4bcb6u, 0x04978a21u, 0x0770eaf7u, 0x0153dc60u, 0x00be2b5bu, 0x069d1dccu,
+    0x057a7d1au, 0x03594b8du, 0x0709f7b7u, 0x012ac120u, 0x02cda1f6u, 0x04ee9761u,
+    0x0503605au, 0x032056cdu, 0x00c7361bu, 0x06e4008cu, 0x031cd86du, 0x053feefau,
+    0x06d88e2cu, 0x00fbb8bbu, 0x01164f80u, 0x07357917u, 0x04d219c1u, 0x02f12f56u,
+    0x05f15adau, 0x03d26c4du, 0x00350c9bu, 0x06163a0cu, 0x07fbcd37u, 0x01d8fba0u,
+    0x023f9b76u, 0x041cade1u, 0x01e47500u, 0x07c74397u, 0x04202341u, 0x020315d6u,
+    0x03eee2edu, 0x05cdd47au, 0x062ab4acu, 0x0009823bu, 0x04593e01u, 0x027a0896u,
+    0x019d6840u, 0x07be5ed7u, 0x0653a9ecu, 0x00709f7bu, 0x0397ffadu, 0x05b4c93au,
+    0x004c11dbu, 0x066f274cu, 0x0588479au, 0x03ab710du, 0x02468636u, 0x0465b0a1u,
+    0x0782d077u, 0x01a1e6e0u, 0x04c11db7u, 0x02e22b20u, 0x01054bf6u, 0x07267d61u,
+    0x06cb8a5au, 0x00e8bccdu, 0x030fdc1bu, 0x052cea8cu, 0x00d4326du, 0x06f704fau,
+    0x0510642cu, 0x033352bbu, 0x02dea580u, 0x04fd9317u, 0x071af3c1u, 0x0139c556u,
+    0x0569796cu, 0x034a4ffbu, 0x00ad2f2du, 0x068e19bau, 0x0763ee81u, 0x0140d816u,
+    0x02a7b8c0u, 0x04848e57u, 0x017c56b6u, 0x075f6021u, 0x04b800f7u, 0x029b3660u,
+    0x0376c15bu, 0x0555f7ccu, 0x06b2971au, 0x0091a18du, 0x0791d401u, 0x01b2e296u,
+    0x02558240u, 0x0476b4d7u, 0x059b43ecu, 0x03b8757bu, 0x005f15adu, 0x067c233au,
+    0x0384fbdbu, 0x05a7cd4cu, 0x0640ad9au, 0x00639b0du, 0x018e6c36u, 0x07ad5aa1u,
+    0x044a3a77u, 0x02690ce0u, 0x0639b0dau, 0x001a864du, 0x03fde69bu, 0x05ded00cu,
+    0x04332737u, 0x021011a0u, 0x01f77176u, 0x07d447e1u, 0x022c9f00u, 0x040fa997u,
+    0x07e8c941u, 0x01cbffd6u, 0x002608edu, 0x06053e7au, 0x05e25eacu, 0x03c1683bu,
+    0x02608edbu, 0x0443b84cu, 0x07a4d89au, 0x0187ee0du, 0x006a1936u, 0x06492fa1u,
+    0x05ae4f77u, 0x038d79e0u, 0x0675a101u, 0x00569796u, 0x03b1f740u, 0x0592c1d7u,
+    0x047f36ecu, 0x025c007bu, 0x01bb60adu, 0x0798563au, 0x03c8ea00u, 0x05ebdc97u,
+    0x060cbc41u, 0x002f8ad6u, 0x01c27dedu, 0x07e14b7au, 0x04062bacu, 0x02251d3bu,
+    0x07ddc5dau, 0x01fef34du, 0x0219939bu, 0x043aa50cu, 0x05d75237u, 0x03f464a0u,
+    0x00130476u, 0x063032e1u, 0x0130476du, 0x071371fau, 0x04f4112cu, 0x02d727bbu,
+    0x033ad080u, 0x0519e617u, 0x06fe86c1u, 0x00ddb056u, 0x052568b7u, 0x03065e20u,
+    0x00e13ef6u, 0x06c20861u, 0x072fff5au, 0x010cc9cdu, 0x02eba91bu, 0x04c89f8cu,
+    0x009823b6u, 0x06bb1521u, 0x055c75f7u, 0x037f4360u, 0x0292b45bu, 0x04b182ccu,
+    0x0756e21au, 0x0175d48du, 0x048d0c6cu, 0x02ae3afbu, 0x01495a2du, 0x076a6cbau,
+    0x06879b81u, 0x00a4ad16u, 0x0343cdc0u, 0x0560fb57u
+  },
+  {
+    0x00000000u, 0x0482ad61u, 0x008761adu, 0x0405ccccu, 0x010ec35au, 0x058c6e3bu,
+    0x0189a2f7u, 0x050b0f96u, 0x021d86b4u, 0x069f2bd5u, 0x029ae719u, 0x06184a78u,
+    0x031345eeu, 0x0791e88fu, 0x03942443u, 0x07168922u, 0x043b0d68u, 0x00b9a009u,
+    0x04bc6cc5u, 0x003ec1a4u, 0x0535ce32u, 0x01b76353u, 0x05b2af9fu, 0x013002feu,
+    0x06268bdcu, 0x02a426bdu, 0x06a1ea71u, 0x02234710u, 0x07284886u, 0x03aae5e7u,
+    0x07af292bu, 0x032d844au, 0x01f421bfu, 0x05768cdeu, 0x01734012u, 0x05f1ed73u,
+    0x00fae2e5u, 0x04784f84u, 0x007d8348u, 0x04ff2e29u, 0x03e9a70bu, 0x076b0a6au,
+    0x036ec6a6u, 0x07ec6bc7u, 0x02e76451u, 0x0665c930u, 0x026005fcu, 0x06e2a89du,
+    0x05cf2cd7u, 0x014d81b6u, 0x05484d7au, 0x01cae01bu, 0x04c1ef8du, 0x004342ecu,
+    0x04468e20u, 0x00c42341u, 0x07d2aa63u, 0x03500702u, 0x0755cbceu, 0x03d766afu,
+    0x06dc6939u, 0x025ec458u, 0x065b0894u, 0x02d9a5f5u, 0x03e8437eu, 0x076aee1fu,
+    0x036f22d3u, 0x07ed8fb2u, 0x02e68024u, 0x06642d45u, 0x0261e189u, 0x06e34ce8u,
+    0x01f5c5cau, 0x057768abu, 0x0172a467u, 0x05f00906u, 0x00fb0690u, 0x0479abf1u,
+    0x007c673du, 0x04feca5cu, 0x07d34e16u, 0x0351e377u, 0x07542fbbu, 0x03d682dau,
+    0x06dd8d4cu, 0x025f202du, 0x065aece1u, 0x02d84180u, 0x05cec8a2u, 0x014c65c3u,
+    0x0549a90fu, 0x01cb046eu, 0x04c00bf8u, 0x0042a699u, 0x04476a55u, 0x00c5c734u,
+    0x021c62c1u, 0x069ecfa0u, 0x029b036cu, 0x0619ae0du, 0x0312a19bu, 0x07900cfau,
+    0x0395c036u, 0x07176d57u, 0x0001e475u, 0x04834914u, 0x008685d8u, 0x040428b9u,
+    0x010f272fu, 0x058d8a4eu, 0x01884682u, 0x050aebe3u, 0x06276fa9u, 0x02a5c2c8u,
+    0x06a00e04u, 0x0222a365u, 0x0729acf3u, 0x03ab0192u, 0x07aecd5eu, 0x032c603fu,
+    0x043ae91du, 0x00b8447cu, 0x04bd88b0u, 0x003f25d1u, 0x05342a47u, 0x01b68726u,
+    0x05b34beau, 0x0131e68bu, 0x07d086fcu, 0x03522b9du, 0x0757e751u, 0x03d54a30u,
+    0x06de45a6u, 0x025ce8c7u, 0x0659240bu, 0x02db896au, 0x05cd0048u, 0x014fad29u,
+    0x054a61e5u, 0x01c8cc84u, 0x04c3c312u, 0x00416e73u, 0x0444a2bfu, 0x00c60fdeu,
+    0x03eb8b94u, 0x076926f5u, 0x036cea39u, 0x07ee4758u, 0x02e548ceu, 0x0667e5afu,
+    0x02622963u, 0x06e08402u, 0x01f60d20u, 0x0574a041u, 0x01716c8du, 0x05f3c1ecu,
+    0x00f8ce7au, 0x047a631bu, 0x007fafd7u, 0x04fd02b6u, 0x0624a743u, 0x02a60a22u,
+    0x06a3c6eeu, 0x02216b8fu, 0x072a6419u, 0x03a8c978u, 0x07ad05b4u, 0x032fa8d5u,
+    0x043921f7u, 0x00bb8c96u, 0x04be405au, 0x003ced3bu, 0x0537e2adu, 0x01b54fccu,
+    0x05b08300u, 0x01322e61u, 0x021faa2bu, 0x069d074au, 0x0298cb86u, 0x061a66e7u,
+    0x03116971u, 0x0793c410u, 0x039608dcu, 0x0714a5bdu, 0x00022c9fu, 0x048081feu,
+    0x00854d32u, 0x0407e053u, 0x010cefc5u, 0x058e42a4u, 0x018b8e68u, 0x05092309u,
+    0x0438c582u, 0x00ba68e3u, 0x04bfa42fu, 0x003d094eu, 0x053606d8u, 0x01b4abb9u,
+    0x05b16775u, 0x0133ca14u, 0x06254336u, 0x02a7ee57u, 0x06a2229bu, 0x02208ffau,
+    0x072b806cu, 0x03a92d0du, 0x07ace1c1u, 0x032e4ca0u, 0x0003c8eau, 0x0481658bu,
+    0x0084a947u, 0x04060426u, 0x010d0bb0u, 0x058fa6d1u, 0x018a6a1du, 0x0508c77cu,
+    0x021e4e5eu, 0x069ce33fu, 0x02992ff3u, 0x061b8292u, 0x03108d04u, 0x07922065u,
+    0x0397eca9u, 0x071541c8u, 0x05cce43du, 0x014e495cu, 0x054b8590u, 0x01c928f1u,
+    0x04c22767u, 0x00408a06u, 0x044546cau, 0x00c7ebabu, 0x07d16289u, 0x0353cfe8u,
+    0x07560324u, 0x03d4ae45u, 0x06dfa1d3u, 0x025d0cb2u, 0x0658c07eu, 0x02da6d1fu,
+    0x01f7e955u, 0x05754434u, 0x017088f8u, 0x05f22599u, 0x00f92a0fu, 0x047b876eu,
+    0x007e4ba2u, 0x04fce6c3u, 0x03ea6fe1u, 0x0768c280u, 0x036d0e4cu, 0x07efa32du,
+    0x02e4acbbu, 0x066601dau, 0x0263cd16u, 0x06e16077u
+  },
+  {
+    0x00000000u, 0x03d6eee0u, 0x07adddc0u, 0x047b3320u, 0x06d980efu, 0x050f6e0fu,
+    0x01745d2fu, 0x02a2b3cfu, 0x04313ab1u, 0x07e7d451u, 0x039ce771u, 0x004a0991u,
+    0x02e8ba5eu, 0x013e54beu, 0x0545679eu, 0x0693897eu, 0x01e04e0du, 0x0236a0edu,
+    0x064d93cdu, 0x059b7d2du, 0x0739cee2u, 0x04ef2002u, 0x00941322u, 0x0342fdc2u,
+    0x05d174bcu, 0x06079a5cu, 0x027ca97cu, 0x01aa479cu, 0x0308f453u, 0x00de1ab3u,
+    0x04a52993u, 0x0773c773u, 0x03c09c1au, 0x001672fau, 0x046d41dau, 0x07bbaf3au,
+    0x05191cf5u, 0x06cff215u, 0x02b4c135u, 0x01622fd5u, 0x07f1a6abu, 0x0427484bu,
+    0x005c7b6bu, 0x038a958bu, 0x01282644u, 0x02fec8a4u, 0x0685fb84u, 0x05531564u,
+    0x0220d217u, 0x01f63cf7u, 0x058d0fd7u, 0x065be137u, 0x04f952f8u, 0x072fbc18u,
+    0x03548f38u, 0x008261d8u, 0x0611e8a6u, 0x05c70646u, 0x01bc3566u, 0x026adb86u,
+    0x00c86849u, 0x031e86a9u, 0x0765b589u, 0x04b35b69u, 0x07813834u, 0x0457d6d4u,
+    0x002ce5f4u, 0x03fa0b14u, 0x0158b8dbu, 0x028e563bu, 0x06f5651bu, 0x05238bfbu,
+    0x03b00285u, 0x0066ec65u, 0x041ddf45u, 0x07cb31a5u, 0x0569826au, 0x06bf6c8au,
+    0x02c45faau, 0x0112b14au, 0x06617639u, 0x05b798d9u, 0x01ccabf9u, 0x021a4519u,
+    0x00b8f6d6u, 0x036e1836u, 0x07152b16u, 0x04c3c5f6u, 0x02504c88u, 0x0186a268u,
+    0x05fd9148u, 0x062b7fa8u, 0x0489cc67u, 0x075f2287u, 0x032411a7u, 0x00f2ff47u,
+    0x0441a42eu, 0x07974aceu, 0x03ec79eeu, 0x003a970eu, 0x029824c1u, 0x014eca21u,
+    0x0535f901u, 0x06e317e1u, 0x00709e9fu, 0x03a6707fu, 0x07dd435fu, 0x040badbfu,
+    0x06a91e70u, 0x057ff090u, 0x0104c3b0u, 0x02d22d50u, 0x05a1ea23u, 0x067704c3u,
+    0x020c37e3u, 0x01dad903u, 0x03786accu, 0x00ae842cu, 0x04d5b70cu, 0x070359ecu,
+    0x0190d092u, 0x02463e72u, 0x063d0d52u, 0x05ebe3b2u, 0x0749507du, 0x049fbe9du,
+    0x00e48dbdu, 0x0332635du, 0x06804b07u, 0x0556a5e7u, 0x012d96c7u, 0x02fb7827u,
+    0x0059cbe8u, 0x038f2508u, 0x07f41628u, 0x0422f8c8u, 0x02b171b6u, 0x01679f56u,
+    0x051cac76u, 0x06ca4296u, 0x0468f159u, 0x07be1fb9u, 0x03c52c99u, 0x0013c279u,
+    0x0760050au, 0x04b6ebeau, 0x00cdd8cau, 0x031b362au, 0x01b985e5u, 0x026f6b05u,
+    0x06145825u, 0x05c2b6c5u, 0x03513fbbu, 0x0087d15bu, 0x04fce27bu, 0x072a0c9bu,
+    0x0588bf54u, 0x065e51b4u, 0x02256294u, 0x01f38c74u, 0x0540d71du, 0x069639fdu,
+    0x02ed0addu, 0x013be43du, 0x039957f2u, 0x004fb912u, 0x04348a32u, 0x07e264d2u,
+    0x0171edacu, 0x02a7034cu, 0x06dc306cu, 0x050ade8cu, 0x07a86d43u, 0x047e83a3u,
+    0x0005b083u, 0x03d35e63u, 0x04a09910u, 0x077677f0u, 0x030d44d0u, 0x00dbaa30u,
+    0x027919ffu, 0x01aff71fu, 0x05d4c43fu, 0x06022adfu, 0x0091a3a1u, 0x03474d41u,
+    0x073c7e61u, 0x04ea9081u, 0x0648234eu, 0x059ecdaeu, 0x01e5fe8eu, 0x0233106eu,
+    0x01017333u, 0x02d79dd3u, 0x06acaef3u, 0x057a4013u, 0x07d8f3dcu, 0x040e1d3cu,
+    0x00752e1cu, 0x03a3c0fcu, 0x05304982u, 0x06e6a762u, 0x029d9442u, 0x014b7aa2u,
+    0x03e9c96du, 0x003f278du, 0x044414adu, 0x0792fa4du, 0x00e13d3eu, 0x0337d3deu,
+    0x074ce0feu, 0x049a0e1eu, 0x0638bdd1u, 0x05ee5331u, 0x01956011u, 0x02438ef1u,
+    0x04d0078fu, 0x0706e96fu, 0x037dda4fu, 0x00ab34afu, 0x02098760u, 0x01df6980u,
+    0x05a45aa0u, 0x0672b440u, 0x02c1ef29u, 0x011701c9u, 0x056c32e9u, 0x06badc09u,
+    0x04186fc6u, 0x07ce8126u, 0x03b5b206u, 0x00635ce6u, 0x06f0d598u, 0x05263b78u,
+    0x015d0858u, 0x028be6b8u, 0x00295577u, 0x03ffbb97u, 0x078488b7u, 0x04526657u,
+    0x0321a124u, 0x00f74fc4u, 0x048c7ce4u, 0x075a9204u, 0x05f821cbu, 0x062ecf2bu,
+    0x0255fc0bu, 0x018312ebu, 0x07109b95u, 0x04c67575u, 0x00bd4655u, 0x036ba8b5u,
+    0x01c91b7au, 0x021ff59au, 0x0664c6bau, 0x05b2285au
+  },
+  {
+    0x00000000u, 0x01339183u, 0x02672306u, 0x0354b285u, 0x04ce460cu, 0x05fdd78fu,
+    0x06a9650au, 0x079af489u, 0x001eb777u, 0x012d26f4u, 0x02799471u, 0x034a05f2u,
+    0x04d0f17bu, 0x05e360f8u, 0x06b7d27du, 0x078443feu, 0x003d6eeeu, 0x010eff6du,
+    0x025a4de8u, 0x0369dc6bu, 0x04f328e2u, 0x05c0b961u, 0x06940be4u, 0x07a79a67u,
+    0x0023d999u, 0x0110481au, 0x0244fa9fu, 0x03776b1cu, 0x04ed9f95u, 0x05de0e16u,
+    0x068abc93u, 0x07b92d10u, 0x007adddcu, 0x01494c5fu, 0x021dfedau, 0x032e6f59u,
+    0x04b49bd0u, 0x05870a53u, 0x06d3b8d6u, 0x07e02955u, 0x00646aabu, 0x0157fb28u,
+    0x020349adu, 0x0330d82eu, 0x04aa2ca7u, 0x0599bd24u, 0x06cd0fa1u, 0x07fe9e22u,
+    0x0047b332u, 0x017422b1u, 0x02209034u, 0x031301b7u, 0x0489f53eu, 0x05ba64bdu,
+    0x06eed638u, 0x07dd47bbu, 0x00590445u, 0x016a95c6u, 0x023e2743u, 0x030db6c0u,
+    0x04974249u, 0x05a4d3cau, 0x06f0614fu, 0x07c3f0ccu, 0x00f5bbb8u, 0x01c62a3bu,
+    0x029298beu, 0x03a1093du, 0x043bfdb4u, 0x05086c37u, 0x065cdeb2u, 0x076f4f31u,
+    0x00eb0ccfu, 0x01d89d4cu, 0x028c2fc9u, 0x03bfbe4au, 0x04254ac3u, 0x0516db40u,
+    0x064269c5u, 0x0771f846u, 0x00c8d556u, 0x01fb44d5u, 0x02aff650u, 0x039c67d3u,
+    0x0406935au, 0x053502d9u, 0x0661b05cu, 0x075221dfu, 0x00d66221u, 0x01e5f3a2u,
+    0x02b14127u, 0x0382d0a4u, 0x0418242du, 0x052bb5aeu, 0x067f072bu, 0x074c96a8u,
+    0x008f6664u, 0x01bcf7e7u, 0x02e84562u, 0x03dbd4e1u, 0x04412068u, 0x0572b1ebu,
+    0x0626036eu, 0x071592edu, 0x0091d113u, 0x01a24090u, 0x02f6f215u, 0x03c56396u,
+    0x045f971fu, 0x056c069cu, 0x0638b419u, 0x070b259au, 0x00b2088au, 0x01819909u,
+    0x02d52b8cu, 0x03e6ba0fu, 0x047c4e86u, 0x054fdf05u, 0x061b6d80u, 0x0728fc03u,
+    0x00acbffdu, 0x019f2e7eu, 0x02cb9cfbu, 0x03f80d78u, 0x0462f9f1u, 0x05516872u,
+    0x0605daf7u, 0x07364b74u, 0x01eb7770u, 0x00d8e6f3u, 0x038c5476u, 0x02bfc5f5u,
+    0x0525317cu, 0x0416a0ffu, 0x0742127au, 0x067183f9u, 0x01f5c007u, 0x00c65184u,
+    0x0392e301u, 0x02a17282u, 0x053b860bu, 0x04081788u, 0x075ca50du, 0x066f348eu,
+    0x01d6199eu, 0x00e5881du, 0x03b13a98u, 0x0282ab1bu, 0x05185f92u, 0x042bce11u,
+    0x077f7c94u, 0x064ced17u, 0x01c8aee9u, 0x00fb3f6au, 0x03af8defu, 0x029c1c6cu,
+    0x0506e8e5u, 0x04357966u, 0x0761cbe3u, 0x06525a60u, 0x0191aaacu, 0x00a23b2fu,
+    0x03f689aau, 0x02c51829u, 0x055feca0u, 0x046c7d23u, 0x0738cfa6u, 0x060b5e25u,
+    0x018f1ddbu, 0x00bc8c58u, 0x03e83eddu, 0x02dbaf5eu, 0x05415bd7u, 0x0472ca54u,
+    0x072678d1u, 0x0615e952u, 0x01acc442u, 0x009f55c1u, 0x03cbe744u, 0x02f876c7u,
+    0x0562824eu, 0x045113cdu, 0x0705a148u, 0x063630cbu, 0x01b27335u, 0x0081e2b6u,
+    0x03d55033u, 0x02e6c1b0u, 0x057c3539u, 0x044fa4bau, 0x071b163fu, 0x062887bcu,
+    0x011eccc8u, 0x002d5d4bu, 0x0379efceu, 0x024a7e4du, 0x05d08ac4u, 0x04e31b47u,
+    0x07b7a9c2u, 0x06843841u, 0x01007bbfu, 0x0033ea3cu, 0x036758b9u, 0x0254c93au,
+    0x05ce3db3u, 0x04fdac30u, 0x07a91eb5u, 0x069a8f36u, 0x0123a226u, 0x001033a5u,
+    0x03448120u, 0x027710a3u, 0x05ede42au, 0x04de75a9u, 0x078ac72cu, 0x06b956afu,
+    0x013d1551u, 0x000e84d2u, 0x035a3657u, 0x0269a7d4u, 0x05f3535du, 0x04c0c2deu,
+    0x0794705bu, 0x06a7e1d8u, 0x01641114u, 0x00578097u, 0x03033212u, 0x0230a391u,
+    0x05aa5718u, 0x0499c69bu, 0x07cd741eu, 0x06fee59du, 0x017aa663u, 0x004937e0u,
+    0x031d8565u, 0x022e14e6u, 0x05b4e06fu, 0x048771ecu, 0x07d3c369u, 0x06e052eau,
+    0x01597ffau, 0x006aee79u, 0x033e5cfcu, 0x020dcd7fu, 0x059739f6u, 0x04a4a875u,
+    0x07f01af0u, 0x06c38b73u, 0x0147c88du, 0x0074590eu, 0x0320eb8bu, 0x02137a08u,
+    0x05898e81u, 0x04ba1f02u, 0x07eead87u, 0x06dd3c04u
+  },
+  {
+    0x00000000u, 0x07274ef0u, 0x07cca68fu, 0x00ebe87fu, 0x061b7671u, 0x013c3881u,
+    0x01d7d0feu, 0x06f09e0eu, 0x05b4d78du, 0x0293997du, 0x02787102u, 0x055f3ff2u,
+    0x03afa1fcu, 0x0488ef0cu, 0x04630773u, 0x03444983u, 0x02eb9475u, 0x05ccda85u,
+    0x052732fau, 0x02007c0au, 0x04f0e204u, 0x03d7acf4u, 0x033c448bu, 0x041b0a7bu,
+    0x075f43f8u, 0x00780d08u, 0x0093e577u, 0x07b4ab87u, 0x01443589u, 0x06637b79u,
+    0x06889306u, 0x01afddf6u, 0x05d728eau, 0x02f0661au, 0x021b8e65u, 0x053cc095u,
+    0x03cc5e9bu, 0x04eb106bu, 0x0400f814u, 0x0327b6e4u, 0x0063ff67u, 0x0744b197u,
+    0x07af59e8u, 0x00881718u, 0x06788916u, 0x015fc7e6u, 0x01b42f99u, 0x06936169u,
+    0x073cbc9fu, 0x001bf26fu, 0x00f01a10u, 0x07d754e0u, 0x0127caeeu, 0x0600841eu,
+    0x06eb6c61u, 0x01cc2291u, 0x02886b12u, 0x05af25e2u, 0x0544cd9du, 0x0263836du,
+    0x04931d63u, 0x03b45393u, 0x035fbbecu, 0x0478f51cu, 0x022c6abbu, 0x050b244bu,
+    0x05e0cc34u, 0x02c782c4u, 0x04371ccau, 0x0310523au, 0x03fbba45u, 0x04dcf4b5u,
+    0x0798bd36u, 0x00bff3c6u, 0x00541bb9u, 0x07735549u, 0x0183cb47u, 0x06a485b7u,
+    0x064f6dc8u, 0x01682338u, 0x00c7feceu, 0x07e0b03eu, 0x070b5841u, 0x002c16b1u,
+    0x06dc88bfu, 0x01fbc64fu, 0x01102e30u, 0x063760c0u, 0x05732943u, 0x025467b3u,
+    0x02bf8fccu, 0x0598c13cu, 0x03685f32u, 0x044f11c2u, 0x04a4f9bdu, 0x0383b74du,
+    0x07fb4251u, 0x00dc0ca1u, 0x0037e4deu, 0x0710aa2eu, 0x01e03420u, 0x06c77ad0u,
+    0x062c92afu, 0x010bdc5fu, 0x024f95dcu, 0x0568db2cu, 0x05833353u, 0x02a47da3u,
+    0x0454e3adu, 0x0373ad5du, 0x03984522u, 0x04bf0bd2u, 0x0510d624u, 0x023798d4u,
+    0x02dc70abu, 0x05fb3e5bu, 0x030ba055u, 0x042ceea5u, 0x04c706dau, 0x03e0482au,
+    0x00a401a9u, 0x07834f59u, 0x0768a726u, 0x004fe9d6u, 0x06bf77d8u, 0x01983928u,
+    0x0173d157u, 0x06549fa7u, 0x0458d576u, 0x037f9b86u, 0x039473f9u, 0x04b33d09u,
+    0x0243a307u, 0x0564edf7u, 0x058f0588u, 0x02a84b78u, 0x01ec02fbu, 0x06cb4c0bu,
+    0x0620a474u, 0x0107ea84u, 0x07f7748au, 0x00d03a7au, 0x003bd205u, 0x071c9cf5u,
+    0x06b34103u, 0x01940ff3u, 0x017fe78cu, 0x0658a97cu, 0x00a83772u, 0x078f7982u,
+    0x076491fdu, 0x0043df0du, 0x0307968eu, 0x0420d87eu, 0x04cb3001u, 0x03ec7ef1u,
+    0x051ce0ffu, 0x023bae0fu, 0x02d04670u, 0x05f70880u, 0x018ffd9cu, 0x06a8b36cu,
+    0x06435b13u, 0x016415e3u, 0x07948bedu, 0x00b3c51du, 0x00582d62u, 0x077f6392u,
+    0x043b2a11u, 0x031c64e1u, 0x03f78c9eu, 0x04d0c26eu, 0x02205c60u, 0x05071290u,
+    0x05ecfaefu, 0x02cbb41fu, 0x036469e9u, 0x04432719u, 0x04a8cf66u, 0x038f8196u,
+    0x057f1f98u, 0x02585168u, 0x02b3b917u, 0x0594f7e7u, 0x06d0be64u, 0x01f7f094u,
+    0x011c18ebu, 0x063b561bu, 0x00cbc815u, 0x07ec86e5u, 0x07076e9au, 0x0020206au,
+    0x0674bfcdu, 0x0153f13du, 0x01b81942u, 0x069f57b2u, 0x006fc9bcu, 0x0748874cu,
+    0x07a36f33u, 0x008421c3u, 0x03c06840u, 0x04e726b0u, 0x040ccecfu, 0x032b803fu,
+    0x05db1e31u, 0x02fc50c1u, 0x0217b8beu, 0x0530f64eu, 0x049f2bb8u, 0x03b86548u,
+    0x03538d37u, 0x0474c3c7u, 0x02845dc9u, 0x05a31339u, 0x0548fb46u, 0x026fb5b6u,
+    0x012bfc35u, 0x060cb2c5u, 0x06e75abau, 0x01c0144au, 0x07308a44u, 0x0017c4b4u,
+    0x00fc2ccbu, 0x07db623bu, 0x03a39727u, 0x0484d9d7u, 0x046f31a8u, 0x03487f58u,
+    0x05b8e156u, 0x029fafa6u, 0x027447d9u, 0x05530929u, 0x061740aau, 0x01300e5au,
+    0x01dbe625u, 0x06fca8d5u, 0x000c36dbu, 0x072b782bu, 0x07c09054u, 0x00e7dea4u,
+    0x01480352u, 0x066f4da2u, 0x0684a5ddu, 0x01a3eb2du, 0x07537523u, 0x00743bd3u,
+    0x009fd3acu, 0x07b89d5cu, 0x04fcd4dfu, 0x03db9a2fu, 0x03307250u, 0x04173ca0u,
+    0x02e7a2aeu, 0x05c0ec5eu, 0x052b0421u, 0x020c4ad1u
+  },
+  {
+    0x00000000u, 0x009f04f8u, 0x013e09f0u, 0x01a10d08u, 0x027c13e0u, 0x02e31718u,
+    0x03421a10u, 0x03dd1ee8u, 0x04f827c0u, 0x04672338u, 0x05c62e30u, 0x05592ac8u,
+    0x06843420u, 0x061b30d8u, 0x07ba3dd0u, 0x07253928u, 0x007274efu, 0x00ed7017u,
+    0x014c7d1fu, 0x01d379e7u, 0x020e670fu, 0x029163f7u, 0x03306effu, 0x03af6a07u,
+    0x048a532fu, 0x041557d7u, 0x05b45adfu, 0x052b5e27u, 0x06f640cfu, 0x06694437u,
+    0x07c8493fu, 0x07574dc7u, 0x00e4e9deu, 0x007bed26u, 0x01dae02eu, 0x0145e4d6u,
+    0x0298fa3eu, 0x0207fec6u, 0x03a6f3ceu, 0x0339f736u, 0x041cce1eu, 0x0483cae6u,
+    0x0522c7eeu, 0x05bdc316u, 0x0660ddfeu, 0x06ffd906u, 0x075ed40eu, 0x07c1d0f6u,
+    0x00969d31u, 0x000999c9u, 0x01a894c1u, 0x01379039u, 0x02ea8ed1u, 0x02758a29u,
+    0x03d48721u, 0x034b83d9u, 0x046ebaf1u, 0x04f1be09u, 0x0550b301u, 0x05cfb7f9u,
+    0x0612a911u, 0x068dade9u, 0x072ca0e1u, 0x07b3a419u, 0x01c9d3bcu, 0x0156d744u,
+    0x00f7da4cu, 0x0068deb4u, 0x03b5c05cu, 0x032ac4a4u, 0x028bc9acu, 0x0214cd54u,
+    0x0531f47cu, 0x05aef084u, 0x040ffd8cu, 0x0490f974u, 0x074de79cu, 0x07d2e364u,
+    0x0673ee6cu, 0x06ecea94u, 0x01bba753u, 0x0124a3abu, 0x0085aea3u, 0x001aaa5bu,
+    0x03c7b4b3u, 0x0358b04bu, 0x02f9bd43u, 0x0266b9bbu, 0x05438093u, 0x05dc846bu,
+    0x047d8963u, 0x04e28d9bu, 0x073f9373u, 0x07a0978bu, 0x06019a83u, 0x069e9e7bu,
+    0x012d3a62u, 0x01b23e9au, 0x00133392u, 0x008c376au, 0x03512982u, 0x03ce2d7au,
+    0x026f2072u, 0x02f0248au, 0x05d51da2u, 0x054a195au, 0x04eb1452u, 0x047410aau,
+    0x07a90e42u, 0x07360abau, 0x069707b2u, 0x0608034au, 0x015f4e8du, 0x01c04a75u,
+    0x0061477du, 0x00fe4385u, 0x03235d6du, 0x03bc5995u, 0x021d549du, 0x02825065u,
+    0x05a7694du, 0x05386db5u, 0x049960bdu, 0x04066445u, 0x07db7aadu, 0x07447e55u,
+    0x06e5735du, 0x067a77a5u, 0x0393a778u, 0x030ca380u, 0x02adae88u, 0x0232aa70u,
+    0x01efb498u, 0x0170b060u, 0x00d1bd68u, 0x004eb990u, 0x076b80b8u, 0x07f48440u,
+    0x06558948u, 0x06ca8db0u, 0x05179358u, 0x058897a0u, 0x04299aa8u, 0x04b69e50u,
+    0x03e1d397u, 0x037ed76fu, 0x02dfda67u, 0x0240de9fu, 0x019dc077u, 0x0102c48fu,
+    0x00a3c987u, 0x003ccd7fu, 0x0719f457u, 0x0786f0afu, 0x0627fda7u, 0x06b8f95fu,
+    0x0565e7b7u, 0x05fae34fu, 0x045bee47u, 0x04c4eabfu, 0x03774ea6u, 0x03e84a5eu,
+    0x02494756u, 0x02d643aeu, 0x010b5d46u, 0x019459beu, 0x003554b6u, 0x00aa504eu,
+    0x078f6966u, 0x07106d9eu, 0x06b16096u, 0x062e646eu, 0x05f37a86u, 0x056c7e7eu,
+    0x04cd7376u, 0x0452778eu, 0x03053a49u, 0x039a3eb1u, 0x023b33b9u, 0x02a43741u,
+    0x017929a9u, 0x01e62d51u, 0x00472059u, 0x00d824a1u, 0x07fd1d89u, 0x07621971u,
+    0x06c31479u, 0x065c1081u, 0x05810e69u, 0x051e0a91u, 0x04bf0799u, 0x04200361u,
+    0x025a74c4u, 0x02c5703cu, 0x03647d34u, 0x03fb79ccu, 0x00266724u, 0x00b963dcu,
+    0x01186ed4u, 0x01876a2cu, 0x06a25304u, 0x063d57fcu, 0x079c5af4u, 0x07035e0cu,
+    0x04de40e4u, 0x0441441cu, 0x05e04914u, 0x057f4decu, 0x0228002bu, 0x02b704d3u,
+    0x031609dbu, 0x03890d23u, 0x005413cbu, 0x00cb1733u, 0x016a1a3bu, 0x01f51ec3u,
+    0x06d027ebu, 0x064f2313u, 0x07ee2e1bu, 0x07712ae3u, 0x04ac340bu, 0x043330f3u,
+    0x05923dfbu, 0x050d3903u, 0x02be9d1au, 0x022199e2u, 0x038094eau, 0x031f9012u,
+    0x00c28efau, 0x005d8a02u, 0x01fc870au, 0x016383f2u, 0x0646badau, 0x06d9be22u,
+    0x0778b32au, 0x07e7b7d2u, 0x043aa93au, 0x04a5adc2u, 0x0504a0cau, 0x059ba432u,
+    0x02cce9f5u, 0x0253ed0du, 0x03f2e005u, 0x036de4fdu, 0x00b0fa15u, 0x002ffeedu,
+    0x018ef3e5u, 0x0111f71du, 0x0634ce35u, 0x06abcacdu, 0x070ac7c5u, 0x0795c33du,
+    0x0448ddd5u, 0x04d7d92du, 0x0576d425u, 0x05e9d0ddu
+  },
+  {
+    0x00000000u, 0x048d9368u, 0x00991dbfu, 0x04148ed7u, 0x01323b7eu, 0x05bfa816u,
+    0x01ab26c1u, 0x0526b5a9u, 0x026476fcu, 0x06e9e594u, 0x02fd6b43u, 0x0670f82bu,
+    0x03564d82u, 0x07dbdeeau, 0x03cf503du, 0x0742c355u, 0x04c8edf8u, 0x00457e90u,
+    0x0451f047u, 0x00dc632fu, 0x05fad686u, 0x017745eeu, 0x0563cb39u, 0x01ee5851u,
+    0x06ac9b04u, 0x0221086cu, 0x063586bbu, 0x02b815d3u, 0x079ea07au, 0x03133312u,
+    0x0707bdc5u, 0x038a2eadu, 0x0013e09fu, 0x049e73f7u, 0x008afd20u, 0x04076e48u,
+    0x0121dbe1u, 0x05ac4889u, 0x01b8c65eu, 0x05355536u, 0x02779663u, 0x06fa050bu,
+    0x02ee8bdcu, 0x066318b4u, 0x0345ad1du, 0x07c83e75u, 0x03dcb0a2u, 0x075123cau,
+    0x04db0d67u, 0x00569e0fu, 0x044210d8u, 0x00cf83b0u, 0x05e93619u, 0x0164a571u,
+    0x05702ba6u, 0x01fdb8ceu, 0x06bf7b9bu, 0x0232e8f3u, 0x06266624u, 0x02abf54cu,
+    0x078d40e5u, 0x0300d38du, 0x07145d5au, 0x0399ce32u, 0x0027c13eu, 0x04aa5256u,
+    0x00bedc81u, 0x04334fe9u, 0x0115fa40u, 0x05986928u, 0x018ce7ffu, 0x05017497u,
+    0x0243b7c2u, 0x06ce24aau, 0x02daaa7du, 0x06573915u, 0x03718cbcu, 0x07fc1fd4u,
+    0x03e89103u, 0x0765026bu, 0x04ef2cc6u, 0x0062bfaeu, 0x04763179u, 0x00fba211u,
+    0x05dd17b8u, 0x015084d0u, 0x05440a07u, 0x01c9996fu, 0x068b5a3au, 0x0206c952u,
+    0x06124785u, 0x029fd4edu, 0x07b96144u, 0x0334f22cu, 0x07207cfbu, 0x03adef93u,
+    0x003421a1u, 0x04b9b2c9u, 0x00ad3c1eu, 0x0420af76u, 0x01061adfu, 0x058b89b7u,
+    0x019f0760u, 0x05129408u, 0x0250575du, 0x06ddc435u, 0x02c94ae2u, 0x0644d98au,
+    0x03626c23u, 0x07efff4bu, 0x03fb719cu, 0x0776e2f4u, 0x04fccc59u, 0x00715f31u,
+    0x0465d1e6u, 0x00e8428eu, 0x05cef727u, 0x0143644fu, 0x0557ea98u, 0x01da79f0u,
+    0x0698baa5u, 0x021529cdu, 0x0601a71au, 0x028c3472u, 0x07aa81dbu, 0x032712b3u,
+    0x07339c64u, 0x03be0f0cu, 0x004f827cu, 0x04c21114u, 0x00d69fc3u, 0x045b0cabu,
+    0x017db902u, 0x05f02a6au, 0x01e4a4bdu, 0x056937d5u, 0x022bf480u, 0x06a667e8u,
+    0x02b2e93fu, 0x063f7a57u, 0x0319cffeu, 0x07945c96u, 0x0380d241u, 0x070d4129u,
+    0x04876f84u, 0x000afcecu, 0x041e723bu, 0x0093e153u, 0x05b554fau, 0x0138c792u,
+    0x052c4945u, 0x01a1da2du, 0x06e31978u, 0x026e8a10u, 0x067a04c7u, 0x02f797afu,
+    0x07d12206u, 0x035cb16eu, 0x07483fb9u, 0x03c5acd1u, 0x005c62e3u, 0x04d1f18bu,
+    0x00c57f5cu, 0x0448ec34u, 0x016e599du, 0x05e3caf5u, 0x01f74422u, 0x057ad74au,
+    0x0238141fu, 0x06b58777u, 0x02a109a0u, 0x062c9ac8u, 0x030a2f61u, 0x0787bc09u,
+    0x039332deu, 0x071ea1b6u, 0x04948f1bu, 0x00191c73u, 0x040d92a4u, 0x008001ccu,
+    0x05a6b465u, 0x012b270du, 0x053fa9dau, 0x01b23ab2u, 0x06f0f9e7u, 0x027d6a8fu,
+    0x0669e458u, 0x02e47730u, 0x07c2c299u, 0x034f51f1u, 0x075bdf26u, 0x03d64c4eu,
+    0x00684342u, 0x04e5d02au, 0x00f15efdu, 0x047ccd95u, 0x015a783cu, 0x05d7eb54u,
+    0x01c36583u, 0x054ef6ebu, 0x020c35beu, 0x0681a6d6u, 0x02952801u, 0x0618bb69u,
+    0x033e0ec0u, 0x07b39da8u, 0x03a7137fu, 0x072a8017u, 0x04a0aebau, 0x002d3dd2u,
+    0x0439b305u, 0x00b4206du, 0x059295c4u, 0x011f06acu, 0x050b887bu, 0x01861b13u,
+    0x06c4d846u, 0x02494b2eu, 0x065dc5f9u, 0x02d05691u, 0x07f6e338u, 0x037b7050u,
+    0x076ffe87u, 0x03e26defu, 0x007ba3ddu, 0x04f630b5u, 0x00e2be62u, 0x046f2d0au,
+    0x014998a3u, 0x05c40bcbu, 0x01d0851cu, 0x055d1674u, 0x021fd521u, 0x06924649u,
+    0x0286c89eu, 0x060b5bf6u, 0x032dee5fu, 0x07a07d37u, 0x03b4f3e0u, 0x07396088u,
+    0x04b34e25u, 0x003edd4du, 0x042a539au, 0x00a7c0f2u, 0x0581755bu, 0x010ce633u,
+    0x051868e4u, 0x0195fb8cu, 0x06d738d9u, 0x025aabb1u, 0x064e2566u, 0x02c3b60eu,
+    0x07e503a7u, 0x036890cfu, 0x077c1e18u, 0x03f18d70u
+  },
+  {
+    0x00000000u, 0x01e0f893u, 0x03c1f126u, 0x022109b5u, 0x0783e24cu, 0x06631adfu,
+    0x0442136au, 0x05a2ebf9u, 0x0685fff7u, 0x07650764u, 0x05440ed1u, 0x04a4f642u,
+    0x01061dbbu, 0x00e6e528u, 0x02c7ec9du, 0x0327140eu, 0x0489c481u, 0x05693c12u,
+    0x074835a7u, 0x06a8cd34u, 0x030a26cdu, 0x02eade5eu, 0x00cbd7ebu, 0x012b2f78u,
+    0x020c3b76u, 0x03ecc3e5u, 0x01cdca50u, 0x002d32c3u, 0x058fd93au, 0x046f21a9u,
+    0x064e281cu, 0x07aed08fu, 0x0091b26du, 0x01714afeu, 0x0350434bu, 0x02b0bbd8u,
+    0x07125021u, 0x06f2a8b2u, 0x04d3a107u, 0x05335994u, 0x06144d9au, 0x07f4b509u,
+    0x05d5bcbcu, 0x0435442fu, 0x0197afd6u, 0x00775745u, 0x02565ef0u, 0x03b6a663u,
+    0x041876ecu, 0x05f88e7fu, 0x07d987cau, 0x06397f59u, 0x039b94a0u, 0x027b6c33u,
+    0x005a6586u, 0x01ba9d15u, 0x029d891bu, 0x037d7188u, 0x015c783du, 0x00bc80aeu,
+    0x051e6b57u, 0x04fe93c4u, 0x06df9a71u, 0x073f62e2u, 0x012364dau, 0x00c39c49u,
+    0x02e295fcu, 0x03026d6fu, 0x06a08696u, 0x07407e05u, 0x056177b0u, 0x04818f23u,
+    0x07a69b2du, 0x064663beu, 0x04676a0bu, 0x05879298u, 0x00257961u, 0x01c581f2u,
+    0x03e48847u, 0x020470d4u, 0x05aaa05bu, 0x044a58c8u, 0x066b517du, 0x078ba9eeu,
+    0x02294217u, 0x03c9ba84u, 0x01e8b331u, 0x00084ba2u, 0x032f5facu, 0x02cfa73fu,
+    0x00eeae8au, 0x010e5619u, 0x04acbde0u, 0x054c4573u, 0x076d4cc6u, 0x068db455u,
+    0x01b2d6b7u, 0x00522e24u, 0x02732791u, 0x0393df02u, 0x063134fbu, 0x07d1cc68u,
+    0x05f0c5ddu, 0x04103d4eu, 0x07372940u, 0x06d7d1d3u, 0x04f6d866u, 0x051620f5u,
+    0x00b4cb0cu, 0x0154339fu, 0x03753a2au, 0x0295c2b9u, 0x053b1236u, 0x04dbeaa5u,
+    0x06fae310u, 0x071a1b83u, 0x02b8f07au, 0x035808e9u, 0x0179015cu, 0x0099f9cfu,
+    0x03beedc1u, 0x025e1552u, 0x007f1ce7u, 0x019fe474u, 0x043d0f8du, 0x05ddf71eu,
+    0x07fcfeabu, 0x061c0638u, 0x0246c9b4u, 0x03a63127u, 0x01873892u, 0x0067c001u,
+    0x05c52bf8u, 0x0425d36bu, 0x0604dadeu, 0x07e4224du, 0x04c33643u, 0x0523ced0u,
+    0x0702c765u, 0x06e23ff6u, 0x0340d40fu, 0x02a02c9cu, 0x00812529u, 0x0161ddbau,
+    0x06cf0d35u, 0x072ff5a6u, 0x050efc13u, 0x04ee0480u, 0x014cef79u, 0x00ac17eau,
+    0x028d1e5fu, 0x036de6ccu, 0x004af2c2u, 0x01aa0a51u, 0x038b03e4u, 0x026bfb77u,
+    0x07c9108eu, 0x0629e81du, 0x0408e1a8u, 0x05e8193bu, 0x02d77bd9u, 0x0337834au,
+    0x01168affu, 0x00f6726cu, 0x05549995u, 0x04b46106u, 0x069568b3u, 0x07759020u,
+    0x0452842eu, 0x05b27cbdu, 0x07937508u, 0x06738d9bu, 0x03d16662u, 0x02319ef1u,
+    0x00109744u, 0x01f06fd7u, 0x065ebf58u, 0x07be47cbu, 0x059f4e7eu, 0x047fb6edu,
+    0x01dd5d14u, 0x003da587u, 0x021cac32u, 0x03fc54a1u, 0x00db40afu, 0x013bb83cu,
+    0x031ab189u, 0x02fa491au, 0x0758a2e3u, 0x06b85a70u, 0x049953c5u, 0x0579ab56u,
+    0x0365ad6eu, 0x028555fdu, 0x00a45c48u, 0x0144a4dbu, 0x04e64f22u, 0x0506b7b1u,
+    0x0727be04u, 0x06c74697u, 0x05e05299u, 0x0400aa0au, 0x0621a3bfu, 0x07c15b2cu,
+    0x0263b0d5u, 0x03834846u, 0x01a241f3u, 0x0042b960u, 0x07ec69efu, 0x060c917cu,
+    0x042d98c9u, 0x05cd605au, 0x006f8ba3u, 0x018f7330u, 0x03ae7a85u, 0x024e8216u,
+    0x01699618u, 0x00896e8bu, 0x02a8673eu, 0x03489fadu, 0x06ea7454u, 0x070a8cc7u,
+    0x052b8572u, 0x04cb7de1u, 0x03f41f03u, 0x0214e790u, 0x0035ee25u, 0x01d516b6u,
+    0x0477fd4fu, 0x059705dcu, 0x07b60c69u, 0x0656f4fau, 0x0571e0f4u, 0x04911867u,
+    0x06b011d2u, 0x0750e941u, 0x02f202b8u, 0x0312fa2bu, 0x0133f39eu, 0x00d30b0du,
+    0x077ddb82u, 0x069d2311u, 0x04bc2aa4u, 0x055cd237u, 0x00fe39ceu, 0x011ec15du,
+    0x033fc8e8u, 0x02df307bu, 0x01f82475u, 0x0018dce6u, 0x0239d553u, 0x03d92dc0u,
+    0x067bc639u, 0x079b3eaau, 0x05ba371fu, 0x045acf8cu
+  }
+};
+
+/* crc64_table[k][i] is the crc of the byte i followed by k zero bytes.
+   generated with CRC64POLY */
+static const u_int64_t crc64_table[8][256] = {
+  {
+    0x0000000000000000ull, 0x01b0000000000000ull, 0x0360000000000000ull,
+    0x02d0000000000000ull, 0x06c0000000000000ull, 0x0770000000000000ull,
+    0x05a0000000000000ull, 0x0410000000000000ull, 0x0d80000000000000ull,
+    0x0c30000000000000ull, 0x0ee0000000000000ull, 0x0f50000000000000ull,
+    0x0b40000000000000ull, 0x0af0000000000000ull, 0x0820000000000000ull,
+    0x0990000000000000ull, 0x1b00000000000000ull, 0x1ab0000000000000ull,
+    0x1860000000000000ull, 0x19d0000000000000ull, 0x1dc0000000000000ull,
+    0x1c70000000000000ull, 0x1ea0000000000000ull, 0x1f10000000000000ull,
+    0x1680000000000000ull, 0x1730000000000000ull, 0x15e0000000000000ull,
+    0x1450000000000000ull, 0x1040000000000000ull, 0x11f0000000000000ull,
+    0x1320000000000000ull, 0x1290000000000000ull, 0x3600000000000000ull,
+    0x37b0000000000000ull, 0x3560000000000000ull, 0x34d0000000000000ull,
+    0x30c0000000000000ull, 0x3170000000000000ull, 0x33a0000000000000ull,
+    0x3210000000000000ull, 0x3b80000000000000ull, 0x3a30000000000000ull,
+    0x38e0000000000000ull, 0x3950000000000000ull, 0x3d40000000000000ull,
+    0x3cf0000000000000ull, 0x3e20000000000000ull, 0x3f90000000000000ull,
+    0x2d00000000000000ull, 0x2cb0000000000000ull, 0x2e60000000000000ull,
+    0x2fd0000000000000ull, 0x2bc0000000000000ull, 0x2a70000000000000ull,
+    0x28a0000000000000ull, 0x2910000000000000ull, 0x2080000000000000ull,
+    0x2130000000000000ull, 0x23e0000000000000ull, 0x2250000000000000ull,
+    0x2640000000000000ull, 0x27f0000000000000ull, 0x2520000000000000ull,
+    0x2490000000000000ull, 0x6c00000000000000ull, 0x6db0000000000000ull,
+    0x6f60000000000000ull, 0x6ed0000000000000ull, 0x6ac0000000000000ull,
+    0x6b70000000000000ull, 0x69a0000000000000ull, 0x6810000000000000ull,
+    0x6180000000000000ull, 0x6030000000000000ull, 0x62e0000000000000ull,
+    0x6350000000000000ull, 0x6740000000000000ull, 0x66f0000000000000ull,
+    0x6420000000000000ull, 0x6590000000000000ull, 0x7700000000000000ull,
+    0x76b0000000000000ull, 0x7460000000000000ull, 0x75d0000000000000ull,
+    0x71c0000000000000ull, 0x7070000000000000ull, 0x72a0000000000000ull,
+    0x7310000000000000ull, 0x7a80000000000000ull, 0x7b30000000000000ull,
+    0x79e0000000000000ull, 0x7850000000000000ull, 0x7c40000000000000ull,
+    0x7df0000000000000ull, 0x7f20000000000000ull, 0x7e90000000000000ull,
+    0x5a00000000000000ull, 0x5bb0000000000000ull, 0x5960000000000000ull,
+    0x58d0000000000000ull, 0x5cc0000000000000ull, 0x5d70000000000000ull,
+    0x5fa0000000000000ull, 0x5e10000000000000ull, 0x5780000000000000ull,
+    0x5630000000000000ull, 0x54e0000000000000ull, 0x5550000000000000ull,
+    0x5140000000000000ull, 0x50f0000000000000ull, 0x5220000000000000ull,
+    0x5390000000000000ull, 0x4100000000000000ull, 0x40b0000000000000ull,
+    0x4260000000000000ull, 0x43d0000000000000ull, 0x47c0000000000000ull,
+    0x4670000000000000ull, 0x44a0000000000000ull, 0x4510000000000000ull,
+    0x4c80000000000000ull, 0x4d30000000000000ull, 0x4fe0000000000000ull,
+    0x4e50000000000000ull, 0x4a40000000000000ull, 0x4bf0000000000000ull,
+    0x4920000000000000ull, 0x4890000000000000ull, 0xd800000000000000ull,
+    0xd9b0000000000000ull, 0xdb60000000000000ull, 0xdad0000000000000ull,
+    0xdec0000000000000ull, 0xdf70000000000000ull, 0xdda0000000000000ull,
+    0xdc10000000000000ull, 0xd580000000000000ull, 0xd430000000000000ull,
+    0xd6e0000000000000ull, 0xd750000000000000ull, 0xd340000000000000ull,
+    0xd2f0000000000000ull, 0xd020000000000000ull, 0xd190000000000000ull,
+    0xc300000000000000ull, 0xc2b0000000000000ull, 0xc060000000000000ull,
+    0xc1d0000000000000ull, 0xc5c0000000000000ull, 0xc470000000000000ull,
+    0xc6a0000000000000ull, 0xc710000000000000ull, 0xce80000000000000ull,
+    0xcf30000000000000ull, 0xcde0000000000000ull, 0xcc50000000000000ull,
+    0xc840000000000000ull, 0xc9f0000000000000ull, 0xcb20000000000000ull,
+    0xca90000000000000ull, 0xee00000000000000ull, 0xefb0000000000000ull,
+    0xed60000000000000ull, 0xecd0000000000000ull, 0xe8c0000000000000ull,
+    0xe970000000000000ull, 0xeba0000000000000ull, 0xea10000000000000ull,
+    0xe380000000000000ull, 0xe230000000000000ull, 0xe0e0000000000000ull,
+    0xe150000000000000ull, 0xe540000000000000ull, 0xe4f0000000000000ull,
+    0xe620000000000000ull, 0xe790000000000000ull, 0xf500000000000000ull,
+    0xf4b0000000000000ull, 0xf660000000000000ull, 0xf7d0000000000000ull,
+    0xf3c0000000000000ull, 0xf270000000000000ull, 0xf0a0000000000000ull,
+    0xf110000000000000ull, 0xf880000000000000ull, 0xf930000000000000ull,
+    0xfbe0000000000000ull, 0xfa50000000000000ull, 0xfe40000000000000ull,
+    0xfff0000000000000ull, 0xfd20000000000000ull, 0xfc90000000000000ull,
+    0xb400000000000000ull, 0xb5b0000000000000ull, 0xb760000000000000ull,
+    0xb6d0000000000000ull, 0xb2c0000000000000ull, 0xb370000000000000ull,
+    0xb1a0000000000000ull, 0xb010000000000000ull, 0xb980000000000000ull,
+    0xb830000000000000ull, 0xbae0000000000000ull, 0xbb50000000000000ull,
+    0xbf40000000000000ull, 0xbef0000000000000ull, 0xbc20000000000000ull,
+    0xbd90000000000000ull, 0xaf00000000000000ull, 0xaeb0000000000000ull,
+    0xac60000000000000ull, 0xadd0000000000000ull, 0xa9c0000000000000ull,
+    0xa870000000000000ull, 0xaaa0000000000000ull, 0xab10000000000000ull,
+    0xa280000000000000ull, 0xa330000000000000ull, 0xa1e0000000000000ull,
+    0xa050000000000000ull, 0xa440000000000000ull, 0xa5f0000000000000ull,
+    0xa720000000000000ull, 0xa690000000000000ull, 0x8200000000000000ull,
+    0x83b0000000000000ull, 0x8160000000000000ull, 0x80d0000000000000ull,
+    0x84c0000000000000ull, 0x8570000000000000ull, 0x87a0000000000000ull,
+    0x8610000000000000ull, 0x8f80000000000000ull, 0x8e30000000000000ull,
+    0x8ce0000000000000ull, 0x8d50000000000000ull, 0x8940000000000000ull,
+    0x88f0000000000000ull, 0x8a20000000000000ull, 0x8b90000000000000ull,
+    0x9900000000000000ull, 0x98b0000000000000ull, 0x9a60000000000000ull,
+    0x9bd0000000000000ull, 0x9fc0000000000000ull, 0x9e70000000000000ull,
+    0x9ca0000000000000ull, 0x9d10000000000000ull, 0x9480000000000000ull,
+    0x9530000000000000ull, 0x97e0000000000000ull, 0x9650000000000000ull,
+    0x9240000000000000ull, 0x93f0000000000000ull, 0x9120000000000000ull,
+    0x9090000000000000ull
+  },
+  {
+    0x0000000000000000ull, 0x0001b00000000000ull, 0x0003600000000000ull,
+    0x0002d00000000000ull, 0x0006c00000000000ull, 0x0007700000000000ull,
+    0x0005a00000000000ull, 0x0004100000000000ull, 0x000d800000000000ull,
+    0x000c300000000000ull, 0x000ee00000000000ull, 0x000f500000000000ull,
+    0x000b400000000000ull, 0x000af00000000000ull, 0x0008200000000000ull,
+    0x0009900000000000ull, 0x001b000000000000ull, 0x001ab00000000000ull,
+    0x0018600000000000ull, 0x0019d00000000000ull, 0x001dc00000000000ull,
+    0x001c700000000000ull, 0x001ea00000000000ull, 0x001f100000000000ull,
+    0x0016800000000000ull, 0x0017300000000000ull, 0x0015e00000000000ull,
+    0x0014500000000000ull, 0x0010400000000000ull, 0x0011f00000000000ull,
+    0x0013200000000000ull, 0x0012900000000000ull, 0x0036000000000000ull,
+    0x0037b00000000000ull, 0x0035600000000000ull, 0x0034d00000000000ull,
+    0x0030c00000000000ull, 0x0031700000000000ull, 0x0033a00000000000ull,
+    0x0032100000000000ull, 0x003b800000000000ull, 0x003a300000000000ull,
+    0x0038e00000000000ull, 0x0039500000000000ull, 0x003d400000000000ull,
+    0x003cf00000000000ull, 0x003e200000000000ull, 0x003f900000000000ull,
+    0x002d000000000000ull, 0x002cb00000000000ull, 0x002e600000000000ull,
+    0x002fd00000000000ull, 0x002bc00000000000ull, 0x002a700000000000ull,
+    0x0028a00000000000ull, 0x0029100000000000ull, 0x0020800000000000ull,
+    0x0021300000000000ull, 0x0023e00000000000ull, 0x0022500000000000ull,
+    0x0026400000000000ull, 0x0027f00000000000ull, 0x0025200000000000ull,
+    0x0024900000000000ull, 0x006c000000000000ull, 0x006db00000000000ull,
+    0x006f600000000000ull, 0x006ed00000000000ull, 0x006ac00000000000ull,
+    0x006b700000000000ull, 0x0069a00000000000ull, 0x0068100000000000ull,
+    0x0061800000000000ull, 0x0060300000000000ull, 0x0062e00000000000ull,
+    0x0063500000000000ull, 0x0067400000000000ull, 0x0066f00000000000ull,
+    0x0064200000000000ull, 0x0065900000000000ull, 0x0077000000000000ull,
+    0x0076b00000000000ull, 0x0074600000000000ull, 0x0075d00000000000ull,
+    0x0071c00000000000ull, 0x0070700000000000ull, 0x0072a00000000000ull,
+    0x0073100000000000ull, 0x007a800000000000ull, 0x007b300000000000ull,
+    0x0079e00000000000ull, 0x0078500000000000ull, 0x007c400000000000ull,
+    0x007df00000000000ull, 0x007f200000000000ull, 0x007e900000000000ull,
+    0x005a000000000000ull, 0x005bb00000000000ull, 0x0059600000000000ull,
+    0x0058d00000000000ull, 0x005cc00000000000ull, 0x005d700000000000ull,
+    0x005fa00000000000ull, 0x005e100000000000ull, 0x0057800000000000ull,
+    0x0056300000000000ull, 0x0054e00000000000ull, 0x0055500000000000ull,
+    0x0051400000000000ull, 0x0050f00000000000ull, 0x0052200000000000ull,
+    0x0053900000000000ull, 0x0041000000000000ull, 0x0040b00000000000ull,
+    0x0042600000000000ull, 0x0043d00000000000ull, 0x0047c00000000000ull,
+    0x0046700000000000ull, 0x0044a00000000000ull, 0x0045100000000000ull,
+    0x004c800000000000ull, 0x004d300000000000ull, 0x004fe00000000000ull,
+    0x004e500000000000ull, 0x004a400000000000ull, 0x004bf00000000000ull,
+    0x0049200000000000ull, 0x0048900000000000ull, 0x00d8000000000000ull,
+    0x00d9b00000000000ull, 0x00db600000000000ull, 0x00dad00000000000ull,
+    0x00dec00000000000ull, 0x00df700000000000ull, 0x00dda00000000000ull,
+    0x00dc100000000000ull, 0x00d5800000000000ull, 0x00d4300000000000ull,
+    0x00d6e00000000000ull, 0x00d7500000000000ull, 0x00d3400000000000ull,
+    0x00d2f00000000000ull, 0x00d0200000000000ull, 0x00d1900000000000ull,
+    0x00c3000000000000ull, 0x00c2b00000000000ull, 0x00c0600000000000ull,
+    0x00c1d00000000000ull, 0x00c5c00000000000ull, 0x00c4700000000000ull,
+    0x00c6a00000000000ull, 0x00c7100000000000ull, 0x00ce800000000000ull,
+    0x00cf300000000000ull, 0x00cde00000000000ull, 0x00cc500000000000ull,
+    0x00c8400000000000ull, 0x00c9f00000000000ull, 0x00cb200000000000ull,
+    0x00ca900000000000ull, 0x00ee000000000000ull, 0x00efb00000000000ull,
+    0x00ed600000000000ull, 0x00ecd00000000000ull, 0x00e8c00000000000ull,
+    0x00e9700000000000ull, 0x00eba00000000000ull, 0x00ea100000000000ull,
+    0x00e3800000000000ull, 0x00e2300000000000ull, 0x00e0e00000000000ull,
+    0x00e1500000000000ull, 0x00e5400000000000ull, 0x00e4f00000000000ull,
+    0x00e6200000000000ull, 0x00e7900000000000ull, 0x00f5000000000000ull,
+    0x00f4b00000000000ull, 0x00f6600000000000ull, 0x00f7d00000000000ull,
+    0x00f3c00000000000ull, 0x00f2700000000000ull, 0x00f0a00000000000ull,
+    0x00f1100000000000ull, 0x00f8800000000000ull, 0x00f9300000000000ull,
+    0x00fbe00000000000ull, 0x00fa500000000000ull, 0x00fe400000000000ull,
+    0x00fff00000000000ull, 0x00fd200000000000ull, 0x00fc900000000000ull,
+    0x00b4000000000000ull, 0x00b5b00000000000ull, 0x00b7600000000000ull,
+    0x00b6d00000000000ull, 0x00b2c00000000000ull, 0x00b3700000000000ull,
+    0x00b1a00000000000ull, 0x00b0100000000000ull, 0x00b9800000000000ull,
+    0x00b8300000000000ull, 0x00bae00000000000ull, 0x00bb500000000000ull,
+    0x00bf400000000000ull, 0x00bef00000000000ull, 0x00bc200000000000ull,
+    0x00bd900000000000ull, 0x00af000000000000ull, 0x00aeb00000000000ull,
+    0x00ac600000000000ull, 0x00add00000000000ull, 0x00a9c00000000000ull,
+    0x00a8700000000000ull, 0x00aaa00000000000ull, 0x00ab100000000000ull,
+    0x00a2800000000000ull, 0x00a3300000000000ull, 0x00a1e00000000000ull,
+    0x00a0500000000000ull, 0x00a4400000000000ull, 0x00a5f00000000000ull,
+    0x00a7200000000000ull, 0x00a6900000000000ull, 0x0082000000000000ull,
+    0x0083b00000000000ull, 0x0081600000000000ull, 0x0080d00000000000ull,
+    0x0084c00000000000ull, 0x0085700000000000ull, 0x0087a00000000000ull,
+    0x0086100000000000ull, 0x008f800000000000ull, 0x008e300000000000ull,
+    0x008ce00000000000ull, 0x008d500000000000ull, 0x0089400000000000ull,
+    0x0088f00000000000ull, 0x008a200000000000ull, 0x008b900000000000ull,
+    0x0099000000000000ull, 0x0098b00000000000ull, 0x009a600000000000ull,
+    0x009bd00000000000ull, 0x009fc00000000000ull, 0x009e700000000000ull,
+    0x009ca00000000000ull, 0x009d100000000000ull, 0x0094800000000000ull,
+    0x0095300000000000ull, 0x0097e00000000000ull, 0x0096500000000000ull,
+    0x0092400000000000ull, 0x0093f00000000000ull, 0x0091200000000000ull,
+    0x0090900000000000ull
+  },
+  {
+    0x0000000000000000ull, 0x000001b000000000ull, 0x0000036000000000ull,
+    0x000002d000000000ull, 0x000006c000000000ull, 0x0000077000000000ull,
+    0x000005a000000000ull, 0x0000041000000000ull, 0x00000d8000000000ull,
+    0x00000c3000000000ull, 0x00000ee000000000ull, 0x00000f5000000000ull,
+    0x00000b4000000000ull, 0x00000af000000000ull, 0x0000082000000000ull,
+    0x0000099000000000ull, 0x00001b0000000000ull, 0x00001ab000000000ull,
+    0x0000186000000000ull, 0x000019d000000000ull, 0x00001dc000000000ull,
+    0x00001c7000000000ull, 0x00001ea000000000ull, 0x00001f1000000000ull,
+    0x0000168000000000ull, 0x0000173000000000ull, 0x000015e000000000ull,
+    0x0000145000000000ull, 0x0000104000000000ull, 0x000011f000000000ull,
+    0x0000132000000000ull, 0x0000129000000000ull, 0x0000360000000000ull,
+    0x000037b000000000ull, 0x0000356000000000ull, 0x000034d000000000ull,
+    0x000030c000000000ull, 0x0000317000000000ull, 0x000033a000000000ull,
+    0x0000321000000000ull, 0x00003b8000000000ull, 0x00003a3000000000ull,
+    0x000038e000000000ull, 0x0000395000000000ull, 0x00003d4000000000ull,
+    0x00003cf000000000ull, 0x00003e2000000000ull, 0x00003f9000000000ull,
+    0x00002d0000000000ull, 0x00002cb000000000ull, 0x00002e6000000000ull,
+    0x00002fd000000000ull, 0x00002bc000000000ull, 0x00002a7000000000ull,
+    0x000028a000000000ull, 0x0000291000000000ull, 0x0000208000000000ull,
+    0x0000213000000000ull, 0x000023e000000000ull, 0x0000225000000000ull,
+    0x0000264000000000ull, 0x000027f000000000ull, 0x0000252000000000ull,
+    0x0000249000000000ull, 0x00006c0000000000ull, 0x00006db000000000ull,
+    0x00006f6000000000ull, 0x00006ed000000000ull, 0x00006ac000000000ull,
+    0x00006b7000000000ull, 0x000069a000000000ull, 0x0000681000000000ull,
+    0x0000618000000000ull, 0x0000603000000000ull, 0x000062e000000000ull,
+    0x0000635000000000ull, 0x0000674000000000ull, 0x000066f000000000ull,
+    0x0000642000000000ull, 0x0000659000000000ull, 0x0000770000000000ull,
+    0x000076b000000000ull, 0x0000746000000000ull, 0x000075d000000000ull,
+    0x000071c000000000ull, 0x0000707000000000ull, 0x000072a000000000ull,
+    0x0000731000000000ull, 0x00007a8000000000ull, 0x00007b3000000000ull,
+    0x000079e000000000ull, 0x0000785000000000ull, 0x00007c4000000000ull,
+    0x00007df000000000ull, 0x00007f2000000000ull, 0x00007e9000000000ull,
+    0x00005a0000000000ull, 0x00005bb000000000ull, 0x0000596000000000ull,
+    0x000058d000000000ull, 0x00005cc000000000ull, 0x00005d7000000000ull,
+    0x00005fa000000000ull, 0x00005e1000000000ull, 0x0000578000000000ull,
+    0x0000563000000000ull, 0x000054e000000000ull, 0x0000555000000000ull,
+    0x0000514000000000ull, 0x000050f000000000ull, 0x0000522000000000ull,
+    0x0000539000000000ull, 0x0000410000000000ull, 0x000040b000000000ull,
+    0x0000426000000000ull, 0x000043d000000000ull, 0x000047c000000000ull,
+    0x0000467000000000ull, 0x000044a000000000ull, 0x0000451000000000ull,
+    0x00004c8000000000ull, 0x00004d3000000000ull, 0x00004fe000000000ull,
+    0x00004e5000000000ull, 0x00004a4000000000ull, 0x00004bf000000000ull,
+    0x0000492000000000ull, 0x0000489000000000ull, 0x0000d80000000000ull,
+    0x0000d9b000000000ull, 0x0000db6000000000ull, 0x0000dad000000000ull,
+    0x0000dec000000000ull, 0x0000df7000000000ull, 0x0000dda000000000ull,
+    0x0000dc1000000000ull, 0x0000d58000000000ull, 0x0000d43000000000ull,
+    0x0000d6e000000000ull, 0x0000d75000000000ull, 0x0000d34000000000ull,
+    0x0000d2f000000000ull, 0x0000d02000000000ull, 0x0000d19000000000ull,
+    0x0000c30000000000ull, 0x0000c2b000000000ull, 0x0000c06000000000ull,
+    0x0000c1d000000000ull, 0x0000c5c000000000ull, 0x0000c47000000000ull,
+    0x0000c6a000000000ull, 0x0000c71000000000ull, 0x0000ce8000000000ull,
+    0x0000cf3000000000ull, 0x0000cde000000000ull, 0x0000cc5000000000ull,
+    0x0000c84000000000ull, 0x0000c9f000000000ull, 0x0000cb2000000000ull,
+    0x0000ca9000000000ull, 0x0000ee0000000000ull, 0x0000efb000000000ull,
+    0x0000ed6000000000ull, 0x0000ecd000000000ull, 0x0000e8c000000000ull,
+    0x0000e97000000000ull, 0x0000eba000000000ull, 0x0000ea1000000000ull,
+    0x0000e38000000000ull, 0x0000e23000000000ull, 0x0000e0e000000000ull,
+    0x0000e15000000000ull, 0x0000e54000000000ull, 0x0000e4f000000000ull,
+    0x0000e62000000000ull, 0x0000e79000000000ull, 0x0000f50000000000ull,
+    0x0000f4b000000000ull, 0x0000f66000000000ull, 0x0000f7d000000000ull,
+    0x0000f3c000000000ull, 0x0000f27000000000ull, 0x0000f0a000000000ull,
+    0x0000f11000000000ull, 0x0000f88000000000ull, 0x0000f93000000000ull,
+    0x0000fbe000000000ull, 0x0000fa5000000000ull, 0x0000fe4000000000ull,
+    0x0000fff000000000ull, 0x0000fd2000000000ull, 0x0000fc9000000000ull,
+    0x0000b40000000000ull, 0x0000b5b000000000ull, 0x0000b76000000000ull,
+    0x0000b6d000000000ull, 0x0000b2c000000000ull, 0x0000b37000000000ull,
+    0x0000b1a000000000ull, 0x0000b01000000000ull, 0x0000b98000000000ull,
+    0x0000b83000000000ull, 0x0000bae000000000ull, 0x0000bb5000000000ull,
+    0x0000bf4000000000ull, 0x0000bef000000000ull, 0x0000bc2000000000ull,
+    0x0000bd9000000000ull, 0x0000af0000000000ull, 0x0000aeb000000000ull,
+    0x0000ac6000000000ull, 0x0000add000000000ull, 0x0000a9c000000000ull,
+    0x0000a87000000000ull, 0x0000aaa000000000ull, 0x0000ab1000000000ull,
+    0x0000a28000000000ull, 0x0000a33000000000ull, 0x0000a1e000000000ull,
+    0x0000a05000000000ull, 0x0000a44000000000ull, 0x0000a5f000000000ull,
+    0x0000a72000000000ull, 0x0000a69000000000ull, 0x0000820000000000ull,
+    0x000083b000000000ull, 0x0000816000000000ull, 0x000080d000000000ull,
+    0x000084c000000000ull, 0x0000857000000000ull, 0x000087a000000000ull,
+    0x0000861000000000ull, 0x00008f8000000000ull, 0x00008e3000000000ull,
+    0x00008ce000000000ull, 0x00008d5000000000ull, 0x0000894000000000ull,
+    0x000088f000000000ull, 0x00008a2000000000ull, 0x00008b9000000000ull,
+    0x0000990000000000ull, 0x000098b000000000ull, 0x00009a6000000000ull,
+    0x00009bd000000000ull, 0x00009fc000000000ull, 0x00009e7000000000ull,
+    0x00009ca000000000ull, 0x00009d1000000000ull, 0x0000948000000000ull,
+    0x0000953000000000ull, 0x000097e000000000ull, 0x0000965000000000ull,
+    0x0000924000000000ull, 0x000093f000000000ull, 0x0000912000000000ull,
+    0x0000909000000000ull
+  },
+  {
+    0x0000000000000000ull, 0x00000001b0000000ull, 0x0000000360000000ull,
+    0x00000002d0000000ull, 0x00000006c0000000ull, 0x0000000770000000ull,
+    0x00000005a0000000ull, 0x0000000410000000ull, 0x0000000d80000000ull,
+    0x0000000c30000000ull, 0x0000000ee0000000ull, 0x0000000f50000000ull,
+    0x0000000b40000000ull, 0x0000000af0000000ull, 0x0000000820000000ull,
+    0x0000000990000000ull, 0x0000001b00000000ull, 0x0000001ab0000000ull,
+    0x0000001860000000ull, 0x00000019d0000000ull, 0x0000001dc0000000ull,
+    0x0000001c70000000ull, 0x0000001ea0000000ull, 0x0000001f10000000ull,
+    0x0000001680000000ull, 0x0000001730000000ull, 0x00000015e0000000ull,
+    0x0000001450000000ull, 0x0000001040000000ull, 0x00000011f0000000ull,
+    0x0000001320000000ull, 0x0000001290000000ull, 0x0000003600000000ull,
+    0x00000037b0000000ull, 0x0000003560000000ull, 0x00000034d0000000ull,
+    0x00000030c0000000ull, 0x0000003170000000ull, 0x00000033a0000000ull,
+    0x0000003210000000ull, 0x0000003b80000000ull, 0x0000003a30000000ull,
+    0x00000038e0000000ull, 0x0000003950000000ull, 0x0000003d40000000ull,
+    0x0000003cf0000000ull, 0x0000003e20000000ull, 0x0000003f90000000ull,
+    0x0000002d00000000ull, 0x0000002cb0000000ull, 0x0000002e60000000ull,
+    0x0000002fd0000000ull, 0x0000002bc0000000ull, 0x0000002a70000000ull,
+    0x00000028a0000000ull, 0x0000002910000000ull, 0x0000002080000000ull,
+    0x0000002130000000ull, 0x00000023e0000000ull, 0x0000002250000000ull,
+    0x0000002640000000ull, 0x00000027f0000000ull, 0x0000002520000000ull,
+    0x0000002490000000ull, 0x0000006c00000000ull, 0x0000006db0000000ull,
+    0x0000006f60000000ull, 0x0000006ed0000000ull, 0x0000006ac0000000ull,
+    0x0000006b70000000ull, 0x00000069a0000000ull, 0x0000006810000000ull,
+    0x0000006180000000ull, 0x0000006030000000ull, 0x00000062e0000000ull,
+    0x0000006350000000ull, 0x0000006740000000ull, 0x00000066f0000000ull,
+    0x0000006420000000ull, 0x0000006590000000ull, 0x0000007700000000ull,
+    0x00000076b0000000ull, 0x0000007460000000ull, 0x00000075d0000000ull,
+    0x00000071c0000000ull, 0x0000007070000000ull, 0x00000072a0000000ull,
+    0x0000007310000000ull, 0x0000007a80000000ull, 0x0000007b30000000ull,
+    0x00000079e0000000ull, 0x0000007850000000ull, 0x0000007c40000000ull,
+    0x0000007df0000000ull, 0x0000007f20000000ull, 0x0000007e90000000ull,
+    0x0000005a00000000ull, 0x0000005bb0000000ull, 0x0000005960000000ull,
+    0x00000058d0000000ull, 0x0000005cc0000000ull, 0x0000005d70000000ull,
+    0x0000005fa0000000ull, 0x0000005e10000000ull, 0x0000005780000000ull,
+    0x0000005630000000ull, 0x00000054e0000000ull, 0x0000005550000000ull,
+    0x0000005140000000ull, 0x00000050f0000000ull, 0x0000005220000000ull,
+    0x0000005390000000ull, 0x0000004100000000ull, 0x00000040b0000000ull,
+    0x0000004260000000ull, 0x00000043d0000000ull, 0x00000047c0000000ull,
+    0x0000004670000000ull, 0x00000044a0000000ull, 0x0000004510000000ull,
+    0x0000004c80000000ull, 0x0000004d30000000ull, 0x0000004fe0000000ull,
+    0x0000004e50000000ull, 0x0000004a40000000ull, 0x0000004bf0000000ull,
+    0x0000004920000000ull, 0x0000004890000000ull, 0x000000d800000000ull,
+    0x000000d9b0000000ull, 0x000000db60000000ull, 0x000000dad0000000ull,
+    0x000000dec0000000ull, 0x000000df70000000ull, 0x000000dda0000000ull,
+    0x000000dc10000000ull, 0x000000d580000000ull, 0x000000d430000000ull,
+    0x000000d6e0000000ull, 0x000000d750000000ull, 0x000000d340000000ull,
+    0x000000d2f0000000ull, 0x000000d020000000ull, 0x000000d190000000ull,
+    0x000000c300000000ull, 0x000000c2b0000000ull, 0x000000c060000000ull,
+    0x000000c1d0000000ull, 0x000000c5c0000000ull, 0x000000c470000000ull,
+    0x000000c6a0000000ull, 0x000000c710000000ull, 0x000000ce80000000ull,
+    0x000000cf30000000ull, 0x000000cde0000000ull, 0x000000cc50000000ull,
+    0x000000c840000000ull, 0x000000c9f0000000ull, 0x000000cb20000000ull,
+    0x000000ca90000000ull, 0x000000ee00000000ull, 0x000000efb0000000ull,
+    0x000000ed60000000ull, 0x000000ecd0000000ull, 0x000000e8c0000000ull,
+    0x000000e970000000ull, 0x000000eba0000000ull, 0x000000ea10000000ull,
+    0x000000e380000000ull, 0x000000e230000000ull, 0x000000e0e0000000ull,
+    0x000000e150000000ull, 0x000000e540000000ull, 0x000000e4f0000000ull,
+    0x000000e620000000ull, 0x000000e790000000ull, 0x000000f500000000ull,
+    0x000000f4b0000000ull, 0x000000f660000000ull, 0x000000f7d0000000ull,
+    0x000000f3c0000000ull, 0x000000f270000000ull, 0x000000f0a0000000ull,
+    0x000000f110000000ull, 0x000000f880000000ull, 0x000000f930000000ull,
+    0x000000fbe0000000ull, 0x000000fa50000000ull, 0x000000fe40000000ull,
+    0x000000fff0000000ull, 0x000000fd20000000ull, 0x000000fc90000000ull,
+    0x000000b400000000ull, 0x000000b5b0000000ull, 0x000000b760000000ull,
+    0x000000b6d0000000ull, 0x000000b2c0000000ull, 0x000000b370000000ull,
+    0x000000b1a0000000ull, 0x000000b010000000ull, 0x000000b980000000ull,
+    0x000000b830000000ull, 0x000000bae0000000ull, 0x000000bb50000000ull,
+    0x000000bf40000000ull, 0x000000bef0000000ull, 0x000000bc20000000ull,
+    0x000000bd90000000ull, 0x000000af00000000ull, 0x000000aeb0000000ull,
+    0x000000ac60000000ull, 0x000000add0000000ull, 0x000000a9c0000000ull,
+    0x000000a870000000ull, 0x000000aaa0000000ull, 0x000000ab10000000ull,
+    0x000000a280000000ull, 0x000000a330000000ull, 0x000000a1e0000000ull,
+    0x000000a050000000ull, 0x000000a440000000ull, 0x000000a5f0000000ull,
+    0x000000a720000000ull, 0x000000a690000000ull, 0x0000008200000000ull,
+    0x00000083b0000000ull, 0x0000008160000000ull, 0x00000080d0000000ull,
+    0x00000084c0000000ull, 0x0000008570000000ull, 0x00000087a0000000ull,
+    0x0000008610000000ull, 0x0000008f80000000ull, 0x0000008e30000000ull,
+    0x0000008ce0000000ull, 0x0000008d50000000ull, 0x0000008940000000ull,
+    0x00000088f0000000ull, 0x0000008a20000000ull, 0x0000008b90000000ull,
+    0x0000009900000000ull, 0x00000098b0000000ull, 0x0000009a60000000ull,
+    0x0000009bd0000000ull, 0x0000009fc0000000ull, 0x0000009e70000000ull,
+    0x0000009ca0000000ull, 0x0000009d10000000ull, 0x0000009480000000ull,
+    0x0000009530000000ull, 0x00000097e0000000ull, 0x0000009650000000ull,
+    0x0000009240000000ull, 0x00000093f0000000ull, 0x0000009120000000ull,
+    0x0000009090000000ull
+  },
+  {
+    0x0000000000000000ull, 0x0000000001b00000ull, 0x0000000003600000ull,
+    0x0000000002d00000ull, 0x0000000006c00000ull, 0x0000000007700000ull,
+    0x0000000005a00000ull, 0x0000000004100000ull, 0x000000000d800000ull,
+    0x000000000c300000ull, 0x000000000ee00000ull, 0x000000000f500000ull,
+    0x000000000b400000ull, 0x000000000af00000ull, 0x0000000008200000ull,
+    0x0000000009900000ull, 0x000000001b000000ull, 0x000000001ab00000ull,
+    0x0000000018600000ull, 0x0000000019d00000ull, 0x000000001dc00000ull,
+    0x000000001c700000ull, 0x000000001ea00000ull, 0x000000001f100000ull,
+    0x0000000016800000ull, 0x0000000017300000ull, 0x0000000015e00000ull,
+    0x0000000014500000ull, 0x0000000010400000ull, 0x0000000011f00000ull,
+    0x0000000013200000ull, 0x0000000012900000ull, 0x0000000036000000ull,
+    0x0000000037b00000ull, 0x0000000035600000ull, 0x0000000034d00000ull,
+    0x0000000030c00000ull, 0x0000000031700000ull, 0x0000000033a00000ull,
+    0x0000000032100000ull, 0x000000003b800000ull, 0x000000003a300000ull,
+    0x0000000038e00000ull, 0x0000000039500000ull, 0x000000003d400000ull,
+    0x000000003cf00000ull, 0x000000003e200000ull, 0x000000003f900000ull,
+    0x000000002d000000ull, 0x000000002cb00000ull, 0x000000002e600000ull,
+    0x000000002fd00000ull, 0x000000002bc00000ull, 0x000000002a700000ull,
+    0x0000000028a00000ull, 0x0000000029100000ull, 0x0000000020800000ull,
+    0x0000000021300000ull, 0x0000000023e00000ull, 0x0000000022500000ull,
+    0x0000000026400000ull, 0x0000000027f00000ull, 0x0000000025200000ull,
+    0x0000000024900000ull, 0x000000006c000000ull, 0x000000006db00000ull,
+    0x000000006f600000ull, 0x000000006ed00000ull, 0x000000006ac00000ull,
+    0x000000006b700000ull, 0x0000000069a00000ull, 0x0000000068100000ull,
+    0x0000000061800000ull, 0x0000000060300000ull, 0x0000000062e00000ull,
+    0x0000000063500000ull, 0x0000000067400000ull, 0x0000000066f00000ull,
+    0x0000000064200000ull, 0x0000000065900000ull, 0x0000000077000000ull,
+    0x0000000076b00000ull, 0x0000000074600000ull, 0x0000000075d00000ull,
+    0x0000000071c00000ull, 0x0000000070700000ull, 0x0000000072a00000ull,
+    0x0000000073100000ull, 0x000000007a800000ull, 0x000000007b300000ull,
+    0x0000000079e00000ull, 0x0000000078500000ull, 0x000000007c400000ull,
+    0x000000007df00000ull, 0x000000007f200000ull, 0x000000007e900000ull,
+    0x000000005a000000ull, 0x000000005bb00000ull, 0x0000000059600000ull,
+    0x0000000058d00000ull, 0x000000005cc00000ull, 0x000000005d700000ull,
+    0x000000005fa00000ull, 0x000000005e100000ull, 0x0000000057800000ull,
+    0x0000000056300000ull, 0x0000000054e00000ull, 0x0000000055500000ull,
+    0x0000000051400000ull, 0x0000000050f00000ull, 0x0000000052200000ull,
+    0x0000000053900000ull, 0x0000000041000000ull, 0x0000000040b00000ull,
+    0x0000000042600000ull, 0x0000000043d00000ull, 0x0000000047c00000ull,
+    0x0000000046700000ull, 0x0000000044a00000ull, 0x0000000045100000ull,
+    0x000000004c800000ull, 0x000000004d300000ull, 0x000000004fe00000ull,
+    0x000000004e500000ull, 0x000000004a400000ull, 0x000000004bf00000ull,
+    0x0000000049200000ull, 0x0000000048900000ull, 0x00000000d8000000ull,
+    0x00000000d9b00000ull, 0x00000000db600000ull, 0x00000000dad00000ull,
+    0x00000000dec00000ull, 0x00000000df700000ull, 0x00000000dda00000ull,
+    0x00000000dc100000ull, 0x00000000d5800000ull, 0x00000000d4300000ull,
+    0x00000000d6e00000ull, 0x00000000d7500000ull, 0x00000000d3400000ull,
+    0x00000000d2f00000ull, 0x00000000d0200000ull, 0x00000000d1900000ull,
+    0x00000000c3000000ull, 0x00000000c2b00000ull, 0x00000000c0600000ull,
+    0x00000000c1d00000ull, 0x00000000c5c00000ull, 0x00000000c4700000ull,
+    0x00000000c6a00000ull, 0x00000000c7100000ull, 0x00000000ce800000ull,
+    0x00000000cf300000ull, 0x00000000cde00000ull, 0x00000000cc500000ull,
+    0x00000000c8400000ull, 0x00000000c9f00000ull, 0x00000000cb200000ull,
+    0x00000000ca900000ull, 0x00000000ee000000ull, 0x00000000efb00000ull,
+    0x00000000ed600000ull, 0x00000000ecd00000ull, 0x00000000e8c00000ull,
+    0x00000000e9700000ull, 0x00000000eba00000ull, 0x00000000ea100000ull,
+    0x00000000e3800000ull, 0x00000000e2300000ull, 0x00000000e0e00000ull,
+    0x00000000e1500000ull, 0x00000000e5400000ull, 0x00000000e4f00000ull,
+    0x00000000e6200000ull, 0x00000000e7900000ull, 0x00000000f5000000ull,
+    0x00000000f4b00000ull, 0x00000000f6600000ull, 0x00000000f7d00000ull,
+    0x00000000f3c00000ull, 0x00000000f2700000ull, 0x00000000f0a00000ull,
+    0x00000000f1100000ull, 0x00000000f8800000ull, 0x00000000f9300000ull,
+    0x00000000fbe00000ull, 0x00000000fa500000ull, 0x00000000fe400000ull,
+    0x00000000fff00000ull, 0x00000000fd200000ull, 0x00000000fc900000ull,
+    0x00000000b4000000ull, 0x00000000b5b00000ull, 0x00000000b7600000ull,
+    0x00000000b6d00000ull, 0x00000000b2c00000ull, 0x00000000b3700000ull,
+    0x00000000b1a00000ull, 0x00000000b0100000ull, 0x00000000b9800000ull,
+    0x00000000b8300000ull, 0x00000000bae00000ull, 0x00000000bb500000ull,
+    0x00000000bf400000ull, 0x00000000bef00000ull, 0x00000000bc200000ull,
+    0x00000000bd900000ull, 0x00000000af000000ull, 0x00000000aeb00000ull,
+    0x00000000ac600000ull, 0x00000000add00000ull, 0x00000000a9c00000ull,
+    0x00000000a8700000ull, 0x00000000aaa00000ull, 0x00000000ab100000ull,
+    0x00000000a2800000ull, 0x00000000a3300000ull, 0x00000000a1e00000ull,
+    0x00000000a0500000ull, 0x00000000a4400000ull, 0x00000000a5f00000ull,
+    0x00000000a7200000ull, 0x00000000a6900000ull, 0x0000000082000000ull,
+    0x0000000083b00000ull, 0x0000000081600000ull, 0x0000000080d00000ull,
+    0x0000000084c00000ull, 0x0000000085700000ull, 0x0000000087a00000ull,
+    0x0000000086100000ull, 0x000000008f800000ull, 0x000000008e300000ull,
+    0x000000008ce00000ull, 0x000000008d500000ull, 0x0000000089400000ull,
+    0x0000000088f00000ull, 0x000000008a200000ull, 0x000000008b900000ull,
+    0x0000000099000000ull, 0x0000000098b00000ull, 0x000000009a600000ull,
+    0x000000009bd00000ull, 0x000000009fc00000ull, 0x000000009e700000ull,
+    0x000000009ca00000ull, 0x000000009d100000ull, 0x0000000094800000ull,
+    0x0000000095300000ull, 0x0000000097e00000ull, 0x0000000096500000ull,
+    0x0000000092400000ull, 0x0000000093f00000ull, 0x0000000091200000ull,
+    0x0000000090900000ull
+  },
+  {
+    0x0000000000000000ull, 0x000000000001b000ull, 0x0000000000036000ull,
+    0x000000000002d000ull, 0x000000000006c000ull, 0x0000000000077000ull,
+    0x000000000005a000ull, 0x0000000000041000ull, 0x00000000000d8000ull,
+    0x00000000000c3000ull, 0x00000000000ee000ull, 0x00000000000f5000ull,
+    0x00000000000b4000ull, 0x00000000000af000ull, 0x0000000000082000ull,
+    0x0000000000099000ull, 0x00000000001b0000ull, 0x00000000001ab000ull,
+    0x0000000000186000ull, 0x000000000019d000ull, 0x00000000001dc000ull,
+    0x00000000001c7000ull, 0x00000000001ea000ull, 0x00000000001f1000ull,
+    0x0000000000168000ull, 0x0000000000173000ull, 0x000000000015e000ull,
+    0x0000000000145000ull, 0x0000000000104000ull, 0x000000000011f000ull,
+    0x0000000000132000ull, 0x0000000000129000ull, 0x0000000000360000ull,
+    0x000000000037b000ull, 0x0000000000356000ull, 0x000000000034d000ull,
+    0x000000000030c000ull, 0x0000000000317000ull, 0x000000000033a000ull,
+    0x0000000000321000ull, 0x00000000003b8000ull, 0x00000000003a3000ull,
+    0x000000000038e000ull, 0x0000000000395000ull, 0x00000000003d4000ull,
+    0x00000000003cf000ull, 0x00000000003e2000ull, 0x00000000003f9000ull,
+    0x00000000002d0000ull, 0x00000000002cb000ull, 0x00000000002e6000ull,
+    0x00000000002fd000ull, 0x00000000002bc000ull, 0x00000000002a7000ull,
+    0x000000000028a000ull, 0x0000000000291000ull, 0x0000000000208000ull,
+    0x0000000000213000ull, 0x000000000023e000ull, 0x0000000000225000ull,
+    0x0000000000264000ull, 0x000000000027f000ull, 0x0000000000252000ull,
+    0x0000000000249000ull, 0x00000000006c0000ull, 0x00000000006db000ull,
+    0x00000000006f6000ull, 0x00000000006ed000ull, 0x00000000006ac000ull,
+    0x00000000006b7000ull, 0x000000000069a000ull, 0x0000000000681000ull,
+    0x0000000000618000ull, 0x0000000000603000ull, 0x000000000062e000ull,
+    0x0000000000635000ull, 0x0000000000674000ull, 0x000000000066f000ull,
+    0x0000000000642000ull, 0x0000000000659000ull, 0x0000000000770000ull,
+    0x000000000076b000ull, 0x0000000000746000ull, 0x000000000075d000ull,
+    0x000000000071c000ull, 0x0000000000707000ull, 0x000000000072a000ull,
+    0x0000000000731000ull, 0x00000000007a8000ull, 0x00000000007b3000ull,
+    0x000000000079e000ull, 0x0000000000785000ull, 0x00000000007c4000ull,
+    0x00000000007df000ull, 0x00000000007f2000ull, 0x00000000007e9000ull,
+    0x00000000005a0000ull, 0x00000000005bb000ull, 0x0000000000596000ull,
+    0x000000000058d000ull, 0x00000000005cc000ull, 0x00000000005d7000ull,
+    0x00000000005fa000ull, 0x00000000005e1000ull, 0x0000000000578000ull,
+    0x0000000000563000ull, 0x000000000054e000ull, 0x0000000000555000ull,
+    0x0000000000514000ull, 0x000000000050f000ull, 0x0000000000522000ull,
+    0x0000000000539000ull, 0x0000000000410000ull, 0x000000000040b000ull,
+    0x0000000000426000ull, 0x000000000043d000ull, 0x000000000047c000ull,
+    0x0000000000467000ull, 0x000000000044a000ull, 0x0000000000451000ull,
+    0x00000000004c8000ull, 0x00000000004d3000ull, 0x00000000004fe000ull,
+    0x00000000004e5000ull, 0x00000000004a4000ull, 0x00000000004bf000ull,
+    0x0000000000492000ull, 0x0000000000489000ull, 0x0000000000d80000ull,
+    0x0000000000d9b000ull, 0x0000000000db6000ull, 0x0000000000dad000ull,
+    0x0000000000dec000ull, 0x0000000000df7000ull, 0x0000000000dda000ull,
+    0x0000000000dc1000ull, 0x0000000000d58000ull, 0x0000000000d43000ull,
+    0x0000000000d6e000ull, 0x0000000000d75000ull, 0x0000000000d34000ull,
+    0x0000000000d2f000ull, 0x0000000000d02000ull, 0x0000000000d19000ull,
+    0x0000000000c30000ull, 0x0000000000c2b000ull, 0x0000000000c06000ull,
+    0x0000000000c1d000ull, 0x0000000000c5c000ull, 0x0000000000c47000ull,
+    0x0000000000c6a000ull, 0x0000000000c71000ull, 0x0000000000ce8000ull,
+    0x0000000000cf3000ull, 0x0000000000cde000ull, 0x0000000000cc5000ull,
+    0x0000000000c84000ull, 0x0000000000c9f000ull, 0x0000000000cb2000ull,
+    0x0000000000ca9000ull, 0x0000000000ee0000ull, 0x0000000000efb000ull,
+    0x0000000000ed6000ull, 0x0000000000ecd000ull, 0x0000000000e8c000ull,
+    0x0000000000e97000ull, 0x0000000000eba000ull, 0x0000000000ea1000ull,
+    0x0000000000e38000ull, 0x0000000000e23000ull, 0x0000000000e0e000ull,
+    0x0000000000e15000ull, 0x0000000000e54000ull, 0x0000000000e4f000ull,
+    0x0000000000e62000ull, 0x0000000000e79000ull, 0x0000000000f50000ull,
+    0x0000000000f4b000ull, 0x0000000000f66000ull, 0x0000000000f7d000ull,
+    0x0000000000f3c000ull, 0x0000000000f27000ull, 0x0000000000f0a000ull,
+    0x0000000000f11000ull, 0x0000000000f88000ull, 0x0000000000f93000ull,
+    0x0000000000fbe000ull, 0x0000000000fa5000ull, 0x0000000000fe4000ull,
+    0x0000000000fff000ull, 0x0000000000fd2000ull, 0x0000000000fc9000ull,
+    0x0000000000b40000ull, 0x0000000000b5b000ull, 0x0000000000b76000ull,
+    0x0000000000b6d000ull, 0x0000000000b2c000ull, 0x0000000000b37000ull,
+    0x0000000000b1a000ull, 0x0000000000b01000ull, 0x0000000000b98000ull,
+    0x0000000000b83000ull, 0x0000000000bae000ull, 0x0000000000bb5000ull,
+    0x0000000000bf4000ull, 0x0000000000bef000ull, 0x0000000000bc2000ull,
+    0x0000000000bd9000ull, 0x0000000000af0000ull, 0x0000000000aeb000ull,
+    0x0000000000ac6000ull, 0x0000000000add000ull, 0x0000000000a9c000ull,
+    0x0000000000a87000ull, 0x0000000000aaa000ull, 0x0000000000ab1000ull,
+    0x0000000000a28000ull, 0x0000000000a33000ull, 0x0000000000a1e000ull,
+    0x0000000000a05000ull, 0x0000000000a44000ull, 0x0000000000a5f000ull,
+    0x0000000000a72000ull, 0x0000000000a69000ull, 0x0000000000820000ull,
+    0x000000000083b000ull, 0x0000000000816000ull, 0x000000000080d000ull,
+    0x000000000084c000ull, 0x0000000000857000ull, 0x000000000087a000ull,
+    0x0000000000861000ull, 0x00000000008f8000ull, 0x00000000008e3000ull,
+    0x00000000008ce000ull, 0x00000000008d5000ull, 0x0000000000894000ull,
+    0x000000000088f000ull, 0x00000000008a2000ull, 0x00000000008b9000ull,
+    0x0000000000990000ull, 0x000000000098b000ull, 0x00000000009a6000ull,
+    0x00000000009bd000ull, 0x00000000009fc000ull, 0x00000000009e7000ull,
+    0x00000000009ca000ull, 0x00000000009d1000ull, 0x0000000000948000ull,
+    0x0000000000953000ull, 0x000000000097e000ull, 0x0000000000965000ull,
+    0x0000000000924000ull, 0x000000000093f000ull, 0x0000000000912000ull,
+    0x0000000000909000ull
+  },
+  {
+    0x0000000000000000ull, 0x00000000000001b0ull, 0x0000000000000360ull,
+    0x00000000000002d0ull, 0x00000000000006c0ull, 0x0000000000000770ull,
+    0x00000000000005a0ull, 0x0000000000000410ull, 0x0000000000000d80ull,
+    0x0000000000000c30ull, 0x0000000000000ee0ull, 0x0000000000000f50ull,
+    0x0000000000000b40ull, 0x0000000000000af0ull, 0x0000000000000820ull,
+    0x0000000000000990ull, 0x0000000000001b00ull, 0x0000000000001ab0ull,
+    0x0000000000001860ull, 0x00000000000019d0ull, 0x0000000000001dc0ull,
+    0x0000000000001c70ull, 0x0000000000001ea0ull, 0x0000000000001f10ull,
+    0x0000000000001680ull, 0x0000000000001730ull, 0x00000000000015e0ull,
+    0x0000000000001450ull, 0x0000000000001040ull, 0x00000000000011f0ull,
+    0x0000000000001320ull, 0x0000000000001290ull, 0x0000000000003600ull,
+    0x00000000000037b0ull, 0x0000000000003560ull, 0x00000000000034d0ull,
+    0x00000000000030c0ull, 0x0000000000003170ull, 0x00000000000033a0ull,
+    0x0000000000003210ull, 0x0000000000003b80ull, 0x0000000000003a30ull,
+    0x00000000000038e0ull, 0x0000000000003950ull, 0x0000000000003d40ull,
+    0x0000000000003cf0ull, 0x0000000000003e20ull, 0x0000000000003f90ull,
+    0x0000000000002d00ull, 0x0000000000002cb0ull, 0x0000000000002e60ull,
+    0x0000000000002fd0ull, 0x0000000000002bc0ull, 0x0000000000002a70ull,
+    0x00000000000028a0ull, 0x0000000000002910ull, 0x0000000000002080ull,
+    0x0000000000002130ull, 0x00000000000023e0ull, 0x0000000000002250ull,
+    0x0000000000002640ull, 0x00000000000027f0ull, 0x0000000000002520ull,
+    0x0000000000002490ull, 0x0000000000006c00ull, 0x0000000000006db0ull,
+    0x0000000000006f60ull, 0x0000000000006ed0ull, 0x0000000000006ac0ull,
+    0x0000000000006b70ull, 0x00000000000069a0ull, 0x0000000000006810ull,
+    0x0000000000006180ull, 0x0000000000006030ull, 0x00000000000062e0ull,
+    0x0000000000006350ull, 0x0000000000006740ull, 0x00000000000066f0ull,
+    0x0000000000006420ull, 0x0000000000006590ull, 0x0000000000007700ull,
+    0x00000000000076b0ull, 0x0000000000007460ull, 0x00000000000075d0ull,
+    0x00000000000071c0ull, 0x0000000000007070ull, 0x00000000000072a0ull,
+    0x0000000000007310ull, 0x0000000000007a80ull, 0x0000000000007b30ull,
+    0x00000000000079e0ull, 0x0000000000007850ull, 0x0000000000007c40ull,
+    0x0000000000007df0ull, 0x0000000000007f20ull, 0x0000000000007e90ull,
+    0x0000000000005a00ull, 0x0000000000005bb0ull, 0x0000000000005960ull,
+    0x00000000000058d0ull, 0x0000000000005cc0ull, 0x0000000000005d70ull,
+    0x0000000000005fa0ull, 0x0000000000005e10ull, 0x0000000000005780ull,
+    0x0000000000005630ull, 0x00000000000054e0ull, 0x0000000000005550ull,
+    0x0000000000005140ull, 0x00000000000050f0ull, 0x0000000000005220ull,
+    0x0000000000005390ull, 0x0000000000004100ull, 0x00000000000040b0ull,
+    0x0000000000004260ull, 0x00000000000043d0ull, 0x00000000000047c0ull,
+    0x0000000000004670ull, 0x00000000000044a0ull, 0x0000000000004510ull,
+    0x0000000000004c80ull, 0x0000000000004d30ull, 0x0000000000004fe0ull,
+    0x0000000000004e50ull, 0x0000000000004a40ull, 0x0000000000004bf0ull,
+    0x0000000000004920ull, 0x0000000000004890ull, 0x000000000000d800ull,
+    0x000000000000d9b0ull, 0x000000000000db60ull, 0x000000000000dad0ull,
+    0x000000000000dec0ull, 0x000000000000df70ull, 0x000000000000dda0ull,
+    0x000000000000dc10ull, 0x000000000000d580ull, 0x000000000000d430ull,
+    0x000000000000d6e0ull, 0x000000000000d750ull, 0x000000000000d340ull,
+    0x000000000000d2f0ull, 0x000000000000d020ull, 0x000000000000d190ull,
+    0x000000000000c300ull, 0x000000000000c2b0ull, 0x000000000000c060ull,
+    0x000000000000c1d0ull, 0x000000000000c5c0ull, 0x000000000000c470ull,
+    0x000000000000c6a0ull, 0x000000000000c710ull, 0x000000000000ce80ull,
+    0x000000000000cf30ull, 0x000000000000cde0ull, 0x000000000000cc50ull,
+    0x000000000000c840ull, 0x000000000000c9f0ull, 0x000000000000cb20ull,
+    0x000000000000ca90ull, 0x000000000000ee00ull, 0x000000000000efb0ull,
+    0x000000000000ed60ull, 0x000000000000ecd0ull, 0x000000000000e8c0ull,
+    0x000000000000e970ull, 0x000000000000eba0ull, 0x000000000000ea10ull,
+    0x000000000000e380ull, 0x000000000000e230ull, 0x000000000000e0e0ull,
+    0x000000000000e150ull, 0x000000000000e540ull, 0x000000000000e4f0ull,
+    0x000000000000e620ull, 0x000000000000e790ull, 0x000000000000f500ull,
+    0x000000000000f4b0ull, 0x000000000000f660ull, 0x000000000000f7d0ull,
+    0x000000000000f3c0ull, 0x000000000000f270ull, 0x000000000000f0a0ull,
+    0x000000000000f110ull, 0x000000000000f880ull, 0x000000000000f930ull,
+    0x000000000000fbe0ull, 0x000000000000fa50ull, 0x000000000000fe40ull,
+    0x000000000000fff0ull, 0x000000000000fd20ull, 0x000000000000fc90ull,
+    0x000000000000b400ull, 0x000000000000b5b0ull, 0x000000000000b760ull,
+    0x000000000000b6d0ull, 0x000000000000b2c0ull, 0x000000000000b370ull,
+    0x000000000000b1a0ull, 0x000000000000b010ull, 0x000000000000b980ull,
+    0x000000000000b830ull, 0x000000000000bae0ull, 0x000000000000bb50ull,
+    0x000000000000bf40ull, 0x000000000000bef0ull, 0x000000000000bc20ull,
+    0x000000000000bd90ull, 0x000000000000af00ull, 0x000000000000aeb0ull,
+    0x000000000000ac60ull, 0x000000000000add0ull, 0x000000000000a9c0ull,
+    0x000000000000a870ull, 0x000000000000aaa0ull, 0x000000000000ab10ull,
+    0x000000000000a280ull, 0x000000000000a330ull, 0x000000000000a1e0ull,
+    0x000000000000a050ull, 0x000000000000a440ull, 0x000000000000a5f0ull,
+    0x000000000000a720ull, 0x000000000000a690ull, 0x0000000000008200ull,
+    0x00000000000083b0ull, 0x0000000000008160ull, 0x00000000000080d0ull,
+    0x00000000000084c0ull, 0x0000000000008570ull, 0x00000000000087a0ull,
+    0x0000000000008610ull, 0x0000000000008f80ull, 0x0000000000008e30ull,
+    0x0000000000008ce0ull, 0x0000000000008d50ull, 0x0000000000008940ull,
+    0x00000000000088f0ull, 0x0000000000008a20ull, 0x0000000000008b90ull,
+    0x0000000000009900ull, 0x00000000000098b0ull, 0x0000000000009a60ull,
+    0x0000000000009bd0ull, 0x0000000000009fc0ull, 0x0000000000009e70ull,
+    0x0000000000009ca0ull, 0x0000000000009d10ull, 0x0000000000009480ull,
+    0x0000000000009530ull, 0x00000000000097e0ull, 0x0000000000009650ull,
+    0x0000000000009240ull, 0x00000000000093f0ull, 0x0000000000009120ull,
+    0x0000000000009090ull
+  },
+  {
+    0x0000000000000000ull, 0xf500000000000001ull, 0x5a00000000000003ull,
+    0xaf00000000000002ull, 0xb400000000000006ull, 0x4100000000000007ull,
+    0xee00000000000005ull, 0x1b00000000000004ull, 0xd80000000000000dull,
+    0x2d0000000000000cull, 0x820000000000000eull, 0x770000000000000full,
+    0x6c0000000000000bull, 0x990000000000000aull, 0x3600000000000008ull,
+    0xc300000000000009ull, 0x000000000000001bull, 0xf50000000000001aull,
+    0x5a00000000000018ull, 0xaf00000000000019ull, 0xb40000000000001dull,
+    0x410000000000001cull, 0xee0000000000001eull, 0x1b0000000000001full,
+    0xd800000000000016ull, 0x2d00000000000017ull, 0x8200000000000015ull,
+    0x7700000000000014ull, 0x6c00000000000010ull, 0x9900000000000011ull,
+    0x3600000000000013ull, 0xc300000000000012ull, 0x0000000000000036ull,
+    0xf500000000000037ull, 0x5a00000000000035ull, 0xaf00000000000034ull,
+    0xb400000000000030ull, 0x4100000000000031ull, 0xee00000000000033ull,
+    0x1b00000000000032ull, 0xd80000000000003bull, 0x2d0000000000003aull,
+    0x8200000000000038ull, 0x7700000000000039ull, 0x6c0000000000003dull,
+    0x990000000000003cull, 0x360000000000003eull, 0xc30000000000003full,
+    0x000000000000002dull, 0xf50000000000002cull, 0x5a0000000000002eull,
+    0xaf0000000000002full, 0xb40000000000002bull, 0x410000000000002aull,
+    0xee00000000000028ull, 0x1b00000000000029ull, 0xd800000000000020ull,
+    0x2d00000000000021ull, 0x8200000000000023ull, 0x7700000000000022ull,
+    0x6c00000000000026ull, 0x9900000000000027ull, 0x3600000000000025ull,
+    0xc300000000000024ull, 0x000000000000006cull, 0xf50000000000006dull,
+    0x5a0000000000006full, 0xaf0000000000006eull, 0xb40000000000006aull,
+    0x410000000000006bull, 0xee00000000000069ull, 0x1b00000000000068ull,
+    0xd800000000000061ull, 0x2d00000000000060ull, 0x8200000000000062ull,
+    0x7700000000000063ull, 0x6c00000000000067ull, 0x9900000000000066ull,
+    0x3600000000000064ull, 0xc300000000000065ull, 0x0000000000000077ull,
+    0xf500000000000076ull, 0x5a00000000000074ull, 0xaf00000000000075ull,
+    0xb400000000000071ull, 0x4100000000000070ull, 0xee00000000000072ull,
+    0x1b00000000000073ull, 0xd80000000000007aull, 0x2d0000000000007bull,
+    0x8200000000000079ull, 0x7700000000000078ull, 0x6c0000000000007cull,
+    0x990000000000007dull, 0x360000000000007full, 0xc30000000000007eull,
+    0x000000000000005aull, 0xf50000000000005bull, 0x5a00000000000059ull,
+    0xaf00000000000058ull, 0xb40000000000005cull, 0x410000000000005dull,
+    0xee0000000000005full, 0x1b0000000000005eull, 0xd800000000000057ull,
+    0x2d00000000000056ull, 0x8200000000000054ull, 0x7700000000000055ull,
+    0x6c00000000000051ull, 0x9900000000000050ull, 0x3600000000000052ull,
+    0xc300000000000053ull, 0x0000000000000041ull, 0xf500000000000040ull,
+    0x5a00000000000042ull, 0xaf00000000000043ull, 0xb400000000000047ull,
+    0x4100000000000046ull, 0xee00000000000044ull, 0x1b00000000000045ull,
+    0xd80000000000004cull, 0x2d0000000000004dull, 0x820000000000004full,
+    0x770000000000004eull, 0x6c0000000000004aull, 0x990000000000004bull,
+    0x3600000000000049ull, 0xc300000000000048ull, 0x00000000000000d8ull,
+    0xf5000000000000d9ull, 0x5a000000000000dbull, 0xaf000000000000daull,
+    0xb4000000000000deull, 0x41000000000000dfull, 0xee000000000000ddull,
+    0x1b000000000000dcull, 0xd8000000000000d5ull, 0x2d000000000000d4ull,
+    0x82000000000000d6ull, 0x77000000000000d7ull, 0x6c000000000000d3ull,
+    0x99000000000000d2ull, 0x36000000000000d0ull, 0xc3000000000000d1ull,
+    0x00000000000000c3ull, 0xf5000000000000c2ull, 0x5a000000000000c0ull,
+    0xaf000000000000c1ull, 0xb4000000000000c5ull, 0x41000000000000c4ull,
+    0xee000000000000c6ull, 0x1b000000000000c7ull, 0xd8000000000000ceull,
+    0x2d000000000000cfull, 0x82000000000000cdull, 0x77000000000000ccull,
+    0x6c000000000000c8ull, 0x99000000000000c9ull, 0x36000000000000cbull,
+    0xc3000000000000caull, 0x00000000000000eeull, 0xf5000000000000efull,
+    0x5a000000000000edull, 0xaf000000000000ecull, 0xb4000000000000e8ull,
+    0x41000000000000e9ull, 0xee000000000000ebull, 0x1b000000000000eaull,
+    0xd8000000000000e3ull, 0x2d000000000000e2ull, 0x82000000000000e0ull,
+    0x77000000000000e1ull, 0x6c000000000000e5ull, 0x99000000000000e4ull,
+    0x36000000000000e6ull, 0xc3000000000000e7ull, 0x00000000000000f5ull,
+    0xf5000000000000f4ull, 0x5a000000000000f6ull, 0xaf000000000000f7ull,
+    0xb4000000000000f3ull, 0x41000000000000f2ull, 0xee000000000000f0ull,
+    0x1b000000000000f1ull, 0xd8000000000000f8ull, 0x2d000000000000f9ull,
+    0x82000000000000fbull, 0x77000000000000faull, 0x6c000000000000feull,
+    0x99000000000000ffull, 0x36000000000000fdull, 0xc3000000000000fcull,
+    0x00000000000000b4ull, 0xf5000000000000b5ull, 0x5a000000000000b7ull,
+    0xaf000000000000b6ull, 0xb4000000000000b2ull, 0x41000000000000b3ull,
+    0xee000000000000b1ull, 0x1b000000000000b0ull, 0xd8000000000000b9ull,
+    0x2d000000000000b8ull, 0x82000000000000baull, 0x77000000000000bbull,
+    0x6c000000000000bfull, 0x99000000000000beull, 0x36000000000000bcull,
+    0xc3000000000000bdull, 0x00000000000000afull, 0xf5000000000000aeull,
+    0x5a000000000000acull, 0xaf000000000000adull, 0xb4000000000000a9ull,
+    0x41000000000000a8ull, 0xee000000000000aaull, 0x1b000000000000abull,
+    0xd8000000000000a2ull, 0x2d000000000000a3ull, 0x82000000000000a1ull,
+    0x77000000000000a0ull, 0x6c000000000000a4ull, 0x99000000000000a5ull,
+    0x36000000000000a7ull, 0xc3000000000000a6ull, 0x0000000000000082ull,
+    0xf500000000000083ull, 0x5a00000000000081ull, 0xaf00000000000080ull,
+    0xb400000000000084ull, 0x4100000000000085ull, 0xee00000000000087ull,
+    0x1b00000000000086ull, 0xd80000000000008full, 0x2d0000000000008eull,
+    0x820000000000008cull, 0x770000000000008dull, 0x6c00000000000089ull,
+    0x9900000000000088ull, 0x360000000000008aull, 0xc30000000000008bull,
+    0x0000000000000099ull, 0xf500000000000098ull, 0x5a0000000000009aull,
+    0xaf0000000000009bull, 0xb40000000000009full, 0x410000000000009eull,
+    0xee0000000000009cull, 0x1b0000000000009dull, 0xd800000000000094ull,
+    0x2d00000000000095ull, 0x8200000000000097ull, 0x7700000000000096ull,
+    0x6c00000000000092ull, 0x9900000000000093ull, 0x3600000000000091ull,
+    0xc300000000000090ull
+  }
+};
+
+/* below this many bytes the folding setup costs more than it saves */
+#define CRC_CLMUL_MIN 256
+
+/* crc32_bytes, crc64_bytes: one table lookup per byte */
+static u_int32_t crc32_bytes (u_int32_t crc, const u_int8_t *buf, size_t length) {
+  size_t i;
+
+  for (i = 0 ; i < length ; i++)
+    crc = (crc >> 8) ^ crc32_table[0][(crc ^ buf[i]) & 0xff];
+
+  return crc;
+}
 
-static u_int32_t crc32_table[256];
-static u_int64_t crc64_table[256];
+static u_int64_t crc64_bytes (u_int64_t crc, const u_int8_t *buf, size_t length) {
+  size_t i;
 
-static int crc32_initialized = 0;
-static int crc64_initialized = 0;
+  for (i = 0 ; i < length ; i++)
+    crc = (crc >> 8) ^ crc64_table[0][(crc ^ buf[i]) & 0xff];
 
-static void crc32_init_table(void) {
-  u_int32_t i, j, r;
-  
-  crc32_initialized = 1;
+  return crc;
+}
 
-  for (i = 0 ; i < 256 ; i++) {
-    r = i;
+/* crc32_slice8, crc64_slice8: eight table lookups per eight bytes. the
+   words are assembled a byte at a time so the result does not depend on the
+   host byte order */
+static u_int32_t crc32_slice8 (u_int32_t crc, const u_int8_t *buf, size_t length) {
+  u_int32_t word;
 
-    for (j = 0; j < 8; j++)  {
-      if (r & 1)
-	r = (r >> 1) ^ CRC32POLY;
-      else
-	r >>= 1;
-    }
+  for ( ; length >= 8 ; buf += 8, length -= 8) {
+    word = crc ^ (buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((u_int32_t)buf[3] << 24));
 
-    crc32_table[i] = r;
+    crc = crc32_table[7][word & 0xff] ^ crc32_table[6][(word >> 8) & 0xff] ^
+      crc32_table[5][(word >> 16) & 0xff] ^ crc32_table[4][word >> 24] ^
+      crc32_table[3][buf[4]] ^ crc32_table[2][buf[5]] ^
+      crc32_table[1][buf[6]] ^ crc32_table[0][buf[7]];
   }
+
+  return crc32_bytes (crc, buf, length);
 }
 
-static void crc64_init_table(void) {
-  u_int32_t i, j;
-  u_int64_t r;
-  
-  crc64_initialized = 1;
+static u_int64_t crc64_slice8 (u_int64_t crc, const u_int8_t *buf, size_t length) {
+  u_int64_t word;
 
-  for (i = 0 ; i < 256 ; i++) {
-    r = i;
+  for ( ; length >= 8 ; buf += 8, length -= 8) {
+    word = crc ^ ((u_int64_t)buf[0] | ((u_int64_t)buf[1] << 8) | ((u_int64_t)buf[2] << 16) |
+		  ((u_int64_t)buf[3] << 24) | ((u_int64_t)buf[4] << 32) | ((u_int64_t)buf[5] << 40) |
+		  ((u_int64_t)buf[6] << 48) | ((u_int64_t)buf[7] << 56));
 
-    for (j = 0; j < 8; j++)  {
-      if (r & 1)
-	r = (r >> 1) ^ CRC64POLY;
-      else
-	r >>= 1;
-    }
+    crc = crc64_table[7][word & 0xff] ^ crc64_table[6][(word >> 8) & 0xff] ^
+      crc64_table[5][(word >> 16) & 0xff] ^ crc64_table[4][(word >> 24) & 0xff] ^
+      crc64_table[3][(word >> 32) & 0xff] ^ crc64_table[2][(word >> 40) & 0xff] ^
+      crc64_table[1][(word >> 48) & 0xff] ^ crc64_table[0][word >> 56];
+  }
 
-    crc64_table[i] = r;
+  return crc64_bytes (crc, buf, length);
+}
+
+#if defined(HAVE_PCLMUL)
+#include <wmmintrin.h>
+
+/* folding constants x^(d+63) mod P and x^(d-1) mod P (bit reflected) for a
+   distance d of 512 and 128 bits. the extra -1 accounts for the product of
+   two reflected 64-bit values coming out one bit short */
+static const u_int64_t crc32_fold[4] = {0x013bcedf00000000ull, 0x0651e48e00000000ull,
+					0x016340e800000000ull, 0x067de22400000000ull};
+static const u_int64_t crc64_fold[4] = {0x01b001b1b0000001ull, 0xb100010100000001ull,
+					0x6b70000000000001ull, 0xf500000000000001ull};
+
+__attribute__((target ("pclmul,sse2")))
+static __m128i crc_clmul_fold (__m128i x, __m128i k) {
+  return _mm_xor_si128 (_mm_clmulepi64_si128 (x, k, 0x00), _mm_clmulepi64_si128 (x, k, 0x11));
+}
+
+/*
+  crc_clmul (internal):
+
+  Folds 16-byte blocks of buf into a 128-bit remainder with carry-less
+  multiplies (four blocks at a time while there are enough). The folding
+  does not depend on the width of the crc so crc32 and crc64 share it; crc
+  is xored into the first block and the remainder is written to out. The
+  caller finishes with the table code: the crc of out followed by the
+  unconsumed bytes is the crc of the whole buffer.
+
+  Arguments:
+   crc    - running crc (zero extended for crc32)
+   buf    - data. length must be at least 64
+   length - length of buf
+   fold   - folding constants for the polynomial
+   out    - 16 byte remainder
+
+  Returns:
+   the number of bytes of buf consumed
+*/
+__attribute__((target ("pclmul,sse2")))
+static size_t crc_clmul (u_int64_t crc, const u_int8_t *buf, size_t length, const u_int64_t fold[4],
+			 u_int8_t out[16]) {
+  __m128i x0, x1, x2, x3, k;
+  size_t offset;
+
+  x0 = _mm_xor_si128 (_mm_loadu_si128 ((const __m128i *)buf), _mm_cvtsi64_si128 ((long long)crc));
+  x1 = _mm_loadu_si128 ((const __m128i *)(buf + 16));
+  x2 = _mm_loadu_si128 ((const __m128i *)(buf + 32));
+  x3 = _mm_loadu_si128 ((const __m128i *)(buf + 48));
+
+  k = _mm_set_epi64x ((long long)fold[1], (long long)fold[0]);
+  for (offset = 64 ; offset + 64 <= length ; offset += 64) {
+    x0 = _mm_xor_si128 (crc_clmul_fold (x0, k), _mm_loadu_si128 ((const __m128i *)(buf + offset)));
+    x1 = _mm_xor_si128 (crc_clmul_fold (x1, k), _mm_loadu_si128 ((const __m128i *)(buf + offset + 16)));
+    x2 = _mm_xor_si128 (crc_clmul_fold (x2, k), _mm_loadu_si128 ((const __m128i *)(buf + offset + 32)));
+    x3 = _mm_xor_si128 (crc_clmul_fold (x3, k), _mm_loadu_si128 ((const __m128i *)(buf + offset + 48)));
   }
+
+  k = _mm_set_epi64x ((long long)fold[3], (long long)fold[2]);
+  x0 = _mm_xor_si128 (crc_clmul_fold (x0, k), x1);
+  x0 = _mm_xor_si128 (crc_clmul_fold (x0, k), x2);
+  x0 = _mm_xor_si128 (crc_clmul_fold (x0, k), x3);
+
+  for ( ; offset + 16 <= length ; offset += 16)
+    x0 = _mm_xor_si128 (crc_clmul_fold (x0, k), _mm_loadu_si128 ((const __m128i *)(buf + offset)));
+
+  _mm_storeu_si128 ((__m128i *)out, x0);
+
+  return offset;
+}
+
+/* the cpu is checked on every call. this is a load and a test and keeps the
+   functions usable without initialization */
+#define crc_use_clmul(length) ((length) >= CRC_CLMUL_MIN && __builtin_cpu_supports ("pclmul"))
+#endif
+
+/*
+  upod_crc32_init, upod_crc32_update, upod_crc32_final:
+
+  Compute a crc32 over data that is not available all at once. update may
+  be called any number of times. The result of final is the same as calling
+  upod_crc32 on all the data.
+*/
+void upod_crc32_init (struct crc32_context *context) {
+  context->crc = 0;
+}
+
+void upod_crc32_update (struct crc32_context *context, u_int8_t *buf, size_t length) {
+  u_int32_t crc = context->crc;
+#if defined(HAVE_PCLMUL)
+  u_int8_t remainder[16];
+  size_t used;
+
+  if (crc_use_clmul (length)) {
+    used = crc_clmul (crc, buf, length, crc32_fold, remainder);
+
+    crc = crc32_slice8 (0, remainder, 16);
+    buf += used;
+    length -= used;
+  }
+#endif
+
+  context->crc = crc32_slice8 (crc, buf, length);
+}
+
+u_int32_t upod_crc32_final (struct crc32_context *context) {
+  return big32_2_arch32 (context->crc);
+}
+
+/* see upod_crc32_init */
+void upod_crc64_init (struct crc64_context *context) {
+  context->crc = 0;
+}
+
+void upod_crc64_update (struct crc64_context *context, u_int8_t *buf, size_t length) {
+  u_int64_t crc = context->crc;
+#if defined(HAVE_PCLMUL)
+  u_int8_t remainder[16];
+  size_t used;
+
+  if (crc_use_clmul (length)) {
+    used = crc_clmul (crc, buf, length, crc64_fold, remainder);
+
+    crc = crc64_slice8 (0, remainder, 16);
+    buf += used;
+    length -= used;
+  }
+#endif
+
+  context->crc = crc64_slice8 (crc, buf, length);
+}
+
+u_int64_t upod_crc64_final (struct crc64_context *context) {
+  return big64_2_arch64 (context->crc);
 }
 
 u_int32_t upod_crc32 (u_int8_t *buf, size_t length) {
-  unsigned long crc = 0;
-  int i;
-  
-  if (crc32_initialized == 0)
-    crc32_init_table();
-  
-  for (i = 0 ; i < length ; i++)
-    crc = (crc >> 8) ^ crc32_table[(crc ^ buf[i]) & 0xff];
-  
-  crc = big32_2_arch32 (crc);
-  return crc;
+  struct crc32_context context;
+
+  upod_crc32_init (&context);
+  upod_crc32_update (&context, buf, length);
+
+  return upod_crc32_final (&context);
 }
 
 u_int64_t upod_crc64 (u_int8_t *buf, size_t length) {
-  u_int64_t crc = 0;
-  int i;
-  
-  if (crc64_initialized == 0)
-    crc64_init_table();
-  
-  for (i = 0 ; i < length ; i++)
-    crc = (crc >> 8) ^ crc64_table[(crc ^ buf[i]) & 0xff];
+  struct crc64_context context;
 
-  crc = big64_2_arch64 (crc);
+  upod_crc64_init (&context);
+  upod_crc64_update (&context, buf, length);
 
-  return crc;
+  return upod_crc64_final (&context);
 }
@@ -0,0 +1,140 @@
+/**
+ *   (c) 2007 Nathan Hjelm <hjelmn@users.sourceforge.net>
+ *   v0.1.0 crcbench.c
+ *
+ *   Checks that every crc32/crc64 implementation in cksum.c agrees and
+ *   prints the throughput of each. Not built by default:
+ *
+ *     cc -O2 -DHAVE_CONFIG_H -I../include -o crcbench crcbench.c endian.c
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the Lesser GNU Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the Lesser GNU Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ **/
+
+/* the implementations are static */
+#include "cksum.c"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define BENCH_SIZE (1024 * 1024)
+#define BENCH_MB   256
+
+#if defined(HAVE_PCLMUL)
+static u_int32_t crc32_clmul (u_int32_t crc, const u_int8_t *buf, size_t length) {
+  u_int8_t remainder[16];
+  size_t used = 0;
+
+  if (length >= 64) {
+    used = crc_clmul (crc, buf, length, crc32_fold, remainder);
+    crc  = crc32_slice8 (0, remainder, 16);
+  }
+
+  return crc32_slice8 (crc, buf + used, length - used);
+}
+
+static u_int64_t crc64_clmul (u_int64_t crc, const u_int8_t *buf, size_t length) {
+  u_int8_t remainder[16];
+  size_t used = 0;
+
+  if (length >= 64) {
+    used = crc_clmul (crc, buf, length, crc64_fold, remainder);
+    crc  = crc64_slice8 (0, remainder, 16);
+  }
+
+  return crc64_slice8 (crc, buf + used, length - used);
+}
+#endif
+
+static struct {
+  char *name;
+  u_int32_t (*crc32)(u_int32_t, const u_int8_t *, size_t);
+  u_int64_t (*crc64)(u_int64_t, const u_int8_t *, size_t);
+} algorithms[] = {{"bytes",   crc32_bytes,  crc64_bytes},
+		  {"slice-8", crc32_slice8, crc64_slice8},
+#if defined(HAVE_PCLMUL)
+		  {"pclmul",  crc32_clmul,  crc64_clmul},
+#endif
+		  {NULL, NULL, NULL}};
+
+static double now (void) {
+  struct timeval tv;
+
+  gettimeofday (&tv, NULL);
+
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/* compare every algorithm against the byte at a time one for all short
+   lengths and alignments, chained and unchained */
+static int check (u_int8_t *buf) {
+  size_t offset, length;
+  u_int32_t ref32;
+  u_int64_t ref64;
+  int i, errors = 0;
+
+  for (offset = 0 ; offset < 16 ; offset++)
+    for (length = 0 ; length < 1100 ; length++) {
+      ref32 = crc32_bytes (crc32_bytes (0, buf + offset, length), buf + offset + length, 7);
+      ref64 = crc64_bytes (crc64_bytes (0, buf + offset, length), buf + offset + length, 7);
+
+      for (i = 1 ; algorithms[i].name ; i++) {
+	if (algorithms[i].crc32 (algorithms[i].crc32 (0, buf + offset, length), buf + offset + length, 7) != ref32 ||
+	    algorithms[i].crc64 (algorithms[i].crc64 (0, buf + offset, length), buf + offset + length, 7) != ref64) {
+	  printf ("%s differs at offset %u length %u\n", algorithms[i].name, (unsigned)offset, (unsigned)length);
+	  errors++;
+	}
+      }
+    }
+
+  return errors;
+}
+
+int main (int argc, char *argv[]) {
+  u_int8_t *buf;
+  double start, crc32_time, crc64_time;
+  volatile u_int64_t sink = 0;
+  int i, j;
+
+  if ((buf = (u_int8_t *) malloc (BENCH_SIZE)) == NULL)
+    return 1;
+
+  srandom (0);
+  for (i = 0 ; i < BENCH_SIZE ; i++)
+    buf[i] = random ();
+
+  if (check (buf) != 0)
+    return 1;
+
+  printf ("%-8s %12s %12s\n", "", "crc32 MB/s", "crc64 MB/s");
+
+  for (i = 0 ; algorithms[i].name ; i++) {
+    start = now ();
+    for (j = 0 ; j < BENCH_MB ; j++)
+      sink ^= algorithms[i].crc32 (j, buf, BENCH_SIZE);
+    crc32_time = now () - start;
+
+    start = now ();
+    for (j = 0 ; j < BENCH_MB ; j++)
+      sink ^= algorithms[i].crc64 (j, buf, BENCH_SIZE);
+    crc64_time = now () - start;
+
+    printf ("%-8s %12.0f %12.0f\n", algorithms[i].name, BENCH_MB / crc32_time, BENCH_MB / crc64_time);
+  }
+
+  free (buf);
+
+  return 0;
+}
@@ -101,6 +101,10 @@ int db_create (ipoddb_t *itunesdb, u_int8_t *db_name, u_int8_t *path, int flags)
   itunesdb->flags = flags;
   itunesdb->type  = 0;
   itunesdb->path  = strdup ((char *)path);
+  itunesdb->num_threads = 0;
+  itunesdb->string_pool = NULL;
+  itunesdb->ithmb_writer = NULL;
+  itunesdb->photo_queue = NULL;
 
   db_log (itunesdb, 0, "db_create: complete\n");
 
@@ -126,6 +130,13 @@ int db_photo_create (ipoddb_t *photodb, u_int8_t *path) {
 
   photodb->type = 1;
   photodb->path = strdup ((char *)path);
+  photodb->num_threads = 0;
+  photodb->string_pool = NULL;
+  photodb->ithmb_writer = NULL;
+  photodb->photo_queue = NULL;
+
+  if (db_ithmb_open (photodb) < 0)
+    return -ENOMEM;
 
   db_album_create (photodb, (u_int8_t *)"Artwork");
 
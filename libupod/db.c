@@ -79,6 +79,12 @@ void db_free (ipoddb_t *itunesdb) {
 
   itunesdb->tree_root = NULL;
 
+  db_string_pool_free (itunesdb->string_pool);
+  itunesdb->string_pool = NULL;
+
+  db_photo_queue_free (itunesdb);
+  db_ithmb_close (itunesdb);
+
   if (itunesdb->path != NULL) {
     free (itunesdb->path);
     itunesdb->path = NULL;
@@ -315,6 +321,10 @@ int db_load (ipoddb_t *ipod_db, char *path, int flags) {
   db_log (ipod_db, 0, "db.c/db_load: entering...\n");
   db_log (ipod_db, 0, "db.c/db_load: flags: %08x\n", flags);
   ipod_db->flags = flags;
+  ipod_db->num_threads = 0;
+  ipod_db->string_pool = NULL;
+  ipod_db->ithmb_writer = NULL;
+  ipod_db->photo_queue = NULL;
 
   if (stat(path, &statinfo) < 0) {
     db_log (ipod_db, errno, "db_load|stat: %s\n", strerror(errno));
@@ -399,6 +409,12 @@ int db_load (ipoddb_t *ipod_db, char *path, int flags) {
     /* free flat database as it is no longer useful */
     free (buffer);
 
+  if (ipod_db->type == 1 && (ret = db_ithmb_open (ipod_db)) < 0) {
+    db_free (ipod_db);
+
+    return ret;
+  }
+
   db_log (ipod_db, 0, "db.c/db_load: complete. %i Bytes\n", bytes_read);
 
   return bytes_read;
@@ -444,16 +460,29 @@ int db_write (ipoddb_t ipod_db, char *path) {
 
   db_log (&ipod_db, 0, "db.c/db_write: entering...\n");
 
+  /* the thumbnails the ArtworkDB points to must be rendered and on disk
+     before the old database is truncated */
+  if (ipod_db.type == 1 &&
+      ((ret = db_photo_flush (&ipod_db)) < 0 || (ret = db_ithmb_flush (&ipod_db)) < 0)) {
+    db_log (&ipod_db, ret, "db.c/db_write: could not write the thumbnails. %s was not written\n", path);
+
+    return ret;
+  }
+
   if ((fd = open(path, O_WRONLY | O_TRUNC | O_CREAT, perms)) < 0) {
     db_log (&ipod_db, -errno, "db.c/db_write: error writing %s, %s\n", path, strerror (errno));
 
     return -errno;
   }
 
-  if (ipod_db.type == 0) {
+  /* the indices are only rebuilt if the track list changed */
+  if (ipod_db.type == 0 && db_playlist_indices_stale (&ipod_db)) {
     db_playlist_strip_indices (&ipod_db);
     db_playlist_add_indices (&ipod_db);
   }
+
+  /* sizes must be current even if a batch is still open */
+  db_batch_flush (ipod_db.tree_root);
   
   ret = db_write_tree (fd, ipod_db.tree_root);
   
@@ -464,10 +493,142 @@ int db_write (ipoddb_t ipod_db, char *path) {
   return ret;
 }
 
-int db_attach_at (tree_node_t *parent, tree_node_t *new_child, int index) {
-  int size, i;
+static int db_recompute_sizes (tree_node_t *node);
+
+/*
+  db_mark_dirty (internal):
+
+  If node belongs to a tree with an open batch mark node and its ancestors as
+  needing their sizes recomputed and return 1. Otherwise return 0 and let the
+  caller adjust the sizes immediately.
+*/
+static int db_mark_dirty (tree_node_t *node) {
   tree_node_t *tmp;
 
+  for (tmp = node ; tmp->parent ; tmp = tmp->parent);
+
+  if (tmp->batch_depth == 0) {
+    /* a branch still marked from an earlier batch can not be adjusted by a
+       delta. recompute it (this includes the caller's change) instead */
+    if (node->dirty) {
+      db_recompute_sizes (tmp);
+      return 1;
+    }
+
+    return 0;
+  }
+
+  for (tmp = node ; tmp && !tmp->dirty ; tmp = tmp->parent)
+    tmp->dirty = 1;
+
+  return 1;
+}
+
+/* notes a structural change in node and all of its ancestors */
+static void db_bump_generation (tree_node_t *node) {
+  for ( ; node ; node = node->parent)
+    node->generation++;
+}
+
+static void db_adjust_sizes (tree_node_t *node, int delta) {
+  for ( ; node ; node = node->parent)
+    ((int *)node->data)[2] += delta;
+}
+
+/*
+  db_recompute_sizes (internal):
+
+  Recomputes the size of every dirty node in the sub-tree rooted at node in
+  one bottom up traversal. Returns the size of the sub-tree.
+*/
+static int db_recompute_sizes (tree_node_t *node) {
+  int i, size;
+
+  if (!node->dirty)
+    return (node->num_children == 0) ? node->data_size : ((int *)node->data)[2];
+
+  /* a dirty node may have lost all of its children. its size is rewritten anyway */
+  for (i = 0, size = node->data_size ; i < node->num_children ; i++)
+    size += db_recompute_sizes (node->children[i]);
+
+  ((int *)node->data)[2] = size;
+  node->dirty = 0;
+
+  return size;
+}
+
+/* size of a sub-tree that may have been modified inside a batch */
+static int db_subtree_size (tree_node_t *node) {
+  return node->dirty ? db_recompute_sizes (node) : db_size_tree (node);
+}
+
+/*
+  db_batch_flush:
+
+  Brings the sizes of a tree up to date without closing any open batch.
+*/
+void db_batch_flush (tree_node_t *root) {
+  if (root && root->dirty)
+    db_recompute_sizes (root);
+}
+
+/**
+  db_begin_batch:
+
+   Starts a batch of changes to a database. Until the matching
+  db_commit_batch adding or removing nodes only marks the affected branches
+  and the sizes are recomputed once at commit. Batches may be nested.
+
+  Arguments:
+   ipoddb_t *ipod_db - opened database
+
+  Returns:
+   < 0 on error
+     0 on success
+**/
+int db_begin_batch (ipoddb_t *ipod_db) {
+  if (ipod_db == NULL || ipod_db->tree_root == NULL)
+    return -EINVAL;
+
+  ipod_db->tree_root->batch_depth++;
+
+  return 0;
+}
+
+/**
+  db_commit_batch:
+
+   Ends a batch started by db_begin_batch. When the outermost batch is
+  committed the sizes of all changed branches are recomputed in a single
+  traversal. The master playlist's indices are left for db_write, which
+  rebuilds them once if the track list changed.
+
+  Arguments:
+   ipoddb_t *ipod_db - opened database
+
+  Returns:
+   < 0 on error
+     0 on success
+**/
+int db_commit_batch (ipoddb_t *ipod_db) {
+  tree_node_t *root;
+
+  if (ipod_db == NULL || ipod_db->tree_root == NULL || ipod_db->tree_root->batch_depth == 0)
+    return -EINVAL;
+
+  root = ipod_db->tree_root;
+
+  if (--root->batch_depth > 0)
+    return 0;
+
+  db_batch_flush (root);
+
+  return 0;
+}
+
+int db_attach_at (tree_node_t *parent, tree_node_t *new_child, int index) {
+  int i;
+
   if ((parent == NULL) || (new_child == NULL))
     return -EINVAL;
 
@@ -491,11 +652,11 @@ int db_attach_at (tree_node_t *parent, tree_node_t *new_child, int index) {
 
   parent->children[index] = new_child;
 
-  /* adjust tree sizes */
-  size = db_size_tree (new_child);
+  db_bump_generation (parent);
 
-  for (tmp = parent ; tmp ; tmp = tmp->parent)
-    ((int *)tmp->data)[2] += size;
+  /* adjust tree sizes */
+  if (!db_mark_dirty (parent))
+    db_adjust_sizes (parent, db_size_tree (new_child));
 
   return 0;
 }
@@ -504,6 +665,53 @@ int db_attach (tree_node_t *parent, tree_node_t *new_child) {
   return db_attach_at (parent, new_child, parent->num_children);
 }
 
+/*
+  db_attach_many:
+
+  Appends num_children nodes to parent. The child array is grown once and the
+  sizes of the parent and its ancestors are adjusted once for all the nodes.
+
+  Returns:
+   < 0 on error
+     0 on success
+*/
+int db_attach_many (tree_node_t *parent, tree_node_t **new_children, int num_children) {
+  tree_node_t **children;
+  int size = 0, i;
+
+  if (parent == NULL || num_children < 0 || (num_children && new_children == NULL))
+    return -EINVAL;
+
+  if (num_children == 0)
+    return 0;
+
+  children = realloc (parent->children, (parent->num_children + num_children) *
+		      sizeof (tree_node_t *));
+  if (children == NULL)
+    return -errno;
+
+  parent->children = children;
+
+  for (i = 0 ; i < num_children ; i++) {
+    new_children[i]->parent = parent;
+    parent->children[parent->num_children + i] = new_children[i];
+  }
+
+  parent->num_children += num_children;
+
+  db_bump_generation (parent);
+
+  /* adjust tree sizes */
+  if (!db_mark_dirty (parent)) {
+    for (i = 0 ; i < num_children ; i++)
+      size += db_size_tree (new_children[i]);
+
+    db_adjust_sizes (parent, size);
+  }
+
+  return 0;
+}
+
 /*
   db_detach:
 
@@ -516,7 +724,6 @@ int db_attach (tree_node_t *parent, tree_node_t *new_child) {
 */
 int db_detach (tree_node_t *parent, int child_num, tree_node_t **entry) {
   int size;
-  tree_node_t *tmp;
   int i;
 
   if (entry == NULL) return -1;
@@ -534,16 +741,69 @@ int db_detach (tree_node_t *parent, int child_num, tree_node_t **entry) {
   parent->children = realloc (parent->children, parent->num_children *
 			      sizeof(tree_node_t *));
 
-  size = db_size_tree (*entry);
+  /* the detached sub-tree must have valid sizes on its own */
+  size = db_subtree_size (*entry);
 
-  for (tmp = parent ; tmp ; tmp = tmp->parent)
-    ((int *)tmp->data)[2] -= size;
+  db_bump_generation (parent);
+
+  if (!db_mark_dirty (parent))
+    db_adjust_sizes (parent, -size);
 
   (*entry)->parent = NULL;
 
   return 0;
 }
 
+/*
+  db_remove_children:
+
+  Removes (and frees) every child of parent starting at child first for which
+  match returns non-zero. The child array is compacted in one pass and the
+  sizes of the parent and its ancestors are adjusted once.
+
+  Returns:
+   < 0 on error
+   >=0 number of children removed
+*/
+int db_remove_children (tree_node_t *parent, int first, int (*match)(tree_node_t *, void *),
+			void *arg) {
+  tree_node_t **children;
+  int size = 0, i, j;
+
+  if (parent == NULL || match == NULL || first < 0)
+    return -EINVAL;
+
+  for (i = j = first ; i < parent->num_children ; i++) {
+    tree_node_t *child = parent->children[i];
+
+    if (match (child, arg)) {
+      size += db_subtree_size (child);
+      db_free_tree (child);
+    } else
+      parent->children[j++] = child;
+  }
+
+  if (i == j)
+    return 0;
+
+  parent->num_children = j;
+
+  if (j == 0) {
+    free (parent->children);
+    parent->children = NULL;
+  } else if ((children = realloc (parent->children, j * sizeof (tree_node_t *))) != NULL)
+    /* if shrinking fails the old (larger) array is still valid */
+    parent->children = children;
+
+  db_bump_generation (parent);
+
+  /* adjust tree sizes */
+  if (!db_mark_dirty (parent))
+    db_adjust_sizes (parent, -size);
+
+  return i - j;
+}
+
 int db_node_allocate (tree_node_t **entry, unsigned long type, size_t size, int subtree) {
   struct db_generic *data;
   if (entry == NULL)
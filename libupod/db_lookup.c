@@ -214,3 +214,96 @@ int db_lookup_image (ipoddb_t *photodb, u_int64_t id) {
 
   return 0;
 }
+
+static int path_index_compare (const void *a, const void *b) {
+  const struct path_index_entry *entry1 = (const struct path_index_entry *)a;
+  const struct path_index_entry *entry2 = (const struct path_index_entry *)b;
+
+  return strcasecmp ((char *)entry1->path, (char *)entry2->path);
+}
+
+/*
+  db_path_index_build:
+
+  Builds a sorted index of the paths of every track in the database so that
+  many paths can be looked up without a linear scan per path. The index is
+  a snapshot and is not updated when tracks are added or removed.
+
+  Returns:
+   < 0 on error
+     0 on success
+*/
+int db_path_index_build (ipoddb_t *itunesdb, struct path_index *index) {
+  tree_node_t *dshm_header, *dohm_header;
+  db_tlhm_t *tlhm_data;
+  int i, ret;
+
+  if (itunesdb == NULL || index == NULL || itunesdb->type != 0)
+    return -EINVAL;
+
+  memset (index, 0, sizeof (struct path_index));
+
+  if ((ret = db_dshm_retrieve (itunesdb, &dshm_header, 0x1)) != 0)
+    return ret;
+
+  tlhm_data = (db_tlhm_t *)dshm_header->children[0]->data;
+
+  if (tlhm_data->list_entries == 0)
+    return 0;
+
+  index->entries = (struct path_index_entry *) calloc (tlhm_data->list_entries, sizeof (struct path_index_entry));
+  if (index->entries == NULL)
+    return -errno;
+
+  for (i = 1 ; i <= tlhm_data->list_entries ; i++) {
+    struct db_tihm *tihm_data = (struct db_tihm *)dshm_header->children[i]->data;
+
+    if (db_dohm_retrieve (dshm_header->children[i], &dohm_header, IPOD_PATH) < 0 ||
+	db_dohm_get_string (dohm_header, &index->entries[index->num_entries].path) < 0)
+      continue;
+
+    index->entries[index->num_entries++].tihm_num = tihm_data->identifier;
+  }
+
+  qsort (index->entries, index->num_entries, sizeof (struct path_index_entry), path_index_compare);
+
+  return 0;
+}
+
+/*
+  db_path_index_lookup:
+
+  Finds a path (in UTF-8) in an index created by db_path_index_build.
+
+  Returns:
+     -1 if not found
+   >= 0 the tihm identifier of the track with the path
+*/
+int db_path_index_lookup (struct path_index *index, u_int8_t *path) {
+  struct path_index_entry key, *entry;
+
+  if (index == NULL || index->num_entries == 0 || path == NULL)
+    return -1;
+
+  key.path = path;
+
+  entry = bsearch (&key, index->entries, index->num_entries, sizeof (struct path_index_entry),
+		   path_index_compare);
+
+  return (entry != NULL) ? (int)entry->tihm_num : -1;
+}
+
+void db_path_index_free (struct path_index *index) {
+  int i;
+
+  if (index == NULL)
+    return;
+
+  for (i = 0 ; i < index->num_entries ; i++)
+    free (index->entries[i].path);
+
+  if (index->entries)
+    free (index->entries);
+
+  memset (index, 0, sizeof (struct path_index));
+}
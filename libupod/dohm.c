@@ -173,6 +173,7 @@ void dohm_destroy (tihm_t *tihm) {
 
 int db_dohm_create_generic (tree_node_t **entry, size_t size, int type) {
   struct db_dohm *dohm_data;
+  u_int8_t *data;
   int ret;
 
   if (size < DOHM_CELL_SIZE)
@@ -181,7 +182,12 @@ int db_dohm_create_generic (tree_node_t **entry, size_t size, int type) {
   if ((ret = db_node_allocate (entry, DOHM, DOHM_CELL_SIZE, size)) < 0)
     return ret;
 
-  (*entry)->data = realloc ((*entry)->data, size);
+  if ((data = realloc ((*entry)->data, size)) == NULL) {
+    db_free_tree (*entry);
+    return -ENOMEM;
+  }
+
+  (*entry)->data = data;
   memset (&((*entry)->data[DOHM_CELL_SIZE]), 0, size - DOHM_CELL_SIZE);
   (*entry)->data_size = size;
 
@@ -191,6 +197,24 @@ int db_dohm_create_generic (tree_node_t **entry, size_t size, int type) {
   return 0;
 }
 
+/* returns the code stored in an index dohm (0x34) sorted by sort_by */
+int db_dohm_index_type (int sort_by) {
+  switch (sort_by) {
+  case IPOD_TITLE:
+    return 0x00000003;
+  case IPOD_ALBUM:
+    return 0x00000004;
+  case IPOD_ARTIST:
+    return 0x00000005;
+  case IPOD_GENRE:
+    return 0x00000007;
+  case IPOD_COMPOSER:
+    return 0x00000012;
+  default:
+    return -1;
+  }
+}
+
 int db_dohm_index_create (tree_node_t **entry, int sort_by, int num_tracks, u_int32_t tracks[]) {
   struct db_dohm *dohm_data;
   int *iptr;
@@ -205,16 +229,8 @@ int db_dohm_index_create (tree_node_t **entry, int sort_by, int num_tracks, u_in
   dohm_data = (struct db_dohm *)(*entry)->data;
   iptr = (int *)&((*entry)->data[0x18]);
 
-  if (sort_by == IPOD_TITLE)
-    iptr[0] = 0x00000003;
-  else if (sort_by == IPOD_ALBUM)
-    iptr[0] = 0x00000004;
-  else if (sort_by == IPOD_ARTIST)
-    iptr[0] = 0x00000005;
-  else if (sort_by == IPOD_GENRE)
-    iptr[0] = 0x00000007;
-  else if (sort_by == IPOD_COMPOSER)
-    iptr[0] = 0x00000012;
+  if (db_dohm_index_type (sort_by) != -1)
+    iptr[0] = db_dohm_index_type (sort_by);
 
   iptr[1] = num_tracks;
 
@@ -307,7 +323,7 @@ int db_dohm_create_pihm (tree_node_t **entry, int order) {
 }
 
 int db_dohm_create (tree_node_t **entry, dohm_t dohm, int string_header_size, int flags) {
-  int entry_size;
+  int entry_size, ret;
   u_int16_t *unicode_data;
   size_t unicode_length;
   struct string_header_12 *string_header12;
@@ -328,9 +344,17 @@ int db_dohm_create (tree_node_t **entry, dohm_t dohm, int string_header_size, in
     unicode_length = strlen ((char *)dohm.data);
   }
 
+  if (unicode_data == NULL)
+    return -ENOMEM;
+
   entry_size   = DOHM_CELL_SIZE + string_header_size + unicode_length;
 
-  db_dohm_create_generic (entry, entry_size, dohm.type);
+  if ((ret = db_dohm_create_generic (entry, entry_size, dohm.type)) < 0) {
+    if (!(flags & FLAG_UTF8) && string_header_size > 0)
+      free (unicode_data);
+
+    return ret;
+  }
   
   switch (string_header_size) {
   case 12:
@@ -392,15 +416,20 @@ int db_dohm_create_eq (tree_node_t **entry, u_int8_t eq) {
   return 0;
 }
 
-int db_dohm_get_string (tree_node_t *dohm_header, u_int8_t **str) {
+/*
+  dohm_string_location (internal):
+
+  Finds the string stored in a dohm. Dohms without a string header hold raw
+  UTF-8 data (urls).
+*/
+static int dohm_string_location (tree_node_t *dohm_header, u_int8_t **string_start,
+				 int *string_length, char **encoding) {
   struct db_dohm *dohm_data;
-  u_int8_t *string_start;
-  int string_format;
-  int string_length;
   struct string_header_12 *string_header12;
   struct string_header_16 *string_header16;
+  int string_format;
 
-  if (dohm_header == NULL || str == NULL)
+  if (dohm_header == NULL)
     return -EINVAL;
   
   dohm_data   = (struct db_dohm *)dohm_header->data;
@@ -412,36 +441,105 @@ int db_dohm_get_string (tree_node_t *dohm_header, u_int8_t **str) {
   case 12:
     string_header12 = (struct string_header_12 *)&(dohm_header->data[0x18]);
 
-    string_length = string_header12->string_length;
-    string_format = string_header12->format;
+    *string_length = string_header12->string_length;
+    string_format  = string_header12->format;
     
-    string_start  = &(dohm_header->data[0x24]);
+    *string_start  = &(dohm_header->data[0x24]);
     break;
   case 16:
     string_header16 = (struct string_header_16 *)&(dohm_header->data[0x18]);
     
-    string_length = string_header16->string_length;
-    string_format = (string_header16->unk0 == 1) ? 0 : 1;
+    *string_length = string_header16->string_length;
+    string_format  = (string_header16->unk0 == 1) ? 0 : 1;
     
-    string_start  = &(dohm_header->data[0x28]);
+    *string_start  = &(dohm_header->data[0x28]);
     break;
   default:
-    *str = calloc (dohm_data->record_size - 0x17, 1);
+    *string_length = dohm_data->record_size - 0x18;
+    string_format  = 1;
+
+    *string_start  = &(dohm_header->data[0x18]);
+  }
+
+  *encoding = (string_format == 1) ? "UTF-8" : UTF_ENC;
+
+  return 0;
+}
+
+int db_dohm_get_string (tree_node_t *dohm_header, u_int8_t **str) {
+  u_int8_t *string_start;
+  int string_length, ret;
+  char *encoding;
+
+  if (dohm_header == NULL || str == NULL)
+    return -EINVAL;
+
+  if ((ret = dohm_string_location (dohm_header, &string_start, &string_length, &encoding)) < 0)
+    return ret;
+
+  if (dohm_header->string_header_size != 12 && dohm_header->string_header_size != 16) {
+    *str = calloc (string_length + 1, 1);
     
-    memcpy (*str, &dohm_header->data[0x18], dohm_data->record_size - 0x18);
+    memcpy (*str, string_start, string_length);
 
     return 0;
   }
 
-  to_utf8 (str, string_start, string_length, (string_format == 1) ? "UTF-8" : UTF_ENC);
+  to_utf8 (str, string_start, string_length, encoding);
+
+  return 0;
+}
+
+/*
+  db_dohm_get_string_buf:
+
+  Like db_dohm_get_string but converts the string into buf (at most buf_len
+  bytes including the terminator) instead of allocating memory.
+
+  Returns:
+   < 0 on error
+   >=0 length of the whole string in UTF-8
+*/
+int db_dohm_get_string_buf (tree_node_t *dohm_header, u_int8_t *buf, size_t buf_len) {
+  u_int8_t *string_start;
+  int string_length, ret;
+  char *encoding;
+
+  if ((ret = dohm_string_location (dohm_header, &string_start, &string_length, &encoding)) < 0)
+    return ret;
+
+  return (int) libupod_to_utf8_buf (buf, buf_len, string_start, string_length, encoding);
+}
+
+/*
+  db_dohm_get_string_pooled:
+
+  Like db_dohm_get_string but the string is interned in strings and must not
+  be freed by the caller.
+*/
+static int db_dohm_get_string_pooled (tree_node_t *dohm_header, struct string_pool *strings,
+				      u_int8_t **str) {
+  u_int8_t *string_start;
+  int string_length, ret;
+  char *encoding;
+
+  if ((ret = dohm_string_location (dohm_header, &string_start, &string_length, &encoding)) < 0)
+    return ret;
+
+  /* raw strings are copied as-is (see db_dohm_get_string) */
+  if (dohm_header->string_header_size != 12 && dohm_header->string_header_size != 16)
+    encoding = NULL;
+
+  if ((*str = db_string_pool_intern (strings, string_start, string_length, encoding)) == NULL)
+    return -ENOMEM;
 
   return 0;
 }
 
-int db_dohm_fill (tree_node_t *entry, dohm_t **dohms) {
+int db_dohm_fill (tree_node_t *entry, dohm_t **dohms, struct string_pool *strings) {
   tree_node_t *dohm_header;
   struct db_dohm *dohm_data;
-  int i, *iptr;
+  int i, *iptr, ret;
 
   if (entry == NULL || dohms == NULL)
     return -EINVAL;
@@ -454,7 +552,12 @@ int db_dohm_fill (tree_node_t *entry, dohm_t **dohms) {
     dohm_header = entry->children[i];
     dohm_data = (struct db_dohm *)dohm_header->data;
 
-    if (db_dohm_get_string (dohm_header, &((*dohms)[i].data)) < 0) {
+    if (strings)
+      ret = db_dohm_get_string_pooled (dohm_header, strings, &((*dohms)[i].data));
+    else
+      ret = db_dohm_get_string (dohm_header, &((*dohms)[i].data));
+
+    if (ret < 0) {
       (*dohms)[i].type = -1;
 
       continue;
@@ -57,12 +57,11 @@ int db_fihm_find (ipoddb_t *photodb, unsigned int file_id) {
   return 0;
 }
 
-int db_fihm_register (ipoddb_t *photodb, char *file_name, unsigned long file_id) {
+int db_fihm_register (ipoddb_t *photodb, unsigned long file_id) {
   struct tree_node *dshm_header, *new_fihm_header;
   db_flhm_t *flhm_data;
   struct db_fihm *fihm_data;
   int ret;
-  struct stat statinfo;
 
   /* find the file list */
   if ((ret = db_dshm_retrieve (photodb, &dshm_header, 3)) < 0) {
@@ -81,8 +80,7 @@ int db_fihm_register (ipoddb_t *photodb, char *file_name, unsigned long file_id)
 
   fihm_data = (struct db_fihm *)new_fihm_header->data;
 
-  stat (file_name, &statinfo);
-  fihm_data->file_size = statinfo.st_size;
+  fihm_data->file_size = db_ithmb_size (photodb, file_id);
 
   return 0;
 }
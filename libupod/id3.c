@@ -49,8 +49,19 @@
 
 #define ID3FLAG_EXTENDED 0x40
 #define ID3FLAG_FOOTER   0x10
+#define ID3FLAG_UNSYNC   0x80
 #define TAG_DATA_SIZE    256
 
+/* id3v2.4 frame format flags */
+#define ID3FRAME_GROUPING   0x40
+#define ID3FRAME_COMPRESSED 0x08
+#define ID3FRAME_ENCRYPTED  0x04
+#define ID3FRAME_UNSYNC     0x02
+#define ID3FRAME_DATALENGTH 0x01
+
+/* an id3v1 tag (128 bytes) preceded by the end of a Lyrics3 v2.00 block (15 bytes) */
+#define ID3_TRAILER_SIZE (128 + 15)
+
                        /* v2.2 v2.3 */
 static char *ID3_TITLE[2]   = {"TT2", "TIT2"};
 static char *ID3_ARTIST[2]  = {"TP1", "TPE1"};
@@ -70,10 +81,6 @@ static char *ID3_POD_URL[2] = {"WFD", "WFD "};
 static char *ID3_DESC[2]    = {"TDS", "TDS "};
 static char *ID3_RELEASE[2] = {"TDR", "TDR "};
 
-static int find_id3 (int version, FILE *fh, unsigned char *tag_data, int *tag_datalen, int *major_version);
-static void one_pass_parse_id3 (FILE *fh, unsigned char *tag_data, int tag_datalen, int version,
-                                int id3v2_majorversion, tihm_t *tihm);
-
 static int synchsafe_to_int (unsigned char *buf, int nbytes) {
   int id3v2_len = 0;
   int error = 0;
@@ -127,93 +134,13 @@ int id3v2_size (unsigned char data[14]) {
   return id3v2_len;
 }
 
-/*
-  find_id3 takes in a file descriptor, a pointer to where the tag data is to be put,
-  and a pointer to where the data length is to be put.
-
-  find_id3 returns:
-    0 for no id3 tags
-    1 for id3v1 tag
-    2 for id3v2 tag
-
-  The file descriptor is reset to the start of the file on completion.
-*/
-static int find_id3 (int version, FILE *fh, unsigned char *tag_data, int *tag_datalen, int *major_version) {
-  int head;
-
-  fread(&head, 4, 1, fh);    
-  head = big32_2_arch32 (head);
-
-  if (version == 2) {
-    unsigned char data[10];
-    unsigned char id3v2_flags;
-    int id3v2_len;
-    int id3v2_extendedlen;
-
-    /* version 2 */
-    if ((head & 0xffffff00) == 0x49443300) {
-      fread(data, 1, 10, fh);
-
-      *major_version = head & 0xff;
-      
-      id3v2_flags = data[1];
-      id3v2_len   = synchsafe_to_int (&data[2], 4);
-
-      /* the 6th bit of the flag field being set indicates that an
-	 extended header is present */
-      if (id3v2_flags & ID3FLAG_EXTENDED) {
-	/* Skip extended header */
-	if (*major_version != 3)
-	  id3v2_extendedlen = synchsafe_to_int (&data[6], 4);
-	else
-	  id3v2_extendedlen = big32_2_arch32 (((int *)&data[6])[0]);
-
-	fseek(fh, 0xa + 0x4 + id3v2_extendedlen, SEEK_SET);
-	*tag_datalen = id3v2_len - 0x4 - id3v2_extendedlen;
-      } else {
-	/* Skip standard header */
-	fseek(fh, 0xa, SEEK_SET);
-	*tag_datalen = id3v2_len;
-      }
-	
-      mp3_debug ("find_id3: found id3v2.%i tag of size %i\n", *major_version, *tag_datalen);
-
-      return 2;
-    }
-  } else if (version == 1) {
-    fseek(fh, 0, SEEK_SET);
-    
-    /* tag not at beginning? */
-    if ((head & 0xffffff00) != 0x54414700) {
-      /* maybe end */
-      fseek(fh, -128, SEEK_END);
-      fread(&head, 1, 4, fh);
-      fseek(fh, -128, SEEK_END);
-	
-      head = big32_2_arch32 (head);
-    }
-      
-    /* version 1 */
-    if ((head & 0xffffff00) == 0x54414700) {
-      mp3_debug ("find_id3: found id3v1 tag.\n");
-
-      fread(tag_data, 1, 128, fh);
-	
-      return 1;
-    }
-  }
-    
-  /* no id3 found */
-  return 0;
-}
-
-char *id3v1_string (signed char *unclean, int *length) {
+/* buffer must hold at least 31 bytes */
+static char *id3v1_string (signed char *unclean, char *buffer, int *length) {
   int i;
-  static char buffer[31];
 
   memset (buffer, 0, 31);
 
-  for (i = 0 ; i < 30 && unclean[i] != -1 ; i++)
+  for (i = 0 ; i < 30 && unclean[i] != -1 && unclean[i] != '\0' ; i++)
     buffer[i] = unclean[i];
 
   *length = i;
@@ -221,267 +148,523 @@ char *id3v1_string (signed char *unclean, int *length) {
   return buffer;
 }
 
-#if defined(HAVE_LIBWAND)
-int read_artwork (FILE *fh, tihm_t *tihm, size_t image_size) {
-  u_int64_t cksum;
+#if defined(HAVE_ARTWORK)
+/* size of the pieces the cover is copied and checksummed in (small enough that
+   each piece is still in the cache when it is checksummed) */
+#define ARTWORK_CHUNK 16384
+
+/* the image is copied so data can be freed after this call */
+int copy_artwork (tihm_t *tihm, u_int8_t *image_data, size_t image_size) {
+  struct crc64_context context;
+  size_t offset, length;
 
   mp3_debug ("Reading cover art. Image size is %i B\n", image_size);
 
-  tihm->image_data = (unsigned char *)calloc (1, image_size);
-  fread (tihm->image_data, 1, image_size, fh);
+  tihm->image_data = (unsigned char *)malloc (image_size);
+  if (tihm->image_data == NULL)
+    return -errno;
+
+  upod_crc64_init (&context);
+
+  for (offset = 0 ; offset < image_size ; offset += length) {
+    length = (image_size - offset < ARTWORK_CHUNK) ? image_size - offset : ARTWORK_CHUNK;
 
-  cksum = upod_crc64 (tihm->image_data, image_size);
+    memcpy (tihm->image_data + offset, image_data + offset, length);
+    upod_crc64_update (&context, tihm->image_data + offset, length);
+  }
 
   tihm->has_artwork = 1;
   
   /* a checksum is used for the image id to avoid duplicate images in the database */
-  tihm->artwork_id  = cksum;
+  tihm->artwork_id  = upod_crc64_final (&context);
   tihm->image_size  = image_size;
 
   return 0;
 }
 #endif
 
-static int parse_artwork (tihm_t *tihm, FILE *fh, size_t length, int id3v2_majorversion) {
-#if defined(HAVE_LIBWAND)
-  if (tihm->image_data)
+static u_int32_t id3_read32 (u_int8_t *buffer) {
+  return ((u_int32_t)buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3];
+}
+
+/*
+  id3v2_resync:
+
+  Removes the 0x00 bytes that unsynchronisation inserts after every 0xff.
+  Returns the new length of data.
+*/
+static int id3v2_resync (u_int8_t *data, int length) {
+  int i, j;
+
+  for (i = 0, j = 0 ; i < length ; i++) {
+    data[j++] = data[i];
+
+    if (data[i] == 0xff && i + 1 < length && data[i + 1] == 0x00)
+      i++;
+  }
+
+  return j;
+}
+
+/* returns non-zero if a v2.4 frame header (or padding or the end of the tag) is at data */
+static int id3v2_frame_start (u_int8_t *data, int remaining) {
+  int i;
+
+  if (remaining == 0 || (remaining > 0 && data[0] == 0))
+    return 1;
+
+  if (remaining < 10 || !isupper (data[0]))
     return 0;
 
-  length --;
+  for (i = 1 ; i < 4 ; i++)
+    if (!(isupper (data[i]) || isdigit (data[i])))
+      return 0;
+
+  /* the frame must fit in the tag with either kind of size */
+  return (synchsafe_to_int (data + 4, 4) <= remaining - 10 ||
+	  id3_read32 (data + 4) <= (u_int32_t)(remaining - 10));
+}
+
+/*
+  id3v2_text:
+
+  Decodes the encoding byte at the start of a text frame. Sets *encoding
+  and *text_length and returns a pointer to the text without any byte order
+  mark or terminators.
+*/
+static u_int8_t *id3v2_text (u_int8_t *data, int length, char **encoding, int *text_length) {
+  int width = 1;
+
+  switch (data[0]) {
+  case 0x00:
+    *encoding = "ISO-8859-1";
+    data++; length--;
+    break;
+  case 0x03:
+    *encoding = "UTF-8";
+    data++; length--;
+    break;
+  case 0x01:
+    /* UTF-16 with a byte order mark */
+    *encoding = "UTF-16LE";
+    data++; length--;
+
+    if (length >= 2 && data[0] == 0xfe && data[1] == 0xff)
+      *encoding = "UTF-16BE";
+
+    if (length >= 2 && ((data[0] == 0xfe && data[1] == 0xff) || (data[0] == 0xff && data[1] == 0xfe))) {
+      data += 2; length -= 2;
+    }
+
+    width = 2;
+    break;
+  case 0x02:
+    *encoding = "UTF-16BE";
+    data++; length--;
+    width = 2;
+    break;
+  default:
+    *encoding = "ISO-8859-1";
+  }
+
+  if (width == 2) {
+    length &= ~1;
+
+    for ( ; length >= 2 && data[length - 1] == 0 && data[length - 2] == 0 ; length -= 2);
+  } else {
+    for ( ; length && *data == '\0' ; data++, length--);
+    /* strip off any trailing \0's */
+    for ( ; length && data[length - 1] == '\0' ; length--);
+  }
+
+  *text_length = length;
+
+  return data;
+}
+
+/* returns the number of bytes in the (terminated) string at data */
+static int id3v2_skip_string (u_int8_t *data, int length, int width) {
+  int i;
+
+  for (i = 0 ; i + width <= length ; i += width)
+    if (data[i] == 0 && (width == 1 || data[i + 1] == 0))
+      return i + width;
+
+  return length;
+}
+
+static int parse_artwork (tihm_t *tihm, u_int8_t *data, int length, int id3v2_majorversion) {
+#if defined(HAVE_ARTWORK)
+  int width, skip;
 
-  fseek (fh, -length, SEEK_CUR);
+  if (tihm->image_data || length < 4)
+    return 0;
+
+  width = (data[0] == 0x01 || data[0] == 0x02) ? 2 : 1;
 
-  /* Skip past type string */
-  for ( ; fgetc (fh) != '\0'; length--);
+  /* encoding, image format (3 characters in v2.2 or a mime type) and picture type */
+  skip = 1 + ((id3v2_majorversion > 2) ? id3v2_skip_string (data + 1, length - 1, 1) : 3) + 1;
+  if (skip >= length)
+    return 0;
 
-  /* Seek to the start of the image data */
-  length -= (id3v2_majorversion > 2) ? 3 : 2;
-  fseek (fh, (id3v2_majorversion > 2) ? 2 : 1, SEEK_CUR);
+  /* description */
+  skip += id3v2_skip_string (data + skip, length - skip, width);
+  if (skip >= length)
+    return 0;
 
-  return read_artwork (fh, tihm, length);
+  return copy_artwork (tihm, data + skip, length - skip);
 #else
-  mp3_debug ("Cover artwork found and ignored (libupod compiled without libwand).\n");
+  mp3_debug ("Cover artwork found and ignored (libupod compiled without artwork support).\n");
 
   return 0;
 #endif
 }
 
 /*
-  parse_id3
+  id3v2_parse_frame:
+
+  Adds the value of one frame to tihm. data points to the frame's data.
 */
-static void one_pass_parse_id3 (FILE *fh, unsigned char *tag_data, int tag_datalen, int version,
-				int id3v2_majorversion, tihm_t *tihm) {
-  int i;
-  char *tag_temp;
-  int length = 0;
+static void id3v2_parse_frame (char *identifier, u_int8_t *data, int length, int id3v2_majorversion,
+			       tihm_t *tihm) {
+  int newv = (id3v2_majorversion > 2) ? 1 : 0;
+  int ipod_type = -1;
+  char value[TAG_DATA_SIZE];
+  char *encoding, *slash;
+  u_int8_t *text;
+  int text_length;
+
+  if (length < 2)
+    return;
+
+  if (strcmp (identifier, ID3_ARTWORK[newv]) == 0) {
+    parse_artwork (tihm, data, length, id3v2_majorversion);
+    return;
+  }
 
-  if (version == 2) {
-    char encoding[11];
-    char enc_type;
-    char identifier[5];
-    int newv = (id3v2_majorversion > 2) ? 1 : 0;
-    int ident_length = (id3v2_majorversion > 2) ? 4 : 3;
+  if (identifier[0] == 'W') {
+    /* url frames do not have an encoding byte */
+    encoding    = "ISO-8859-1";
+    text        = data;
+    text_length = length;
+
+    for ( ; text_length && text[text_length - 1] == '\0' ; text_length--);
+  } else if (strcmp (identifier, ID3_COMMENT[newv]) == 0) {
+    int width = (data[0] == 0x01 || data[0] == 0x02) ? 2 : 1;
+    int skip;
+
+    if (length < 5)
+      return;
+
+    /* skip the language and the short description */
+    skip = 4 + id3v2_skip_string (data + 4, length - 4, width);
+
+    /* id3v2_text needs the encoding byte in front of the text */
+    data[skip - 1] = data[0];
+    text = id3v2_text (data + skip - 1, length - skip + 1, &encoding, &text_length);
+  } else
+    text = id3v2_text (data, length, &encoding, &text_length);
+
+  if (text_length <= 0)
+    return;
+
+  /* terminated copy for values that are parsed here */
+  libupod_to_utf8_buf ((u_int8_t *)value, TAG_DATA_SIZE, text, text_length, encoding);
+
+  mp3_debug ("Tag: ident: %s (enc: %s), data: %s, length: %i\n", identifier, encoding, value, text_length);
+
+  if (strcmp (identifier, ID3_TITLE[newv]) == 0)
+    ipod_type = IPOD_TITLE;
+  else if (strcmp (identifier, ID3_ARTIST[newv]) == 0)
+    ipod_type = IPOD_ARTIST;
+  else if (strcmp (identifier, ID3_ALBUM[newv]) == 0)
+    ipod_type = IPOD_ALBUM;
+  else if (strcmp (identifier, ID3_COMMENT[newv]) == 0)
+    ipod_type = IPOD_COMMENT;
+  else if (strcmp (identifier, ID3_COMPOSER[newv]) == 0)
+    ipod_type = IPOD_COMPOSER;
+  else if (strcmp (identifier, ID3_URL[newv]) == 0)
+    ipod_type = IPOD_URL;
+  else if (strcmp (identifier, ID3_DESC[newv]) == 0)
+    ipod_type = IPOD_DESCRIPTION;
+  else if (strcmp (identifier, ID3_POD_URL[newv]) == 0) {
+    ipod_type = IPOD_PODCAST_URL;
+    mp3_debug ("This is probably a podcast.\n");
+    tihm->is_podcast = 1;
+  } else if (strcmp (identifier, ID3_RELEASE[newv]) == 0) {
+    struct tm release_date;
+
+    memset (&release_date, 0, sizeof (struct tm));
+
+    sscanf (value, "%04d-%02d-%02dT%02d:%02d:%02dZ", &release_date.tm_year,
+	    &release_date.tm_mon, &release_date.tm_mday, &release_date.tm_hour,
+	    &release_date.tm_min, &release_date.tm_sec);
+
+    release_date.tm_year -= 1900;
+    release_date.tm_mon  -= 1;
+    release_date.tm_isdst = -1;
+    release_date.tm_zone = "UTC";
+
+    tihm->year = release_date.tm_year;
+    tihm->release_date = mktime (&release_date);
+  } else if (strcmp (identifier, ID3_TRACK[newv]) == 0) {
+    /* some id3 tags have track/total tracks in the TRCK field */
+    tihm->track = strtol (value, NULL, 10);
+
+    /* set total number of album tracks */
+    if ((slash = strchr (value, '/')) != NULL)
+      tihm->album_tracks = strtol (slash+1, NULL, 10);
+  } else if (strcmp (identifier, ID3_DISC[newv]) == 0) {
+    /* some id3 tags have disk_num/total_disks in the TPOS field */
+    tihm->disk_num = strtol (value, NULL, 10);
+
+    if ((slash = strchr (value, '/')) != NULL)
+      tihm->disk_total = strtol (slash+1, NULL, 10);
+  } else if (strcmp (identifier, ID3_BPM[newv]) == 0) {
+    tihm->bpm = strtol (value, NULL, 10);
+  } else if (strcmp (identifier, ID3_YEARNEW[newv]) == 0 ||
+	     strcmp (identifier, ID3_YEAR[newv]) == 0) {
+    tihm->year = strtol (value, NULL, 10);
+  } else if (strcmp (identifier, ID3_GENRE[newv]) == 0) {
+    int genre;
+
+    ipod_type = IPOD_GENRE;
+
+    if (value[0] == '(') {
+      if ((genre = strtol (value + 1, NULL, 10)) < 0 || genre > 147)
+	return;
 
-    memset (identifier, 0, 5);
+      text        = (u_int8_t *)genre_table[genre];
+      text_length = strlen (genre_table[genre]);
+      encoding    = "ISO-8859-1";
+    }
+  }
 
-    for (i = 0 ; i < tag_datalen ; ) {
-      int ipod_type = -1;
-      char *slash;
+  if (ipod_type != -1)
+    dohm_add (tihm, text, text_length, encoding, ipod_type);
+}
 
-      fread (tag_data, 1, (id3v2_majorversion > 2) ? 10 : 6, fh);
-      
-      if (tag_data[0] == 0)
-	return;
+/*
+  id3v2_parse:
 
-      memcpy (identifier, tag_data, newv ? 4 : 3);
+  Parses the frames of an id3v2 tag. tag holds everything after the 10 byte
+  tag header and is modified (unsynchronisation is undone in place).
+*/
+static void id3v2_parse (u_int8_t *tag, int tag_size, int id3v2_majorversion, int tag_flags,
+			 tihm_t *tihm) {
+  int ident_length = (id3v2_majorversion > 2) ? 4 : 3;
+  int header_size  = (id3v2_majorversion > 2) ? 10 : 6;
+  char identifier[5];
+  u_int8_t *frame, *data;
+  int offset = 0, length, frame_size, frame_flags;
+
+  /* before v2.4 the whole tag is unsynchronised */
+  if ((tag_flags & ID3FLAG_UNSYNC) && id3v2_majorversion < 4)
+    tag_size = id3v2_resync (tag, tag_size);
+
+  if ((tag_flags & ID3FLAG_EXTENDED) && id3v2_majorversion > 2 && tag_size >= 4) {
+    u_int64_t extended_size;
+
+    /* Skip extended header. the v2.4 size includes the size field */
+    if (id3v2_majorversion == 3)
+      extended_size = 4 + (u_int64_t) id3_read32 (tag);
+    else
+      extended_size = (u_int32_t) synchsafe_to_int (tag, 4);
+
+    if (extended_size > (u_int64_t) tag_size) {
+      mp3_debug ("id3v2_parse: extended header is larger than the tag\n");
+      return;
+    }
 
-      /* calculate tag size */
-      if (id3v2_majorversion > 2) {
-	/* id3v2.3 does not use synchsafe integers in frame headers. */
-	if (id3v2_majorversion == 3 || strcmp (identifier, "APIC") == 0 ||
-	    strcmp (identifier, "COMM") == 0 || strcmp (identifier, "COM ") == 0 ||
-	    strcmp (identifier, "GEOB"))
-	  length = big32_2_arch32 (((int *)tag_data)[1]);
-	else
-	  length = synchsafe_to_int (&tag_data[4], 4);
+    offset = (int) extended_size;
+  }
 
-	i += 10 + length;
-      } else {
-	length = (tag_data[3] << 16) | (tag_data[4] << 8) | tag_data[5];
+  memset (identifier, 0, 5);
+
+  for ( ; offset + header_size <= tag_size ; offset += header_size + frame_size) {
+    frame = tag + offset;
+
+    /* padding */
+    if (frame[0] == 0)
+      break;
+
+    memcpy (identifier, frame, ident_length);
+
+    frame_flags = 0;
+
+    /* calculate frame size */
+    if (id3v2_majorversion == 2)
+      frame_size = (frame[3] << 16) | (frame[4] << 8) | frame[5];
+    else if (id3v2_majorversion == 3) {
+      frame_size  = id3_read32 (frame + 4);
+      frame_flags = (frame[9] & 0x80) ? ID3FRAME_COMPRESSED : 0;
+      frame_flags |= (frame[9] & 0x40) ? ID3FRAME_ENCRYPTED : 0;
+      frame_flags |= (frame[9] & 0x20) ? ID3FRAME_GROUPING : 0;
+    } else {
+      frame_size  = synchsafe_to_int (frame + 4, 4);
+      frame_flags = frame[9];
+
+      /* some taggers (iTunes) write v2.3 style sizes in v2.4 tags */
+      if (frame_size != (int)id3_read32 (frame + 4) &&
+	  !id3v2_frame_start (frame + header_size + frame_size, tag_size - offset - header_size - frame_size) &&
+	  id3v2_frame_start (frame + header_size + id3_read32 (frame + 4),
+			     tag_size - offset - header_size - (int)id3_read32 (frame + 4)))
+	frame_size = id3_read32 (frame + 4);
+    }
 
-	i += 6 + length;
-      }
+    if (frame_size < 0 || offset + header_size + frame_size > tag_size) {
+      mp3_debug ("id3v2_parse: frame %s is larger than the tag\n", identifier);
+      break;
+    }
 
-      if (length < 0) {
-	fprintf (stderr, "id3v2 tag data length is < 0... Aborting!\n");
-	break;
-      } else if (length < 2) {
-	fseek (fh, length, SEEK_CUR);
+    if (frame_flags & (ID3FRAME_COMPRESSED | ID3FRAME_ENCRYPTED))
+      continue;
 
-	continue;
+    data   = frame + header_size;
+    length = frame_size;
+
+    if (frame_flags & ID3FRAME_GROUPING) {
+      data++; length--;
+    }
+
+    if (id3v2_majorversion > 3) {
+      if (frame_flags & ID3FRAME_DATALENGTH) {
+	data += 4; length -= 4;
       }
 
-      /* read the first TAG_DATA_SIZE bytes of the tag (TAG_DATA_SIZE is an arbitrary number) */
-      memset (tag_data, 0, TAG_DATA_SIZE);
-      fread (tag_data, 1, (length < TAG_DATA_SIZE) ? length : TAG_DATA_SIZE, fh);
+      if (length > 0 && ((frame_flags & ID3FRAME_UNSYNC) || (tag_flags & ID3FLAG_UNSYNC)))
+	length = id3v2_resync (data, length);
+    }
 
-      if (length > TAG_DATA_SIZE)
-	fseek (fh, length - TAG_DATA_SIZE, SEEK_CUR);
+    if (length > 0)
+      id3v2_parse_frame (identifier, data, length, id3v2_majorversion, tihm);
+  }
+}
 
-      tag_temp = (char *)tag_data;
+static void id3v1_parse (u_int8_t *tag_data, tihm_t *tihm) {
+  char v1_buffer[31];
+  char *tag_temp;
+  int length = 0;
 
-      enc_type = *tag_temp;
+  tag_temp = id3v1_string ((signed char *)&tag_data[3], v1_buffer, &length);
+  dohm_add (tihm, (u_int8_t *)tag_temp, length, "ISO-8859-1", IPOD_TITLE);
 
-      if (strcmp (identifier, ID3_ARTWORK[newv]) != 0 && length < TAG_DATA_SIZE) {
-	for ( ; length && *tag_temp == '\0' ; tag_temp++, length--);
-	/* strip off any trailing \0's */
-	for ( ; length && *(tag_temp+length-1) == '\0' ; length--);
+  tag_temp = id3v1_string ((signed char *)&tag_data[33], v1_buffer, &length);
+  dohm_add (tihm, (u_int8_t *)tag_temp, length, "ISO-8859-1", IPOD_ARTIST);
 
-	if (length == 0)
-	  continue;
-      }
+  tag_temp = id3v1_string ((signed char *)&tag_data[63], v1_buffer, &length);
+  dohm_add (tihm, (u_int8_t *)tag_temp, length, "ISO-8859-1", IPOD_ALBUM);
 
-      /* detect the tag's encoding */
-      switch (enc_type) {
-      case 0x00:
-	sprintf (encoding, "UTF-8");
-	break;
-      case 0x01:
-	sprintf (encoding, "UTF-16LE");
-	/* skip 0x01ff */
-	tag_temp += 3;
-
-	if ((length % 2) != 0)
-	  length++;
-
-	break;
-      case 0x03:
-	sprintf (encoding, "UTF-16BE");
-	tag_temp++;
-	break;
-      case 0x04:
-	sprintf (encoding, "UTF-8");
-	tag_temp++;
-	break;
-      default:
-	sprintf (encoding, "ISO-8859-1");
-      }
+  tag_temp = id3v1_string ((signed char *)&tag_data[97], v1_buffer, &length);
+  if (length > 28 && tag_data[125] == 0)
+    length = 28;
+  dohm_add (tihm, (u_int8_t *)tag_temp, length, "ISO-8859-1", IPOD_COMMENT);
 
-      mp3_debug ("Tag: ident: %s (enc: %s), data: %s, length: %i\n", identifier, encoding, tag_temp, length);
-
-      if (strcmp (identifier, ID3_TITLE[newv]) == 0)
-	ipod_type = IPOD_TITLE;
-      else if (strcmp (identifier, ID3_ARTIST[newv]) == 0)
-	ipod_type = IPOD_ARTIST;
-      else if (strcmp (identifier, ID3_ALBUM[newv]) == 0)
-	ipod_type = IPOD_ALBUM;
-      else if (strcmp (identifier, ID3_COMMENT[newv]) == 0)
-	ipod_type = IPOD_COMMENT;
-      else if (strcmp (identifier, ID3_COMPOSER[newv]) == 0)
-	ipod_type = IPOD_COMPOSER;
-      else if (strcmp (identifier, ID3_URL[newv]) == 0)
-	ipod_type = IPOD_URL;
-      else if (strcmp (identifier, ID3_DESC[newv]) == 0)
-	ipod_type = IPOD_DESCRIPTION;
-      else if (strcmp (identifier, ID3_POD_URL[newv]) == 0) {
-	ipod_type = IPOD_PODCAST_URL;
-	mp3_debug ("This is probably a podcast.\n");
-	tihm->is_podcast = 1;
-      } else if (strcmp (identifier, ID3_RELEASE[newv]) == 0) {
-	struct tm release_date;
-
-	memset (&release_date, 0, sizeof (struct tm));
-
-	sscanf (tag_temp, "%04d-%02d-%02dT%02d:%02d:%02iZ", &release_date.tm_year,
-		&release_date.tm_mon, &release_date.tm_mday, &release_date.tm_hour,
-		&release_date.tm_min, &release_date.tm_sec);
-
-	release_date.tm_year -= 1900;
-	release_date.tm_mon  -= 1;
-	release_date.tm_isdst = -1;
-	release_date.tm_zone = "UTC";
-
-	tihm->year = release_date.tm_year;
-	tihm->release_date = mktime (&release_date);
-      } else if (strcmp (identifier, ID3_ARTWORK[newv]) == 0)
-	parse_artwork (tihm, fh, length, id3v2_majorversion);
-      else if (strcmp (identifier, ID3_TRACK[newv]) == 0) {
-	/* some id3 tags have track/total tracks in the TRCK field */
-	tihm->track = strtol (tag_temp, NULL, 10);
-
-	/* set total number of album tracks */
-	if ((slash = strchr (tag_temp, '/')) != NULL)
-	  tihm->album_tracks = strtol (slash+1, NULL, 10);
-      } else if (strcmp (identifier, ID3_DISC[newv]) == 0) {
-	/* some id3 tags have disk_num/total_disks in the TPOS field */
-	slash = strchr (tag_temp, '/');
-
-	if (slash) *slash = 0;
-
-	tihm->disk_num = strtol (tag_temp, NULL, 10);
-
-	/* set total number of album tracks */
-	if ((slash = strchr (tag_temp, '/')) != NULL)
-	  tihm->disk_total = strtol (slash+1, NULL, 10);
-      } else if (strcmp (identifier, ID3_BPM[newv]) == 0) {
-	tihm->bpm = strtol (tag_temp, NULL, 10);
-      } else if (strcmp (identifier, ID3_YEARNEW[newv]) == 0 ||
-	       strcmp (identifier, ID3_YEAR[newv]) == 0) {
-	tihm->year = strtol (tag_temp, NULL, 10);
-      } else if (strcmp (identifier, ID3_GENRE[newv]) == 0) {
-	if (tag_temp[0] != '(') {
-	  dohm_add (tihm, (u_int8_t *)tag_temp, length, encoding, IPOD_GENRE);
-	} else {
-	  int genre;
-
-	  if ((genre = strtol (tag_temp + 1, NULL, 10)) > 147)
-	    continue;
-
-	  ipod_type = IPOD_GENRE;
-	  tag_temp = genre_table[genre];
-	  length = strlen (genre_table[genre]);
-	  sprintf (encoding, "ISO-8859-1");
-	}
-      }
+  if (tihm->year == 0) {
+    memset (v1_buffer, 0, 5);
+    memcpy (v1_buffer, &tag_data[93], 4);
 
-      if (ipod_type != -1)
-	dohm_add (tihm, (u_int8_t *)tag_temp, length, encoding, ipod_type);
-    }
-  } else if (version == 1) {
-    tag_temp = id3v1_string ((signed char *)&tag_data[3], &length);
-    dohm_add (tihm, (u_int8_t *)tag_temp, length, "ISO-8859-1", IPOD_TITLE);
+    tihm->year = strtol (v1_buffer, NULL, 10);
+  }
 
-    tag_temp = id3v1_string ((signed char *)&tag_data[33], &length);
-    dohm_add (tihm, (u_int8_t *)tag_temp, length, "ISO-8859-1", IPOD_ARTIST);
+  /* id3v1.1 stores the track number in the last byte of the comment */
+  if (tag_data[125] == 0 && tag_data[126] != 0 && tag_data[126] != 0xff && tihm->track == 0)
+    tihm->track = tag_data[126];
 
-    tag_temp = id3v1_string ((signed char *)&tag_data[33], &length);
-    dohm_add (tihm, (u_int8_t *)tag_temp, length, "ISO-8859-1", IPOD_ALBUM);
+  if (tag_data[127] <= 147)
+    dohm_add (tihm, (u_int8_t *)genre_table[tag_data[127]], strlen(genre_table[tag_data[127]]), "ISO-8859-1", IPOD_GENRE);
+}
 
-    tag_temp = id3v1_string ((signed char *)&tag_data[93], &length);
-    dohm_add (tihm, (u_int8_t *)tag_temp, length, "ISO-8859-1", IPOD_COMMENT);
-    
-    if ((tag_data[126] != 0xff) && (tihm->track == 0))
-      tihm->track = tag_data[126];
-    
-    if ((signed char)tag_data[127] != -1)
-      dohm_add (tihm, (u_int8_t *)genre_table[tag_data[127]], strlen(genre_table[tag_data[127]]), "ISO-8859-1", IPOD_GENRE);
+/*
+  id3_read_trailer:
+
+  Reads the end of the file (with a single read) looking for an id3v1 tag
+  and a Lyrics3 v2.00 block.
+
+  Returns:
+   < 0 on error
+     0 on success (trailer is filled in)
+*/
+int id3_read_trailer (struct media_file *media, struct id3_trailer *trailer) {
+  u_int8_t buffer[ID3_TRAILER_SIZE];
+  char lyrics_size[7];
+  off_t file_size = media->statinfo.st_size;
+  int length, end;
+
+  memset (trailer, 0, sizeof (struct id3_trailer));
+
+  length = (file_size < ID3_TRAILER_SIZE) ? file_size : ID3_TRAILER_SIZE;
+
+  if ((int)media_read (media, file_size - length, buffer, length) != length)
+    return -1;
+
+  end = length;
+
+  if (length >= 128 && memcmp (&buffer[length - 128], "TAG", 3) == 0) {
+    mp3_debug ("id3_read_trailer: Found id3v1 tag.\n");
+
+    memcpy (trailer->v1, &buffer[length - 128], 128);
+    trailer->has_v1 = 1;
+    trailer->size  += 128;
+
+    end -= 128;
+  }
+
+  /* Check for Lyrics v2.00. LYRICS200 is preceded by the size of the lyrics */
+  if (end >= 15 && memcmp (&buffer[end - 9], "LYRICS200", 9) == 0) {
+    memcpy (lyrics_size, &buffer[end - 15], 6);
+    lyrics_size[6] = '\0';
+
+    /* Include the size if LYRICS200 (9) and the size field (6) */
+    trailer->size += strtol (lyrics_size, NULL, 10) + 15;
+
+    mp3_debug ("id3_read_trailer: Found Lyrics v2.00 (0x%x Bytes)\n", strtol (lyrics_size, NULL, 10) + 15);
   }
+
+  if (trailer->size > file_size)
+    trailer->size = file_size;
+
+  return 0;
 }
 
-int get_id3_info (FILE *fh, char *file_name, tihm_t *tihm) {
-  int tag_datalen = 0;
-  unsigned char tag_data[TAG_DATA_SIZE];
-  int version;
-  int id3v2_majorversion;
+/*
+  id3_parse_tags:
+
+  Reads the id3v2 tag at the start of the file with a single read (or from
+  the media head if it fits) and parses it in memory. The id3v1 tag in
+  trailer (see id3_read_trailer) is used for anything the id3v2 tag did not
+  set.
+*/
+int id3_parse_tags (struct media_file *media, struct id3_trailer *trailer, tihm_t *tihm) {
+  u_int8_t header[10];
+  u_int8_t *tag;
+  int tag_size;
+
+  if (media == NULL || tihm == NULL)
+    return -EINVAL;
+
+  if (media_read (media, 0, header, 10) == 10 &&
+      memcmp (header, "ID3", 3) == 0 && header[3] >= 2 && header[3] <= 4) {
+    tag_size = synchsafe_to_int (&header[6], 4);
+
+    if (tag_size > media->statinfo.st_size - 10)
+      tag_size = media->statinfo.st_size - 10;
 
-  /* built-in id3tag reading -- id3v2, id3v1 */
-  if ((version = find_id3(2, fh, tag_data, &tag_datalen, &id3v2_majorversion)) != 0)
-    one_pass_parse_id3(fh, tag_data, tag_datalen, version, id3v2_majorversion, tihm);
+    mp3_debug ("id3_parse_tags: found id3v2.%i tag of size %i\n", header[3], tag_size);
+
+    /* the tag is modified while it is parsed so it is always copied */
+    if (tag_size > 0 && (tag = (u_int8_t *) malloc (tag_size)) != NULL) {
+      tag_size = media_read (media, 10, tag, tag_size);
+
+      id3v2_parse (tag, tag_size, header[3], header[5], tihm);
+
+      free (tag);
+    }
+  }
 
   /* some mp3's have both tags so check v1 even if v2 is available */
-  if ((version = find_id3(1, fh, tag_data, &tag_datalen, &id3v2_majorversion)) != 0)
-    one_pass_parse_id3(fh, tag_data, tag_datalen, version, id3v2_majorversion, tihm);
-  
+  if (trailer && trailer->has_v1)
+    id3v1_parse (trailer->v1, tihm);
+
   return 0;
 }
-
@@ -38,34 +38,163 @@
 
 static iihm_t *db_iihm_fill (tree_node_t *iihm_header);
 
+#if defined(HAVE_ARTWORK)
+/* thumbnail dimensions by ithmb file id */
+static struct {
+  int file_id;
+  int width, height;
+} thumb_formats[] = {{1016, 140, 140},
+		     {1017,  56,  56},
+		     {1027, 100, 100},
+		     {1028, 100, 100},
+		     {1029, 200, 200},
+		     {1031,  42,  42},
+		     {0, 0, 0}};
+#endif
+
+/* the thumbnails each device expects, in the order they appear in the iihm */
+static int photo_thumbs[] = {1016, 1017};
+static int nano_thumbs[]  = {1031, 1027};
+static int video_thumbs[] = {1028, 1029};
+
+/* images waiting to be added by db_photo_flush */
+#define PHOTO_QUEUE_IMAGES 64
+#define PHOTO_QUEUE_BYTES  (32 * 1024 * 1024)
+
+struct photo_queue {
+  u_int8_t *image_data[PHOTO_QUEUE_IMAGES];
+  size_t image_sizes[PHOTO_QUEUE_IMAGES];
+  u_int64_t ids[PHOTO_QUEUE_IMAGES];
+
+  int num_images;
+  size_t num_bytes;
+};
+
+/* todo -- get enough information about the ipod to pick the image formats */
+static int device_thumbs (ipoddb_t *photodb, int **file_ids) {
+  switch (photodb->supports_artwork) {
+  case UPOD_PHOTOART:
+    *file_ids = photo_thumbs;
+    return 2;
+  case UPOD_NANOART:
+    *file_ids = nano_thumbs;
+    return 2;
+  case UPOD_VIDEOART:
+    *file_ids = video_thumbs;
+    return 2;
+  default:
+    *file_ids = NULL;
+    return 0;
+  }
+}
+
 int db_thumb_add_artwork_photo (ipoddb_t *photodb, int iihm_identifier, unsigned char *image_data,
 			size_t image_size) {
-  db_thumb_add (photodb, iihm_identifier, image_data, image_size, 1016);
-  db_thumb_add (photodb, iihm_identifier, image_data, image_size, 1017);
+  return db_thumb_add_sizes (photodb, iihm_identifier, image_data, image_size, photo_thumbs, 2);
 }
 
 int db_thumb_add_artwork_nano (ipoddb_t *photodb, int iihm_identifier, unsigned char *image_data,
 			size_t image_size) {
-  db_thumb_add (photodb, iihm_identifier, image_data, image_size, 1031);
-  db_thumb_add (photodb, iihm_identifier, image_data, image_size, 1027);
+  return db_thumb_add_sizes (photodb, iihm_identifier, image_data, image_size, nano_thumbs, 2);
 }
 
 int db_thumb_add_artwork_video (ipoddb_t *photodb, int iihm_identifier, unsigned char *image_data,
 			size_t image_size) {
-  db_thumb_add (photodb, iihm_identifier, image_data, image_size, 1028);
-  db_thumb_add (photodb, iihm_identifier, image_data, image_size, 1029);
+  return db_thumb_add_sizes (photodb, iihm_identifier, image_data, image_size, video_thumbs, 2);
 }
 
 /* The image described by image_data will be scaled to the correct size */
 int db_thumb_add (ipoddb_t *photodb, int iihm_identifier, unsigned char *image_data,
 		  size_t image_size, int file_id) {
-#if defined(HAVE_LIBWAND)
-  tree_node_t *dshm_header;
-  tree_node_t *dohm_header, *inhm_header, *iihm_header;
+  return db_thumb_add_sizes (photodb, iihm_identifier, image_data, image_size, &file_id, 1);
+}
 
-  struct db_iihm *iihm_data;
-  
-  char file_name[255];
+#if defined(HAVE_ARTWORK)
+/* the thumbnails to make for each image */
+struct thumb_set {
+  int *file_ids;
+  int num_file_ids;
+
+  int formats[THUMB_MAX_SIZES]; /* index of each file id in thumb_formats */
+  int order[THUMB_MAX_SIZES];   /* indices of file_ids, largest thumbnail first */
+};
+
+static int thumb_set_init (ipoddb_t *photodb, struct thumb_set *set, int file_ids[], int num_file_ids) {
+  int i, j, k;
+
+  set->file_ids     = file_ids;
+  set->num_file_ids = num_file_ids;
+
+  for (i = 0 ; i < num_file_ids ; i++) {
+    for (j = 0 ; thumb_formats[j].file_id && thumb_formats[j].file_id != file_ids[i] ; j++);
+
+    if (thumb_formats[j].file_id == 0) {
+      db_log (photodb, -1, "Unknown image file id: %i\n", file_ids[i]);
+      return -1;
+    }
+
+    set->formats[i] = j;
+
+    /* largest first */
+    for (k = i ; k > 0 && thumb_formats[set->formats[set->order[k - 1]]].width *
+	   thumb_formats[set->formats[set->order[k - 1]]].height <
+	   thumb_formats[j].width * thumb_formats[j].height ; k--)
+      set->order[k] = set->order[k - 1];
+
+    set->order[k] = i;
+  }
+
+  return 0;
+}
+
+/*
+  thumb_set_reserve (internal):
+
+  Reserves space for every thumbnail of one image in the ithmb files. The
+  space is reserved in the order thumb_set_render would append the
+  thumbnails so the files end up the same either way.
+*/
+static int thumb_set_reserve (ipoddb_t *photodb, struct thumb_set *set, off_t offsets[]) {
+  int i, j, ret;
+
+  for (i = 0 ; i < set->num_file_ids ; i++)
+    offsets[i] = -1;
+
+  for (j = 0 ; j < set->num_file_ids ; j++) {
+    i = set->order[j];
+
+    ret = db_ithmb_reserve (photodb, set->file_ids[i], thumb_formats[set->formats[i]].width *
+			    thumb_formats[set->formats[i]].height * 2, &offsets[i]);
+    if (ret < 0)
+      return ret;
+  }
+
+  return 0;
+}
+
+/*
+  thumb_set_render (internal):
+
+  Makes the thumbnails of one image and writes them to the ithmb files. The
+  image is decoded once and scaled progressively: the largest thumbnail is
+  made from the source and each smaller one from the previous scaled image.
+  The new inhms are returned in inhm_headers (in file_ids order) and are not
+  attached to anything so this can be called from worker threads.
+
+  Arguments:
+   photodb      - opened ArtworkDB
+   set          - thumbnails to make
+   image_data   - encoded (jpeg, png, etc) image
+   image_size   - length of image_data
+   offsets      - space reserved with thumb_set_reserve or NULL to append
+   inhm_headers - new inhms. NULL for thumbnails that could not be made
+
+  Returns:
+   < 0 on error
+     0 on success
+*/
+static int thumb_set_render (ipoddb_t *photodb, struct thumb_set *set, unsigned char *image_data,
+			     size_t image_size, off_t offsets[], tree_node_t *inhm_headers[]) {
   char file_name_mac[32];
 
   int image_height, image_width;
@@ -74,141 +203,238 @@ int db_thumb_add (ipoddb_t *photodb, int iihm_identifier, unsigned char *image_d
 
   int thumb_width, thumb_height;
 
-  char *tmp;
+  struct upod_image source, scaled, thumb;
 
-  MagickWand *magick_wand;
-  PixelWand *pixel_wand;
+  int i, j, ret;
 
-  int ret;
+  memset (inhm_headers, 0, set->num_file_ids * sizeof (tree_node_t *));
 
-  if ((photodb == NULL) || photodb->type != 1 || (iihm_identifier < 1))
-    return -EINVAL;
+  /* Make thumbnails and add them to the database */
+  ret = upod_image_decode (&source, image_data, image_size, thumb_formats[set->formats[set->order[0]]].width,
+			   thumb_formats[set->formats[set->order[0]]].height);
+  if (ret < 0) {
+    db_log (photodb, ret, "thumb_set_render: could not decode the image: %i.\n", ret);
 
-  db_log (photodb, 0, "db_thumb_add: entering...\n");
+    return -1;
+  }
 
-  /* find the image list */
-  if ((ret = db_iihm_retrieve (photodb, &iihm_header, &dshm_header, iihm_identifier)) < 0) {
-    db_log (photodb, ret, "db_thumb_add: could not retrieve image entry\n");
+  image_height = source.height;
+  image_width  = source.width;
+
+  if ((ret = upod_image_copy (&scaled, &source)) < 0) {
+    upod_image_free (&source);
 
     return ret;
   }
 
-  switch (file_id) {
-  case 1016:
-    thumb_width = thumb_height = 140;
-    break;
-  case 1017:
-    thumb_width = thumb_height = 56;
-    break;
-  case 1027:
-  case 1028:
-    thumb_width = thumb_height = 100;
-    break;
-  case 1029:
-    thumb_width = thumb_height = 200;
-    break;
-  case 1031:
-    thumb_width = thumb_height = 42;
-    break;
-  default:
-    db_log (photodb, -1, "Unknown image file id: %i\n");
-    return -1;
+  for (j = 0 ; j < set->num_file_ids ; j++) {
+    i = set->order[j];
+
+    thumb_width  = thumb_formats[set->formats[i]].width;
+    thumb_height = thumb_formats[set->formats[i]].height;
+
+    if (image_width > image_height) {
+      scale_width  = thumb_width;
+      scale_height = (int) ((float)thumb_width * (float) image_height/(float) image_width)/2 * 2;
+    } else {
+      scale_width  = (int) ((float)thumb_height * (float) image_width/(float) image_height)/2 * 2;
+      scale_height = thumb_height;
+    }
+
+    border_width  = (thumb_width - scale_width)/2;
+    border_height = (thumb_height - scale_height)/2;
+
+    /* a thumbnail is only made from the previous one if that one is at least as large */
+    if (scale_width > scaled.width || scale_height > scaled.height) {
+      upod_image_free (&scaled);
+
+      if ((ret = upod_image_copy (&scaled, &source)) < 0)
+	break;
+    }
+
+    if ((ret = upod_image_resize (&scaled, scale_width, scale_height)) < 0 ||
+	(ret = upod_image_copy (&thumb, &scaled)) < 0)
+      break;
+
+    if ((ret = upod_image_border (&thumb, border_width, border_height)) == 0) {
+      /* reserved space only fits a thumbnail of the expected size */
+      if (offsets && (thumb.width != thumb_width || thumb.height != thumb_height))
+	ret = -EIO;
+      else {
+	sprintf (file_name_mac, ":F%i_1.ithmb", set->file_ids[i]);
+
+	ret = db_inhm_create (&inhm_headers[i], photodb, set->file_ids[i], file_name_mac, &thumb,
+			      offsets ? offsets[i] : -1);
+      }
+    }
+
+    upod_image_free (&thumb);
+
+    if (ret < 0) {
+      db_log (photodb, ret, "thumb_set_render: could not create inhm: %s\n", strerror (-ret));
+
+      inhm_headers[i] = NULL;
+      break;
+    }
   }
 
-  /* Make thumbnails and add them to the database */
-  magick_wand = NewMagickWand ();
-  pixel_wand  = NewPixelWand ();
+  upod_image_free (&scaled);
+  upod_image_free (&source);
 
-  PixelSetColor (pixel_wand, "black");
+  return (ret < 0) ? -1 : 0;
+}
 
-  ret = MagickReadImageBlob (magick_wand, image_data, image_size);
-  if (ret == MagickFalse) {
-    DestroyMagickWand (magick_wand);
+/*
+  thumb_set_clear (internal):
 
-    db_log (photodb, ret, "db_thumb_add: ImageMagick returned an error: %i.\n", ret);
+  Zero-fills the reserved space of every thumbnail that thumb_set_render
+  did not make so the ithmb files are never shorter than db_ithmb_size says.
+*/
+static int thumb_set_clear (ipoddb_t *photodb, struct thumb_set *set, off_t offsets[],
+			    tree_node_t *inhm_headers[]) {
+  u_int8_t *zeros;
+  size_t length;
+  int i, ret = 0;
 
-    return -1;
+  for (i = 0 ; i < set->num_file_ids && ret == 0 ; i++) {
+    if (inhm_headers[i] != NULL || offsets[i] < 0)
+      continue;
+
+    length = thumb_formats[set->formats[i]].width * thumb_formats[set->formats[i]].height * 2;
+
+    if ((zeros = (u_int8_t *) calloc (1, length)) == NULL)
+      return -errno;
+
+    ret = db_ithmb_write_at (photodb, set->file_ids[i], zeros, length, offsets[i]);
+
+    free (zeros);
   }
 
-  image_height = MagickGetImageHeight (magick_wand);
-  image_width  = MagickGetImageWidth (magick_wand);
+  return ret;
+}
+
+/* attaches (in file_ids order) the inhms made by thumb_set_render to an image entry */
+static void thumb_set_attach (ipoddb_t *photodb, struct thumb_set *set, tree_node_t *iihm_header,
+			      tree_node_t *inhm_headers[]) {
+  struct db_iihm *iihm_data = (struct db_iihm *)iihm_header->data;
+  tree_node_t *dohm_header;
+  int i;
+
+  for (i = 0 ; i < set->num_file_ids ; i++) {
+    if (inhm_headers[i] == NULL)
+      continue;
 
-  if (image_width > image_height) {
-    scale_width  = thumb_width;
-    scale_height = (int) ((float)thumb_width * (float) image_height/(float) image_width)/2 * 2;
-  } else {
-    scale_width  = (int) ((float)thumb_height * (float) image_width/(float) image_height)/2 * 2;
-    scale_height = thumb_height;
+    db_fihm_register (photodb, set->file_ids[i]);
+
+    db_dohm_create_generic (&dohm_header, 0x18, 0x02);
+
+    db_attach (dohm_header, inhm_headers[i]);
+    db_attach (iihm_header, dohm_header);
+
+    iihm_data->num_thumbs++;
   }
+}
 
-  border_width  = (thumb_width - scale_width)/2;
-  border_height = (thumb_height - scale_height)/2;
-  
-  MagickResizeImage (magick_wand, scale_width, scale_height, LanczosFilter, 0.9);
-  MagickBorderImage (magick_wand, pixel_wand, border_width, border_height);
-  
-  /*
-  if (thumb_width == 173)
-    file_id = 1009;
-  else if (thumb_width == 220)
-    file_id = 1013;
-  else if (thumb_width == 130)
-    file_id = 1015;
-  else if (thumb_width == 712)
-    file_id = 1019;
-  / iPod photo /
-  else if (thumb_width == 140)
-    file_id = 1016;
-  else if (thumb_width == 56)
-    file_id = 1017;
-  / iPod nano /
-  else if (thumb_width == 42)
-    file_id = 1031;
-  else if (thumb_width == 100)
-    file_id = 1027;
-  else
-    file_id = 1008; / Arbitrary /
-  */
-
-  tmp = strdup (photodb->path);
-  sprintf (file_name, "%s/F%lu_1.ithmb", dirname (tmp), file_id);
-  free (tmp);
-
-  sprintf (file_name_mac, ":F%lu_1.ithmb", file_id);
-
-  db_dohm_create_generic (&dohm_header, 0x18, 0x02);
-  ret = db_inhm_create (&inhm_header, file_id, file_name, file_name_mac, magick_wand);
-  if (ret < 0) {
-    db_log (photodb, errno, "db_thumb_add: could not read inhm: %s\n", strerror (errno));
+/* checks the header of an image against the largest thumbnail it will be scaled to */
+static int thumb_set_probe (struct thumb_set *set, u_int8_t *image_data, size_t image_size) {
+  return upod_image_probe (image_data, image_size, thumb_formats[set->formats[set->order[0]]].width,
+			   thumb_formats[set->formats[set->order[0]]].height);
+}
+#endif
 
-    return -1;
+/*
+  db_thumb_add_sizes:
+
+  Adds a thumbnail for each file id to an image entry. The image is decoded
+  once and scaled progressively (see thumb_set_render). The inhms are
+  attached in the order of file_ids.
+
+  Arguments:
+   photodb         - opened ArtworkDB
+   iihm_identifier - image entry to add the thumbnails to
+   image_data      - encoded (jpeg, png, etc) image
+   image_size      - length of image_data
+   file_ids        - ithmb file ids of the thumbnails
+   num_file_ids    - number of file_ids (at most THUMB_MAX_SIZES)
+
+  Returns:
+   < 0 on error
+     0 on success
+*/
+int db_thumb_add_sizes (ipoddb_t *photodb, int iihm_identifier, unsigned char *image_data,
+			size_t image_size, int file_ids[], int num_file_ids) {
+#if defined(HAVE_ARTWORK)
+  tree_node_t *dshm_header, *iihm_header;
+  tree_node_t *inhm_headers[THUMB_MAX_SIZES];
+  struct thumb_set set;
+  int ret;
+
+  if ((photodb == NULL) || photodb->type != 1 || (iihm_identifier < 1) || file_ids == NULL ||
+      num_file_ids < 1 || num_file_ids > THUMB_MAX_SIZES)
+    return -EINVAL;
+
+  db_log (photodb, 0, "db_thumb_add_sizes: entering...\n");
+
+  /* find the image list */
+  if ((ret = db_iihm_retrieve (photodb, &iihm_header, &dshm_header, iihm_identifier)) < 0) {
+    db_log (photodb, ret, "db_thumb_add_sizes: could not retrieve image entry\n");
+
+    return ret;
   }
 
-  db_fihm_register (photodb, file_name, file_id);
+  if ((ret = thumb_set_init (photodb, &set, file_ids, num_file_ids)) < 0)
+    return ret;
 
-  db_attach (dohm_header, inhm_header);
-  db_attach (iihm_header, dohm_header);
+  ret = thumb_set_render (photodb, &set, image_data, image_size, NULL, inhm_headers);
 
-  DestroyMagickWand (magick_wand);
-  DestroyPixelWand (pixel_wand);
+  /* attach whatever was written even if a later thumbnail failed */
+  thumb_set_attach (photodb, &set, iihm_header, inhm_headers);
 
-  iihm_data = (struct db_iihm *)iihm_header->data;
-  iihm_data->num_thumbs++;
+  if (ret < 0)
+    return -1;
 #else
-  db_log (photodb, 0, "db_thumb_add: nothing to do, libupod was not compiled with libwand support.\n");
+  db_log (photodb, 0, "db_thumb_add_sizes: nothing to do, libupod was not compiled with artwork support.\n");
 #endif
 
-  db_log (photodb, 0, "db_thumb_add: complete\n");
+  db_log (photodb, 0, "db_thumb_add_sizes: complete\n");
+
+  return 0;
+}
+
+/* creates and attaches the entry for a new image */
+static int photo_entry_create (ipoddb_t *photodb, tree_node_t *dshm_header, int identifier, u_int64_t id,
+			       tree_node_t **iihm_header) {
+  int ret;
+
+  if ((ret = db_iihm_create (iihm_header, identifier, id)) < 0)
+    return ret;
+
+  (*iihm_header)->parent = dshm_header;
+  db_attach (dshm_header, *iihm_header);
 
   return 0;
 }
 
+/* adds a new image to the artwork album and counts it */
+static void photo_entry_finish (ipoddb_t *photodb, tree_node_t *dshm_header, int identifier) {
+  struct db_dfhm *dfhm_data = (struct db_dfhm *)photodb->tree_root->data;
+  db_ilhm_t *ilhm_data;
+
+  db_album_image_add (photodb, 0, identifier);
+
+  /*  increase the image count in the list header */
+  ilhm_data = (db_ilhm_t *)dshm_header->children[0]->data;
+  ilhm_data->list_entries += 1;
+
+  dfhm_data->next_iihm = identifier + 1;
+}
+
 int db_photo_add (ipoddb_t *photodb, u_int8_t *image_data, size_t image_size, u_int64_t id) {
   tree_node_t *dshm_header, *new_iihm_header;
-  db_ilhm_t *ilhm_data;
   struct db_dfhm *dfhm_data;
 
   int identifier, ret;
+  int *file_ids, num_file_ids;
 
   if ((photodb == NULL) || (image_data == NULL) || (image_size < 1) || (photodb->type != 1))
     return -EINVAL;
@@ -232,52 +458,407 @@ int db_photo_add (ipoddb_t *photodb, u_int8_t *image_data, size_t image_size, u_
 
   identifier = dfhm_data->next_iihm;
 
-  if ((ret = db_iihm_create (&new_iihm_header, identifier, id)) < 0) {
+  if ((ret = photo_entry_create (photodb, dshm_header, identifier, id, &new_iihm_header)) < 0) {
     db_log (photodb, ret, "db_photo_add: could not create image entry\n");
     return ret;
   }
 
-  new_iihm_header->parent = dshm_header;
-  db_attach (dshm_header, new_iihm_header);
-
   db_log (photodb, 0, "db_photo_add: image entry created\n");
   db_log (photodb, 0, "db_photo_add: creating default thumbnails (ArtworkDB thumbs)..\n");
 
-  /* todo -- get enough information about the ipod to pick the image formats */
-  if (photodb->supports_artwork == UPOD_PHOTOART)
-    db_thumb_add_artwork_photo (photodb, identifier, image_data, image_size);
-  if (photodb->supports_artwork == UPOD_NANOART)
-    db_thumb_add_artwork_nano (photodb, identifier, image_data, image_size);
-  if (photodb->supports_artwork == UPOD_VIDEOART)
-    db_thumb_add_artwork_video (photodb, identifier, image_data, image_size);
-
-  db_album_image_add (photodb, 0, identifier);
-
-  /*  increase the image count in the list header */
-  ilhm_data = (db_ilhm_t *)dshm_header->children[0]->data;
-  ilhm_data->list_entries += 1;
+  if ((num_file_ids = device_thumbs (photodb, &file_ids)) > 0)
+    db_thumb_add_sizes (photodb, identifier, image_data, image_size, file_ids, num_file_ids);
 
-  dfhm_data->next_iihm++;
+  photo_entry_finish (photodb, dshm_header, identifier);
 
   db_log (photodb, 0, "db_photo_add: complete\n");
 
   return identifier;
 }
 
+struct photo_batch_entry {
+  u_int64_t id;
+  u_int8_t *image_data;
+  size_t image_size;
+
+  int identifier; /* 0 if the image is not added */
+  int first;      /* first entry with the same id (this entry if there is none) */
+  int ret;
+  int clear_ret;  /* error zero-filling the reserved space */
+
+  off_t offsets[THUMB_MAX_SIZES];
+  tree_node_t *inhm_headers[THUMB_MAX_SIZES];
+};
+
+#if defined(HAVE_ARTWORK)
+struct photo_batch {
+  ipoddb_t *photodb;
+  struct thumb_set set;
+
+  struct photo_batch_entry *entries;
+};
+
+/* upod_work_fn. renders the thumbnails of one image into its reserved space */
+static void photo_batch_render (void *arg, int index) {
+  struct photo_batch *batch = (struct photo_batch *)arg;
+  struct photo_batch_entry *entry = &batch->entries[index];
+
+  if (entry->identifier == 0)
+    return;
+
+  if (entry->ret == 0)
+    entry->ret = thumb_set_render (batch->photodb, &batch->set, entry->image_data, entry->image_size,
+				   entry->offsets, entry->inhm_headers);
+
+  if (entry->ret < 0)
+    entry->clear_ret = thumb_set_clear (batch->photodb, &batch->set, entry->offsets, entry->inhm_headers);
+}
+#endif
+
+/* gives every image in a failed batch the error */
+static int photo_batch_fail (int results[], int num_images, int ret) {
+  int i;
+
+  if (results)
+    for (i = 0 ; i < num_images ; i++)
+      results[i] = ret;
+
+  return ret;
+}
+
+/**
+  db_photo_add_batch:
+
+   Adds many images to an ArtworkDB. Identifiers and space in the ithmb
+  files are handed out in order, the thumbnails are then rendered into that
+  space on worker threads (see ipoddb_t.num_threads), and finally the new
+  entries are attached in order on the calling thread. As long as every
+  image can be decoded the result is the same as calling db_photo_add for
+  each image. Each worker holds one
+  decoded image at a time and writes its thumbnails straight to the ithmb
+  files. Images already in the database (or repeated in the batch) are
+  skipped.
+
+   Unlike db_photo_add an image that can not be decoded is not added (its
+  result is an error code). The header of every image is read before it is
+  given an identifier or any space so unsupported images use neither. If an
+  image passes that check but its data turns out to be damaged the space
+  already reserved for its thumbnails is zero-filled, as is the space of any
+  single thumbnail that could not be made, so the ithmb files always match
+  the sizes recorded in the ArtworkDB. A repeated image gets the result of
+  its first copy if that copy could not be added.
+
+  Arguments:
+   ipoddb_t  *artworkdb     - Opened ArtworkDB
+   u_int8_t  *image_data[]  - Encoded (jpeg, png, etc) images
+   size_t     image_sizes[] - Length of each image
+   u_int64_t  ids[]         - Image ids (see tihm_t.artwork_id)
+   int        num_images    - Number of images
+   int        results[]     - Optional. Gets the identifier of each new image, 0 if
+                              the image is already in the database, or a negative
+                              error code. Also filled in on error.
+
+  Returns:
+   < 0 on error. If reserved space could not be zero-filled the images that
+       were made are still added
+   >=0 number of images added on success
+**/
+int db_photo_add_batch (ipoddb_t *photodb, u_int8_t *image_data[], size_t image_sizes[], u_int64_t ids[],
+			int num_images, int results[]) {
+  tree_node_t *dshm_header, *iihm_header;
+  struct photo_batch_entry *entries, *entry;
+  struct db_dfhm *dfhm_data;
+#if defined(HAVE_ARTWORK)
+  struct photo_batch batch;
+#endif
+  int *file_ids, num_file_ids;
+  int i, j, next_identifier, ret, clear_ret = 0, num_added = 0;
+
+  if (photodb == NULL || photodb->type != 1 || image_data == NULL || image_sizes == NULL ||
+      ids == NULL || num_images < 0)
+    return -EINVAL;
+
+  db_log (photodb, 0, "db_photo_add_batch: entering...\n");
+
+  if (num_images == 0)
+    return 0;
+
+  /* find the image list */
+  if ((ret = db_dshm_retrieve (photodb, &dshm_header, 1)) < 0) {
+    db_log (photodb, ret, "db_photo_add_batch: could not get image list header\n");
+    return photo_batch_fail (results, num_images, ret);
+  }
+
+  num_file_ids = device_thumbs (photodb, &file_ids);
+
+#if defined(HAVE_ARTWORK)
+  if (num_file_ids > 0 && (ret = thumb_set_init (photodb, &batch.set, file_ids, num_file_ids)) < 0)
+    return photo_batch_fail (results, num_images, ret);
+#else
+  num_file_ids = 0;
+#endif
+
+  if ((entries = (struct photo_batch_entry *) calloc (num_images, sizeof (struct photo_batch_entry))) == NULL)
+    return photo_batch_fail (results, num_images, -errno);
+
+  dfhm_data = (struct db_dfhm *)photodb->tree_root->data;
+  next_identifier = dfhm_data->next_iihm;
+
+  /* hand out identifiers and ithmb space in the order db_photo_add would */
+  for (i = 0 ; i < num_images ; i++) {
+    entry = &entries[i];
+
+    entry->id         = ids[i];
+    entry->image_data = image_data[i];
+    entry->image_size = image_sizes[i];
+    entry->first      = i;
+
+    if (image_data[i] == NULL || image_sizes[i] < 1) {
+      entry->ret = -EINVAL;
+      continue;
+    }
+
+    for (j = 0 ; j < i && (entries[j].identifier == 0 || entries[j].id != ids[i]) ; j++);
+
+    if (j < i) {
+      entry->first = j;
+      continue;
+    }
+
+    if (db_lookup_image (photodb, ids[i]))
+      continue;
+
+#if defined(HAVE_ARTWORK)
+    if (num_file_ids > 0 && (entry->ret = thumb_set_probe (&batch.set, image_data[i], image_sizes[i])) < 0) {
+      db_log (photodb, entry->ret, "db_photo_add_batch: image %i is not supported\n", i);
+      continue;
+    }
+#endif
+
+    entry->identifier = next_identifier++;
+
+#if defined(HAVE_ARTWORK)
+    if (num_file_ids > 0)
+      entry->ret = thumb_set_reserve (photodb, &batch.set, entry->offsets);
+#endif
+  }
+
+#if defined(HAVE_ARTWORK)
+  if (num_file_ids > 0) {
+    batch.photodb = photodb;
+    batch.entries = entries;
+
+    upod_parallel_for (upod_thread_count (photodb->num_threads), num_images, photo_batch_render, &batch);
+  }
+#endif
+
+  /* everything past this point happens in order */
+  for (i = 0 ; i < num_images ; i++) {
+    entry = &entries[i];
+
+    if (entry->identifier == 0)
+      continue;
+
+    if (entry->clear_ret < 0 && clear_ret == 0)
+      clear_ret = entry->clear_ret;
+
+    for (j = 0 ; j < num_file_ids && entry->inhm_headers[j] == NULL ; j++);
+
+    /* no thumbnails at all. the image could not be decoded */
+    if (num_file_ids > 0 && j == num_file_ids) {
+      db_log (photodb, entry->ret, "db_photo_add_batch: could not add image %i\n", i);
+
+      entry->ret = (entry->ret < 0) ? entry->ret : -EIO;
+      continue;
+    }
+
+    if ((ret = photo_entry_create (photodb, dshm_header, entry->identifier, entry->id, &iihm_header)) < 0) {
+      db_log (photodb, ret, "db_photo_add_batch: could not create image entry\n");
+
+      for (j = 0 ; j < num_file_ids ; j++)
+	if (entry->inhm_headers[j])
+	  db_free_tree (entry->inhm_headers[j]);
+
+      entry->ret = ret;
+      continue;
+    }
+
+#if defined(HAVE_ARTWORK)
+    if (num_file_ids > 0)
+      thumb_set_attach (photodb, &batch.set, iihm_header, entry->inhm_headers);
+#endif
+
+    if (entry->ret < 0)
+      db_log (photodb, entry->ret, "db_photo_add_batch: could not make every thumbnail for image %i\n",
+	      entry->identifier);
+
+    photo_entry_finish (photodb, dshm_header, entry->identifier);
+
+    entry->ret = entry->identifier;
+    num_added++;
+  }
+
+  if (results)
+    for (i = 0 ; i < num_images ; i++)
+      results[i] = (entries[entries[i].first].ret < 0) ? entries[entries[i].first].ret : entries[i].ret;
+
+  free (entries);
+
+  if (clear_ret < 0) {
+    db_log (photodb, clear_ret, "db_photo_add_batch: could not clear unused thumbnail space\n");
+
+    return clear_ret;
+  }
+
+  db_log (photodb, 0, "db_photo_add_batch: complete. added %i of %i images\n", num_added, num_images);
+
+  return num_added;
+}
+
+/**
+  db_photo_queue:
+
+   Queues a copy of an image to be added to an ArtworkDB. Queued images are
+  added with db_photo_add_batch once enough of them have been queued, when
+  db_photo_flush is called, or when the ArtworkDB is written. At most 64
+  images (or 32 MB of them) are held at a time. Images already in the database (or the queue) are not queued.
+
+   The header of the image is read first and an unsupported image is not
+  queued, so the caller can clear the artwork of the track it came from. An
+  error is also returned when queueing the image filled the queue and
+  adding the queued images failed.
+
+  Arguments:
+   ipoddb_t  *artworkdb  - Opened ArtworkDB
+   u_int8_t  *image_data - Encoded (jpeg, png, etc) image
+   size_t     image_size - Length of image_data
+   u_int64_t  id         - Image id (see tihm_t.artwork_id)
+
+  Returns:
+   < 0 on error
+     0 on success
+**/
+int db_photo_queue (ipoddb_t *photodb, u_int8_t *image_data, size_t image_size, u_int64_t id) {
+  struct photo_queue *queue;
+  u_int8_t *copy;
+  int i, ret;
+#if defined(HAVE_ARTWORK)
+  struct thumb_set set;
+  int *file_ids, num_file_ids;
+#endif
+
+  if ((photodb == NULL) || (image_data == NULL) || (image_size < 1) || (photodb->type != 1))
+    return -EINVAL;
+
+  if (photodb->photo_queue == NULL &&
+      (photodb->photo_queue = (struct photo_queue *) calloc (1, sizeof (struct photo_queue))) == NULL)
+    return -errno;
+
+  queue = photodb->photo_queue;
+
+  for (i = 0 ; i < queue->num_images ; i++)
+    if (queue->ids[i] == id)
+      return 0;
+
+  if (db_lookup_image (photodb, id))
+    return 0;
+
+#if defined(HAVE_ARTWORK)
+  if ((num_file_ids = device_thumbs (photodb, &file_ids)) > 0 &&
+      ((ret = thumb_set_init (photodb, &set, file_ids, num_file_ids)) < 0 ||
+       (ret = thumb_set_probe (&set, image_data, image_size)) < 0))
+    return ret;
+#endif
+
+  if ((copy = (u_int8_t *) malloc (image_size)) == NULL)
+    return -errno;
+
+  memcpy (copy, image_data, image_size);
+
+  queue->image_data[queue->num_images]  = copy;
+  queue->image_sizes[queue->num_images] = image_size;
+  queue->ids[queue->num_images++]       = id;
+  queue->num_bytes += image_size;
+
+  if (queue->num_images == PHOTO_QUEUE_IMAGES || queue->num_bytes >= PHOTO_QUEUE_BYTES)
+    if ((ret = db_photo_flush (photodb)) < 0)
+      return ret;
+
+  return 0;
+}
+
+/**
+  db_photo_flush:
+
+   Adds every image queued with db_photo_queue to the ArtworkDB. Images
+  that could not be added are logged with their ids. Their tracks still
+  refer to them.
+
+  Returns:
+   < 0 on error
+   >=0 number of images added on success
+**/
+int db_photo_flush (ipoddb_t *photodb) {
+  struct photo_queue *queue;
+  int results[PHOTO_QUEUE_IMAGES];
+  int i, ret;
+
+  if (photodb == NULL)
+    return -EINVAL;
+
+  if ((queue = photodb->photo_queue) == NULL || queue->num_images == 0)
+    return 0;
+
+  ret = db_photo_add_batch (photodb, queue->image_data, queue->image_sizes, queue->ids,
+			    queue->num_images, results);
+
+  if (ret < 0)
+    db_log (photodb, ret, "db_photo_flush: could not add every queued image\n");
+
+  for (i = 0 ; i < queue->num_images ; i++) {
+    if (results[i] < 0)
+      db_log (photodb, results[i], "db_photo_flush: could not add image %016llx\n",
+	      (unsigned long long)queue->ids[i]);
+
+    free (queue->image_data[i]);
+  }
+
+  queue->num_images = 0;
+  queue->num_bytes  = 0;
+
+  return ret;
+}
+
+/* frees the queue (and any images in it) without adding them. called by db_free */
+void db_photo_queue_free (ipoddb_t *photodb) {
+  struct photo_queue *queue = photodb->photo_queue;
+  int i;
+
+  if (queue == NULL)
+    return;
+
+  for (i = 0 ; i < queue->num_images ; i++)
+    free (queue->image_data[i]);
+
+  free (queue);
+
+  photodb->photo_queue = NULL;
+}
+
 int db_photo_remove (ipoddb_t *photodb, u_int32_t identifier) {
   UPOD_NOT_IMPL ("db_photo_remove");
 }
 
-int db_photo_list (ipoddb_t *artworkdb, db_list_t **head) {
+int db_photo_list_array (ipoddb_t *artworkdb, db_array_t *photos) {
   tree_node_t *dshm_header, *iihm_header, *ilhm_header;
   db_ilhm_t *ilhm_data;
 
   int i, ret, *iptr;
 
-  if (head == NULL || artworkdb == NULL || artworkdb->type != 1)
+  if (photos == NULL || artworkdb == NULL || artworkdb->type != 1)
     return -EINVAL;
 
-  *head = NULL;
+  db_array_init (photos, 0);
 
   if ((ret = db_dshm_retrieve (artworkdb, &dshm_header, 0x01)) < 0)
     return ret;
@@ -288,7 +869,10 @@ int db_photo_list (ipoddb_t *artworkdb, db_list_t **head) {
   if (ilhm_data->list_entries == 0)
     return -1;
 
-  for (i = dshm_header->num_children - 1 ; i > 0 ; i--) {
+  if ((ret = db_array_init (photos, ilhm_data->list_entries)) < 0)
+    return ret;
+
+  for (i = 1 ; i < dshm_header->num_children ; i++) {
     iihm_header = dshm_header->children[i];
     iptr = (int *)iihm_header->data;
 
@@ -296,9 +880,44 @@ int db_photo_list (ipoddb_t *artworkdb, db_list_t **head) {
     if (iptr[0] != IIHM)
       continue;
 
-    *head = db_list_prepend (*head, db_iihm_fill (iihm_header));
+    db_array_append (photos, db_iihm_fill (iihm_header));
+  }
+
+  return 0;
+}
+
+void db_photo_list_array_free (db_array_t *photos) {
+  int i;
+
+  if (photos == NULL)
+    return;
+
+  for (i = 0 ; i < photos->num_entries ; i++)
+    iihm_free ((iihm_t *)db_array_index (photos, i));
+
+  db_array_free (photos);
+}
+
+int db_photo_list (ipoddb_t *artworkdb, db_list_t **head) {
+  db_array_t photos;
+  int ret;
+
+  if (head == NULL)
+    return -EINVAL;
+
+  *head = NULL;
+
+  if ((ret = db_photo_list_array (artworkdb, &photos)) < 0)
+    return ret;
+
+  if ((*head = db_list_from_array (&photos)) == NULL && photos.num_entries) {
+    db_photo_list_array_free (&photos);
+
+    return -ENOMEM;
   }
 
+  db_array_free (&photos);
+
   return 0;
 }
 
@@ -349,7 +968,7 @@ static iihm_t *db_iihm_fill (tree_node_t *iihm_header) {
 
     iihm->inhms[i].num_dohm    = inhm_data->num_dohm;
     
-    db_dohm_fill (inhm_header, &(iihm->inhms[i].dohms));
+    db_dohm_fill (inhm_header, &(iihm->inhms[i].dohms), NULL);
   }
 
   return iihm;
@@ -19,70 +19,113 @@
 
 #include "itunesdbi.h"
 
-static u_int16_t host16_to_little (u_int16_t x) {
-  return (x & 0x00ff) << 8 | (x & 0xff00) >> 8;
+#if defined(HAVE_ARTWORK)
+/* 4x4 ordered dither thresholds (0-255) */
+static const u_int16_t dither_matrix[4][4] = {{  0, 128,  32, 160},
+					      {192,  64, 224,  96},
+					      { 48, 176,  16, 144},
+					      {240, 112, 208,  80}};
+
+static const u_int16_t no_dither[4] = {0, 0, 0, 0};
+
+/* x/255 for x < 65535 without a divide */
+#define DIV255(x) (((x) + 1 + ((x) >> 8)) >> 8)
+
+/*
+  rgb_to_rgb565 (internal):
+
+  Converts packed 8-bit RGB to little-endian RGB565. The inner loop has no
+  calls or branches so the compiler can vectorize it. Without dithering the
+  low bits are truncated. With dithering a 4x4 ordered dither is added
+  first.
+*/
+static void rgb_to_rgb565 (u_int8_t *rgb, u_int8_t *out, int width, int height, int dither) {
+  const u_int16_t *threshold;
+  u_int16_t r, g, b, pixel;
+  int x, y;
+
+  for (y = 0 ; y < height ; y++, rgb += 3 * width, out += 2 * width) {
+    threshold = dither ? dither_matrix[y & 3] : no_dither;
+
+    for (x = 0 ; x < width ; x++) {
+      r = DIV255 (rgb[3 * x] * 31 + threshold[x & 3]);
+      g = DIV255 (rgb[3 * x + 1] * 63 + threshold[x & 3]);
+      b = DIV255 (rgb[3 * x + 2] * 31 + threshold[x & 3]);
+
+      pixel = b | (g << 5) | (r << 11);
+
+      out[2 * x]     = pixel & 0xff;
+      out[2 * x + 1] = pixel >> 8;
+    }
+  }
 }
 
-#if defined(HAVE_LIBWAND)
-int db_inhm_create (tree_node_t **entry, int file_id, char *file_name,
-		    char *rel_mac_path, MagickWand *magick_wand) {
+/*
+  db_inhm_create:
+
+  Creates an inhm for image and writes the image to the ithmb file for
+  file_id as little-endian RGB565. The image is converted in memory and
+  written with one call. Nothing outside of the new inhm is modified so
+  this can be called from worker threads.
+
+  Arguments:
+   entry        - new inhm
+   photodb      - ArtworkDB. FLAG_DITHER_ARTWORK in its flags turns on dithering
+   file_id      - ithmb file id
+   rel_mac_path - ithmb path relative to the ArtworkDB (":F1016_1.ithmb")
+   image        - scaled image
+   offset       - space reserved for the thumbnail with db_ithmb_reserve
+                  or -1 to append it to the file
+
+  Returns:
+   < 0 on error
+     0 on success
+*/
+int db_inhm_create (tree_node_t **entry, ipoddb_t *photodb, int file_id, char *rel_mac_path,
+		    struct upod_image *image, off_t offset) {
   struct db_inhm *inhm_data;
   tree_node_t *dohm_header;
+  u_int8_t *rgb, *pixels;
   int ret;
-  FILE *fh;
-  unsigned long num_wands = 1;
-  unsigned int r, g, b, i, j;
 
   dohm_t dohm;
 
-  PixelIterator *pixel_iterator;
-  PixelWand **pixel_wands;
-
   if ((ret = db_node_allocate (entry, INHM, INHM_CELL_SIZE, INHM_CELL_SIZE)) < 0)
     return ret;
 
   inhm_data = (struct db_inhm *)(*entry)->data;
   inhm_data->file_id    = file_id;
 
-  inhm_data->height     = MagickGetImageHeight(magick_wand);
-  inhm_data->width      = MagickGetImageWidth(magick_wand);
+  inhm_data->height     = image->height;
+  inhm_data->width      = image->width;
 
   /* Thumbnails are 16 bit rgb images (2 Bpp) */
   inhm_data->image_size = inhm_data->height * inhm_data->width * 2;
-  fh = fopen (file_name, "a");
-
-  if (fh == NULL)
-    return -errno;
 
-  inhm_data->file_offset = ftell (fh);
-
-  /* Write the thumbnail to the thumbnail file */
-  MagickResetIterator(magick_wand);
-  pixel_iterator = NewPixelIterator (magick_wand);
+  if ((pixels = (u_int8_t *) malloc (inhm_data->image_size)) == NULL) {
+    ret = -errno;
+    goto error;
+  }
 
-  j = 0;
+  if ((rgb = upod_image_pixels (image)) == NULL) {
+    ret = -EIO;
+    goto error;
+  }
 
-  while (num_wands != 0) {
-    u_int16_t pixel;
+  rgb_to_rgb565 (rgb, pixels, inhm_data->width, inhm_data->height,
+		 photodb->flags & FLAG_DITHER_ARTWORK);
 
-    pixel_wands = PixelGetNextIteratorRow (pixel_iterator, &num_wands);
+  if (offset < 0)
+    ret = db_ithmb_write (photodb, file_id, pixels, inhm_data->image_size, &offset);
+  else
+    ret = db_ithmb_write_at (photodb, file_id, pixels, inhm_data->image_size, offset);
 
-    for (i = 0 ; i < num_wands ; i++) {
-      r = (int)(PixelGetRed (pixel_wands[i]) * 31.0);
-      g = (int)(PixelGetGreen (pixel_wands[i]) * 63.0);
-      b = (int)(PixelGetBlue (pixel_wands[i]) * 31.0);
-      
-      pixel = 0x07c0;
-      pixel = b | (g << 5) | (r << 11);
-      pixel = host16_to_little (pixel);
+  if (ret < 0)
+    goto error;
 
-      (void)fwrite (&pixel, 2, 1, fh);
-    }
+  inhm_data->file_offset = offset;
 
-    j++;
-  }
-  
-  (void)fclose (fh);
+  free (pixels);
 
   dohm.data = (u_int8_t *)rel_mac_path;
   dohm.type = 3;
@@ -92,9 +135,15 @@ int db_inhm_create (tree_node_t **entry, int file_id, char *file_name,
   
   inhm_data = (struct db_inhm *)(*entry)->data;
   inhm_data->num_dohm++;
-  
-  pixel_iterator = DestroyPixelIterator (pixel_iterator);
 
   return 0;
+
+ error:
+  free (pixels);
+
+  db_free_tree (*entry);
+  *entry = NULL;
+
+  return ret;
 }
 #endif
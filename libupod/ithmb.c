@@ -0,0 +1,320 @@
+/**
+ *   (c) 2007 Nathan Hjelm <hjelmn@users.sourceforge.net>
+ *   v0.1.0 ithmb.c
+ *
+ *   Keeps the thumbnail (F<id>_1.ithmb) files of an ArtworkDB open and
+ *   hands out space at their ends. Space is reserved under a lock so
+ *   thumbnails can be written from several threads at once.
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the Lesser GNU Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the Lesser GNU Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ **/
+
+#include "itunesdbi.h"
+
+#include <libgen.h>
+
+#if defined(HAVE_LIBPTHREAD)
+#include <pthread.h>
+#endif
+
+struct ithmb_file {
+  int file_id;
+  int fd;
+  off_t end; /* everything before this offset has been handed out */
+};
+
+struct ithmb_writer {
+  struct ithmb_file *files;
+  int num_files;
+
+  char *dir; /* directory holding the ArtworkDB and its ithmb files */
+
+#if defined(HAVE_LIBPTHREAD)
+  pthread_mutex_t lock;
+#endif
+};
+
+#if defined(HAVE_LIBPTHREAD)
+#define writer_lock(writer)   pthread_mutex_lock (&(writer)->lock)
+#define writer_unlock(writer) pthread_mutex_unlock (&(writer)->lock)
+#else
+#define writer_lock(writer)
+#define writer_unlock(writer)
+#endif
+
+/*
+  db_ithmb_open:
+
+  Sets up the ithmb writer of an ArtworkDB. Files are opened the first time
+  they are written to. Called by db_load and db_photo_create.
+
+  Returns:
+   < 0 on error
+     0 on success
+*/
+int db_ithmb_open (ipoddb_t *photodb) {
+  struct ithmb_writer *writer;
+  char *tmp;
+
+  if (photodb == NULL || photodb->path == NULL)
+    return -EINVAL;
+
+  if (photodb->ithmb_writer)
+    return 0;
+
+  if ((writer = (struct ithmb_writer *) calloc (1, sizeof (struct ithmb_writer))) == NULL)
+    return -errno;
+
+  tmp = strdup (photodb->path);
+  writer->dir = strdup (dirname (tmp));
+  free (tmp);
+
+#if defined(HAVE_LIBPTHREAD)
+  pthread_mutex_init (&writer->lock, NULL);
+#endif
+
+  photodb->ithmb_writer = writer;
+
+  return 0;
+}
+
+/* find (or open) the file for file_id. called with the lock held */
+static struct ithmb_file *ithmb_file_get (ipoddb_t *photodb, int file_id) {
+  struct ithmb_writer *writer = photodb->ithmb_writer;
+  struct ithmb_file *files;
+  struct stat statinfo;
+  char file_name[255];
+  int i, fd;
+
+  for (i = 0 ; i < writer->num_files ; i++)
+    if (writer->files[i].file_id == file_id)
+      return &writer->files[i];
+
+  snprintf (file_name, 255, "%s/F%i_1.ithmb", writer->dir, file_id);
+
+  /* not O_APPEND. the writes go to the reserved offsets */
+  if ((fd = open (file_name, O_WRONLY | O_CREAT, 0666)) < 0) {
+    db_log (photodb, -errno, "db_ithmb_write: could not open %s: %s\n", file_name, strerror (errno));
+
+    return NULL;
+  }
+
+  files = (struct ithmb_file *) realloc (writer->files, (writer->num_files + 1) * sizeof (struct ithmb_file));
+  if (files == NULL || fstat (fd, &statinfo) < 0) {
+    close (fd);
+
+    if (files)
+      writer->files = files;
+
+    return NULL;
+  }
+
+  writer->files = files;
+
+  files[writer->num_files].file_id = file_id;
+  files[writer->num_files].fd      = fd;
+  files[writer->num_files].end     = statinfo.st_size;
+
+  return &files[writer->num_files++];
+}
+
+/*
+  db_ithmb_reserve:
+
+  Hands out length bytes at the end of the ithmb file for file_id. Nothing
+  is written. The space belongs to the caller, who fills it in with
+  db_ithmb_write_at.
+
+  Arguments:
+   photodb - ArtworkDB
+   file_id - ithmb file id
+   length  - bytes to reserve
+   offset  - offset of the reserved space in the ithmb file
+
+  Returns:
+   < 0 on error
+     0 on success
+*/
+int db_ithmb_reserve (ipoddb_t *photodb, int file_id, size_t length, off_t *offset) {
+  struct ithmb_file *file;
+
+  if (photodb == NULL || photodb->ithmb_writer == NULL || offset == NULL)
+    return -EINVAL;
+
+  writer_lock (photodb->ithmb_writer);
+
+  if ((file = ithmb_file_get (photodb, file_id)) != NULL) {
+    *offset = file->end;
+
+    file->end += length;
+  }
+
+  writer_unlock (photodb->ithmb_writer);
+
+  return (file == NULL) ? -EIO : 0;
+}
+
+/*
+  db_ithmb_write_at:
+
+  Writes length bytes of data to space in the ithmb file for file_id that
+  was handed out by db_ithmb_reserve. Only the file lookup is done under the
+  lock so any number of threads can write at once.
+
+  Returns:
+   < 0 on error
+     0 on success
+*/
+int db_ithmb_write_at (ipoddb_t *photodb, int file_id, u_int8_t *data, size_t length, off_t offset) {
+  struct ithmb_file *file;
+  size_t written;
+  ssize_t ret;
+  int fd = -1;
+
+  if (photodb == NULL || photodb->ithmb_writer == NULL || data == NULL || offset < 0)
+    return -EINVAL;
+
+  writer_lock (photodb->ithmb_writer);
+
+  if ((file = ithmb_file_get (photodb, file_id)) != NULL)
+    fd = file->fd;
+
+  writer_unlock (photodb->ithmb_writer);
+
+  if (file == NULL)
+    return -EIO;
+
+  for (written = 0 ; written < length ; written += ret) {
+    ret = pwrite (fd, data + written, length - written, offset + written);
+
+    if (ret < 0 && errno == EINTR)
+      ret = 0;
+    else if (ret <= 0)
+      return (ret < 0) ? -errno : -EIO;
+  }
+
+  return 0;
+}
+
+/*
+  db_ithmb_write:
+
+  Appends length bytes of data to the ithmb file for file_id (see
+  db_ithmb_reserve and db_ithmb_write_at).
+
+  Arguments:
+   photodb - ArtworkDB
+   file_id - ithmb file id
+   data    - thumbnail
+   length  - length of data
+   offset  - offset in the ithmb file the thumbnail was written to
+
+  Returns:
+   < 0 on error
+     0 on success
+*/
+int db_ithmb_write (ipoddb_t *photodb, int file_id, u_int8_t *data, size_t length, off_t *offset) {
+  int ret;
+
+  if (data == NULL)
+    return -EINVAL;
+
+  if ((ret = db_ithmb_reserve (photodb, file_id, length, offset)) < 0)
+    return ret;
+
+  return db_ithmb_write_at (photodb, file_id, data, length, *offset);
+}
+
+/*
+  db_ithmb_size:
+
+  Returns the size the ithmb file for file_id will have once every reserved
+  thumbnail is written. If the file has not been written to the file
+  system is asked.
+*/
+off_t db_ithmb_size (ipoddb_t *photodb, int file_id) {
+  struct ithmb_writer *writer = photodb->ithmb_writer;
+  struct stat statinfo;
+  char file_name[255];
+  off_t size = -1;
+  int i;
+
+  if (writer == NULL)
+    return -EINVAL;
+
+  writer_lock (writer);
+
+  for (i = 0 ; i < writer->num_files ; i++)
+    if (writer->files[i].file_id == file_id)
+      size = writer->files[i].end;
+
+  writer_unlock (writer);
+
+  if (size < 0) {
+    snprintf (file_name, 255, "%s/F%i_1.ithmb", writer->dir, file_id);
+
+    size = (stat (file_name, &statinfo) < 0) ? 0 : statinfo.st_size;
+  }
+
+  return size;
+}
+
+/*
+  db_ithmb_flush:
+
+  Makes sure every thumbnail written so far is on disk. Called by db_write
+  before the ArtworkDB that points at the thumbnails is written.
+*/
+int db_ithmb_flush (ipoddb_t *photodb) {
+  struct ithmb_writer *writer = photodb->ithmb_writer;
+  int i, ret = 0;
+
+  if (writer == NULL)
+    return 0;
+
+  writer_lock (writer);
+
+  for (i = 0 ; i < writer->num_files ; i++)
+    if (fsync (writer->files[i].fd) < 0) {
+      ret = -errno;
+      db_log (photodb, ret, "db_ithmb_flush: fsync failed: %s\n", strerror (errno));
+    }
+
+  writer_unlock (writer);
+
+  return ret;
+}
+
+/* closes every ithmb file. called by db_free */
+void db_ithmb_close (ipoddb_t *photodb) {
+  struct ithmb_writer *writer = photodb->ithmb_writer;
+  int i;
+
+  if (writer == NULL)
+    return;
+
+  for (i = 0 ; i < writer->num_files ; i++)
+    close (writer->files[i].fd);
+
+#if defined(HAVE_LIBPTHREAD)
+  pthread_mutex_destroy (&writer->lock);
+#endif
+
+  free (writer->files);
+  free (writer->dir);
+  free (writer);
+
+  photodb->ithmb_writer = NULL;
+}
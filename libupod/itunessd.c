@@ -151,6 +151,7 @@ int sd_load (ipoddb_t *ipod_sd, char *path, int flags) {
 
   ipod_sd->path = strdup (path);
   ipod_sd->type = 2;
+  ipod_sd->string_pool = NULL;
 
   db_log (ipod_sd, 0, "sd_load: complete. %i Bytes\n", statinfo.st_size);
 
@@ -319,6 +320,7 @@ int sd_create (ipoddb_t *ipod_sd, u_int8_t *path, int flags) {
   ipod_sd->flags = flags;
   ipod_sd->type  = 2;
   ipod_sd->path  = strdup ((char *)path);
+  ipod_sd->string_pool = NULL;
 
   set_uint24 (ipod_sd->tree_root->data, 1, 0x010600);
   set_uint24 (ipod_sd->tree_root->data, 2, 18);
@@ -352,24 +354,25 @@ int sd_write (ipoddb_t ipod_sd, char *path) {
   return ret;
 }
 
-int sd_song_list (ipoddb_t *ipod_sd, db_list_t **head) {
-  int i;
+int sd_song_list_array (ipoddb_t *ipod_sd, db_array_t *songs) {
+  int i, ret;
   int num_songs;
   int header_size;
   unsigned char *song_list;
 
   tihm_t *tihm;
 
-  if (head == NULL || ipod_sd == NULL || ipod_sd->type != 2)
+  if (songs == NULL || ipod_sd == NULL || ipod_sd->type != 2)
     return -EINVAL;
 
-  *head = NULL;
-
   num_songs = get_uint24 (ipod_sd->tree_root->data, 0);
   header_size = get_uint24 (ipod_sd->tree_root->data, 2);
   song_list = &ipod_sd->tree_root->data[header_size];
 
-  for (i = num_songs-1 ; i >= 0 ; i--) {
+  if ((ret = db_array_init (songs, num_songs)) < 0)
+    return ret;
+
+  for (i = 0 ; i < num_songs ; i++) {
     tihm = calloc (1, sizeof (tihm_t));
 
     tihm->num = i;
@@ -379,8 +382,31 @@ int sd_song_list (ipoddb_t *ipod_sd, db_list_t **head) {
     tihm->dohms->type = IPOD_PATH;
     to_utf8 (&(tihm->dohms->data), &song_list[i * 0x00022e + 32], 522, "UTF-16BE");
 
-    *head = db_list_prepend (*head, tihm);
+    db_array_append (songs, tihm);
   }
 
   return 0;
 }
+
+int sd_song_list (ipoddb_t *ipod_sd, db_list_t **head) {
+  db_array_t songs;
+  int ret;
+
+  if (head == NULL)
+    return -EINVAL;
+
+  *head = NULL;
+
+  if ((ret = sd_song_list_array (ipod_sd, &songs)) < 0)
+    return ret;
+
+  if ((*head = db_list_from_array (&songs)) == NULL && songs.num_entries) {
+    db_song_list_array_free (&songs);
+
+    return -ENOMEM;
+  }
+
+  db_array_free (&songs);
+
+  return 0;
+}
@@ -21,6 +21,7 @@
 
 #include "itunesdbi.h"
 
+/* O(1) when p is the head of the list (as returned by the list functions) */
 db_list_t *db_list_first (db_list_t *p) {
   db_list_t *x;
 
@@ -32,12 +33,15 @@ db_list_t *db_list_first (db_list_t *p) {
 db_list_t *db_list_prepend (db_list_t *p, void *d) {
   db_list_t *x, *y;
 
-  x = calloc (1, sizeof (db_list_t));
+  if ((x = calloc (1, sizeof (db_list_t))) == NULL)
+    return NULL;
+
   x->data = d;
 
   y = db_list_first (p);
 
   x->next = y;
+  x->last = y ? y->last : x;
 
   if (y)
     y->prev = x;
@@ -45,22 +49,26 @@ db_list_t *db_list_prepend (db_list_t *p, void *d) {
   return x;
 }
 
+/* the head keeps a pointer to the last entry so appending does not walk the list */
 db_list_t *db_list_append (db_list_t *p, void *d) {
   db_list_t *x, *y;
 
-  x = calloc (1, sizeof (db_list_t));
-  x->data = d;
+  if ((x = calloc (1, sizeof (db_list_t))) == NULL)
+    return NULL;
 
-  for (y = db_list_first (p) ; y && y->next ; y = db_list_next (y));
+  x->data = d;
 
-  x->prev = y;
+  if ((y = db_list_first (p)) == NULL) {
+    x->last = x;
 
-  if (y) {
-    y->next = x;
-    return p;
+    return x;
   }
 
-  return x;
+  x->prev = y->last;
+  y->last->next = x;
+  y->last = x;
+
+  return p;
 }
 
 db_list_t *db_list_next (db_list_t *p) {
@@ -81,3 +89,116 @@ void db_list_free (db_list_t *p) {
     p = tmp;
   }
 }
+
+/**
+  db_array_init:
+
+   Initializes an empty array with room for size entries. The array grows as
+  needed so size is only a hint.
+
+  Returns:
+   < 0 on error
+     0 on success
+**/
+int db_array_init (db_array_t *array, int size) {
+  if (array == NULL || size < 0)
+    return -EINVAL;
+
+  memset (array, 0, sizeof (db_array_t));
+
+  if (size) {
+    array->data = calloc (size, sizeof (void *));
+    if (array->data == NULL)
+      return -errno;
+
+    array->size = size;
+  }
+
+  return 0;
+}
+
+/**
+  db_array_append:
+
+   Appends d to the end of the array. The storage is doubled when it is full
+  so appending n entries takes O(n) time.
+
+  Returns:
+   < 0 on error
+   >=0 index of the new entry
+**/
+int db_array_append (db_array_t *array, void *d) {
+  if (array == NULL)
+    return -EINVAL;
+
+  if (array->num_entries == array->size) {
+    int new_size = array->size ? 2 * array->size : 16;
+    void **new_data;
+
+    new_data = realloc (array->data, new_size * sizeof (void *));
+    if (new_data == NULL)
+      return -errno;
+
+    array->data = new_data;
+    array->size = new_size;
+  }
+
+  array->data[array->num_entries] = d;
+
+  return array->num_entries++;
+}
+
+/**
+  db_array_free:
+
+   Frees the storage used by the array. The entries themselves are not freed.
+**/
+void db_array_free (db_array_t *array) {
+  if (array == NULL)
+    return;
+
+  if (array->data)
+    free (array->data);
+
+  memset (array, 0, sizeof (db_array_t));
+}
+
+/**
+  db_list_from_array:
+
+   Builds a linked list with the same entries (in the same order) as array.
+  The array still owns its storage and should be freed with db_array_free.
+
+  Returns:
+   pointer to head of linked list (NULL if the array is empty or on error)
+**/
+db_list_t *db_list_from_array (db_array_t *array) {
+  db_list_t *head = NULL, *tail = NULL, *x;
+  int i;
+
+  if (array == NULL)
+    return NULL;
+
+  for (i = 0 ; i < array->num_entries ; i++) {
+    if ((x = calloc (1, sizeof (db_list_t))) == NULL) {
+      db_list_free (head);
+
+      return NULL;
+    }
+
+    x->data = array->data[i];
+    x->prev = tail;
+
+    if (tail)
+      tail->next = x;
+    else
+      head = x;
+
+    tail = x;
+  }
+
+  if (head)
+    head->last = tail;
+
+  return head;
+}
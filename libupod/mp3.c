@@ -36,6 +36,10 @@
 
 #include <stdarg.h>
 
+#if defined(HAVE_SYS_MMAN_H)
+#include <sys/mman.h>
+#endif
+
 #ifdef HAVE_LIBGEN_H
 #include <libgen.h>
 #endif
@@ -72,6 +76,19 @@ struct mp3_file {
   long long samples;
   int xdata_size;
 
+  /* samples added by the encoder (from a LAME tag) */
+  int encoder_delay;
+  int encoder_padding;
+
+  /* the first frame holds an Xing/Info/VBRI header instead of audio */
+  int info_frame;
+
+  /* count every frame (FLAG_EXACT_DURATION) */
+  int exact;
+
+  /* id3v1 tag and lyrics at the end of the file */
+  struct id3_trailer trailer;
+
   int layer_index;
   int version_index;
 
@@ -145,20 +162,27 @@ int id3v2_size (unsigned char buf[14]);
 #define SAMPLERATE(header) samplerate_table[MPEG_VERSION(header)][MPEG_SAMPLERATEI(header)]
 #define PADDING(header) ((MPEG_LAYER(header) == 0x3) ? 4 : 1)
 
-static size_t mpeg_frame_length (int header) {
-  double bitrate = (double)BITRATE(header) * 1000.0;
-  double samplerate = (double)SAMPLERATE(header);
-  double padding = (double)MPEG_PADDING(header);
-  char layer = MPEG_LAYER(header);
-  size_t frame_length;
+/* sync, version, layer and sample rate bits. these do not change within a stream */
+#define MPEG_STREAM_MASK 0xfffe0c00
 
-  if (layer == 0x11)
-    frame_length = 144.0 * bitrate/samplerate + padding;
-  else
-    frame_length = (12 * bitrate/samplerate + padding) * 4.0;
+/* bytes per slot * samples per frame / 8: frame_coefficient[version_index][layer_index] */
+static int frame_coefficient[4][4] = {
+  {-1,  72, 144, 12}, /*    v2.5 */
+  {-1,  -1,  -1, -1}, /* NOTUSED */
+  {-1,  72, 144, 12}, /*      v2 */
+  {-1, 144, 144, 12}  /*      v1 */
+};
+
+/* returns the length (in bytes) of the frame starting with header. header must be valid. */
+static int mpeg_frame_length (int header) {
+  int coefficient = frame_coefficient[MPEG_VERSION(header)][MPEG_LAYER(header)];
+  int length = coefficient * BITRATE(header) * 1000 / SAMPLERATE(header) + MPEG_PADDING(header);
+
+  /* layer I frames are made up of 4 byte slots */
+  if (MPEG_LAYER(header) == 0x3)
+    length = (coefficient * BITRATE(header) * 1000 / SAMPLERATE(header) + MPEG_PADDING(header)) * 4;
 
-  return (size_t)((layer != 0x11) ? (144.0 * bitrate/samplerate + padding)
-	  : (12 * bitrate/samplerate + padding) * 4.0);
+  return length;
 }
 
 /* check_mp3_header: returns 0 on success */
@@ -173,126 +197,232 @@ static int check_mp3_header (int header) {
     return 1;
 }
 
-static int find_first_frame (struct mp3_file *mp3) {
-  int header;
-  int buffer;
-  int ret;
-  mp3->skippage = 0;
+/* size of the blocks read while looking for a frame header */
+#define SCAN_BUFFER_SIZE 32768
 
-  while (fread (&header, 4, 1, mp3->fh)) {
-    header = big32_2_arch32 (header);
+/* bytes following a frame header needed to probe for Xing/LAME and VBRI headers */
+#define XING_PROBE_SIZE 192
 
-    /* MPEG-1 Layer III */
-    if ((ret = check_mp3_header (header)) == 0) {
-      /* Check for an Xing frame (speeds up parsing) */
-      fseek (mp3->fh, 32, SEEK_CUR);
-      fread (&buffer, 4, 1, mp3->fh);
+/* reads a big-endian integer (0 if it lies outside the buffer) */
+static u_int32_t mpeg_read_be32 (u_int8_t *buffer, int offset, int length) {
+  if (offset < 0 || offset + 4 > length)
+    return 0;
 
-      if (buffer == string_to_int ("Xing")) {
-	int xstart = ftell (mp3->fh);
-	int xflags;
+  return ((u_int32_t)buffer[offset] << 24) | ((u_int32_t)buffer[offset + 1] << 16) |
+    ((u_int32_t)buffer[offset + 2] << 8) | (u_int32_t)buffer[offset + 3];
+}
 
-	/* an mp3 with an Xing header is ALWAYS vbr */
-	mp3->vbr = 1;
+/* size of the layer III side information that follows the frame header */
+static int mpeg_side_info_size (int header) {
+  int mono = ((header & 0x000000c0) == 0x000000c0);
 
-	fread (&xflags, 4, 1, mp3->fh);
+  if (MPEG_VERSION(header) == 3)
+    return mono ? 17 : 32;
 
-	mp3_debug ("Xing flags = %08x\n", xflags);
+  return mono ? 9 : 17;
+}
 
-	if (xflags & 0x00000001) {
-	  fread (&buffer, 4, 1, mp3->fh);
-	  mp3->frames = buffer;
+/*
+  mp3_probe_vbr_headers (internal):
 
-	  mp3_debug ("MPEG file has %i frames\n", mp3->frames);
-	}
+  Reads the frame count and data size from an Xing/Info header (plus the
+  encoder delay and padding from a LAME tag) or from a Fraunhofer VBRI header
+  in the first frame (buffer[0] is the frame header). All values are stored
+  big-endian.
+*/
+static void mp3_probe_vbr_headers (struct mp3_file *mp3, int header, u_int8_t *buffer, int length) {
+  int offset = 4 + mpeg_side_info_size (header);
+  int xflags;
 
-	if (xflags & 0x00000002) {
-	  fread (&buffer, 4, 1, mp3->fh);
-	  mp3->xdata_size = buffer;
+  if (offset + 8 <= length && (memcmp (&buffer[offset], "Xing", 4) == 0 ||
+			       memcmp (&buffer[offset], "Info", 4) == 0)) {
+    /* Info is written by LAME for CBR files */
+    mp3->vbr = (buffer[offset] == 'X');
+    mp3->info_frame = 1;
 
-	  mp3_debug ("MPEG file has %i bytes of data\n", mp3->xdata_size);
-	}
+    xflags  = mpeg_read_be32 (buffer, offset + 4, length);
+    offset += 8;
+
+    mp3_debug ("Xing flags = %08x\n", xflags);
+
+    if (xflags & 0x00000001) {
+      mp3->frames = mpeg_read_be32 (buffer, offset, length);
+      offset += 4;
+
+      mp3_debug ("MPEG file has %i frames\n", mp3->frames);
+    }
+
+    if (xflags & 0x00000002) {
+      mp3->xdata_size = mpeg_read_be32 (buffer, offset, length);
+      offset += 4;
+
+      mp3_debug ("MPEG file has %i bytes of data\n", mp3->xdata_size);
+    }
+
+    /* seek table and quality indicator */
+    if (xflags & 0x00000004)
+      offset += 100;
+    if (xflags & 0x00000008)
+      offset += 4;
+
+    /* LAME tag: 12 bits of encoder delay and 12 bits of padding at byte 21 */
+    if (offset + 24 <= length && (memcmp (&buffer[offset], "LAME", 4) == 0 ||
+				  memcmp (&buffer[offset], "Lavf", 4) == 0 ||
+				  memcmp (&buffer[offset], "Lavc", 4) == 0)) {
+      mp3->encoder_delay   = (buffer[offset + 21] << 4) | (buffer[offset + 22] >> 4);
+      mp3->encoder_padding = ((buffer[offset + 22] & 0x0f) << 8) | buffer[offset + 23];
+
+      mp3_debug ("LAME tag: encoder delay = %i, padding = %i\n", mp3->encoder_delay,
+		 mp3->encoder_padding);
+    }
+  } else if (36 + 18 <= length && memcmp (&buffer[36], "VBRI", 4) == 0) {
+    /* the VBRI header always follows 32 bytes of side information */
+    mp3->vbr        = 1;
+    mp3->info_frame = 1;
+    mp3->xdata_size = mpeg_read_be32 (buffer, 36 + 10, length);
+    mp3->frames     = mpeg_read_be32 (buffer, 36 + 14, length);
+
+    mp3_debug ("VBRI: MPEG file has %i frames and %i bytes of data\n", mp3->frames,
+	       mp3->xdata_size);
+  }
+}
 
-	fseek (mp3->fh, xstart, SEEK_SET);
+/*
+  mp3_scan_block (internal):
+
+  Looks for a valid frame header (or an MLLT frame) in buffer. Only 0xff and
+  'M' bytes can start either so everything else is skipped with memchr.
+
+  Returns the offset of the match (and sets *ret to the result of
+  check_mp3_header) or -1 if no header starts in the first length - 3 bytes.
+*/
+static int mp3_scan_block (u_int8_t *buffer, int length, int *ret) {
+  u_int8_t *sync, *mllt;
+  int offset = 0, end, header;
+
+  while (offset + 4 <= length) {
+    sync = memchr (&buffer[offset], 0xff, length - 3 - offset);
+    end  = sync ? (sync - buffer) : (length - 3);
+
+    for (mllt = memchr (&buffer[offset], 'M', end - offset) ; mllt ;
+	 mllt = memchr (mllt + 1, 'M', end - (mllt + 1 - buffer)))
+      if (memcmp (mllt, "MLLT", 4) == 0) {
+	*ret = 2;
+	return mllt - buffer;
       }
 
-      mp3->initial_header = header;
-      mp3->samplerate  = SAMPLERATE(header);
-      mp3->layer_index = MPEG_LAYER(header);
-      mp3->version_index = MPEG_VERSION(header);
+    if (sync == NULL)
+      break;
 
-      mp3_debug ("Inital bitrate = %i\n", BITRATE(header));
+    header = mpeg_read_be32 (buffer, end, length);
 
-      fseek (mp3->fh, -40, SEEK_CUR);
-      return 0;
-    } else if (ret == 2)
-      return -2;
-    
-    fseek (mp3->fh, -3, SEEK_CUR);
-    mp3->skippage++;
+    if ((*ret = check_mp3_header (header)) == 0)
+      return end;
+
+    offset = end + 1;
   }
 
   return -1;
 }
 
-static int mp3_open (char *file_name, struct mp3_file *mp3) {
-  struct stat statinfo;
+/*
+  find_first_frame (internal):
 
-  unsigned char buffer[14];
-  int has_v1 = 0;
+  Finds the first valid frame header at or after the current position of
+  mp3->fh. The file is read in large blocks which are searched in memory.
 
-  mp3_debug ("mp3_open: Entering...\n");
+  Returns:
+    0 if a header was found (the file is positioned at the header)
+   -1 if no header was found
+   -2 if an MLLT frame was found first
+*/
+static int find_first_frame (struct mp3_file *mp3) {
+  u_int8_t *buffer;
+  long position;
+  int length, offset, ret = 1;
+  int header;
 
-  memset (mp3, 0 , sizeof (struct mp3_file));
+  mp3->skippage = 0;
 
-  if (stat (file_name, &statinfo) < 0)
-    return -errno;
+  buffer = (u_int8_t *) malloc (SCAN_BUFFER_SIZE);
+  if (buffer == NULL)
+    return -1;
 
-  mp3->file_size = mp3->data_size = statinfo.st_size;
-  mp3->mod_date  = statinfo.st_mtime;
+  position = ftell (mp3->fh);
 
-  mp3->fh = fopen (file_name, "r");
-  if (mp3->fh == NULL) 
-    return -errno;
+  while ((length = fread (buffer, 1, SCAN_BUFFER_SIZE, mp3->fh)) >= 4) {
+    offset = mp3_scan_block (buffer, length, &ret);
 
-  /* Adjust total_size if an id3v1 tag exists */
-  fseek (mp3->fh, -128, SEEK_END);
-  memset (buffer, 0, 5);
+    if (offset < 0) {
+      /* the last three bytes might start a header */
+      mp3->skippage += length - 3;
+      position      += length - 3;
 
-  fread (buffer, 1, 3, mp3->fh);
-  if (strncmp ((char *)buffer, "TAG", 3) == 0) {
-    mp3->data_size -= 128;
+      fseek (mp3->fh, position, SEEK_SET);
+      continue;
+    }
 
-    has_v1 = 1;
+    mp3->skippage += offset;
+    position      += offset;
 
-    mp3_debug ("mp3_open: Found id3v1 tag.\n");
-  }
-  /*                                          */
+    if (ret == 2) {
+      fseek (mp3->fh, position + 4, SEEK_SET);
+      free (buffer);
 
-  /* Check for Lyrics v2.00 */
-  fseek (mp3->fh, -9 - (has_v1 ? 128 : 0), SEEK_END);
-  memset (buffer, 0, 10);
-  fread (buffer, 1, 9, mp3->fh);
+      return -2;
+    }
+
+    /* make sure the header probe sees the whole first frame */
+    if (offset + XING_PROBE_SIZE > length && length == SCAN_BUFFER_SIZE) {
+      fseek (mp3->fh, position, SEEK_SET);
+      length = fread (buffer, 1, SCAN_BUFFER_SIZE, mp3->fh);
+      offset = 0;
+    }
 
-  if (strncmp ((char *)buffer, "LYRICS200", 9) == 0) {
-    int lyrics_size;
-    mp3_debug ("mp3_open: Found Lyrics v2.00\n");
+    header = mpeg_read_be32 (buffer, offset, length);
 
-    /* Get the size of the Lyrics */
-    fseek (mp3->fh, -15, SEEK_CUR);
-    memset (buffer, 0, 7);
-    fread (buffer, 1, 6, mp3->fh);
+    mp3_probe_vbr_headers (mp3, header, &buffer[offset], length - offset);
 
-    /* Include the size if LYRICS200 (9) and the size field (6) */
-    lyrics_size = strtol ((char *)buffer, NULL, 10) + 15;
-    mp3->data_size -= lyrics_size;
+    mp3->initial_header = header;
+    mp3->samplerate  = SAMPLERATE(header);
+    mp3->layer_index = MPEG_LAYER(header);
+    mp3->version_index = MPEG_VERSION(header);
 
-    mp3_debug ("mp3_open: Lyrics are 0x%x Bytes in length.\n", lyrics_size);
+    mp3_debug ("Inital bitrate = %i\n", BITRATE(header));
+
+    fseek (mp3->fh, position, SEEK_SET);
+    free (buffer);
+
+    return 0;
   }
 
+  free (buffer);
+
+  return -1;
+}
+
+static int mp3_open (struct media_file *media, struct mp3_file *mp3, int flags) {
+  unsigned char buffer[14];
+
+  mp3_debug ("mp3_open: Entering...\n");
+
+  memset (mp3, 0 , sizeof (struct mp3_file));
+
+  mp3->exact = (flags & FLAG_EXACT_DURATION) ? 1 : 0;
+
+  mp3->file_size = mp3->data_size = media->statinfo.st_size;
+  mp3->mod_date  = media->statinfo.st_mtime;
+
+  /* the file belongs to media */
+  mp3->fh = media->fh;
+
+  /* Adjust total_size if an id3v1 tag or Lyrics v2.00 exist */
+  if (id3_read_trailer (media, &mp3->trailer) == 0)
+    mp3->data_size -= mp3->trailer.size;
+
   /* find and skip id3v2 tag if it exists */
-  fseek (mp3->fh, 0, SEEK_SET);
-  fread (buffer, 1, 14, mp3->fh);    
+  memset (buffer, 0, 14);
+  media_read (media, 0, buffer, 14);
   mp3->tagv2_size = id3v2_size (buffer);
 
   fseek (mp3->fh, mp3->tagv2_size, SEEK_SET);
@@ -307,6 +437,142 @@ static int mp3_open (char *file_name, struct mp3_file *mp3) {
   return find_first_frame (mp3);
 }
 
+/*
+  mp3_count_frames (internal):
+
+  Exact mode: counts every frame from the current position to the end of the
+  audio data. The audio is mapped (or read with a single call) and the frame
+  headers are walked in memory.
+
+  Returns:
+   < 0 on error
+     0 on success (mp3->frames and mp3->xdata_size are set)
+*/
+static int mp3_count_frames (struct mp3_file *mp3) {
+  u_int8_t *data = NULL, *audio;
+  long start = ftell (mp3->fh);
+  int length, offset, next, ret, chained;
+  int header, frame_size, first_frame_size = 0;
+  int frames = 0, bitrate, last_bitrate = -1;
+  long long bytes = 0;
+  int mapped = 0;
+
+  if (start < 0 || start >= mp3->data_size)
+    return -1;
+
+  length = mp3->data_size - start;
+
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+  /* mappings must start on a page boundary so map from the start of the file */
+  data = mmap (NULL, mp3->data_size, PROT_READ, MAP_SHARED, fileno (mp3->fh), 0);
+
+  if (data == MAP_FAILED)
+    data = NULL;
+  else
+    mapped = 1;
+#endif
+
+  if (data != NULL)
+    audio = data + start;
+  else {
+    if ((data = (u_int8_t *) malloc (length)) == NULL)
+      return -errno;
+
+    if (fread (data, 1, length, mp3->fh) != (size_t)length) {
+      free (data);
+      fseek (mp3->fh, start, SEEK_SET);
+
+      return -1;
+    }
+
+    fseek (mp3->fh, start, SEEK_SET);
+    audio = data;
+  }
+
+  for (offset = 0, chained = 0 ; offset + 4 <= length ; ) {
+    header = mpeg_read_be32 (audio, offset, length);
+
+    if (check_mp3_header (header) != 0) {
+      next = mp3_scan_block (&audio[offset], length - offset, &ret);
+
+      /* junk (or an MLLT frame) at the end of the audio */
+      if (next < 0 || ret == 2)
+	break;
+
+      mp3_debug ("mp3_count_frames: skipped %i bytes at 0x%08x\n", next, start + offset);
+
+      offset += next;
+      chained = 0;
+      continue;
+    }
+
+    frame_size = mpeg_frame_length (header);
+
+    /* do not count a truncated last frame */
+    if (frame_size < 4 || offset + frame_size > length)
+      break;
+
+    /* a sync word in junk is only accepted if the next frame belongs to the same stream */
+    if (!chained && offset + frame_size + 4 <= length) {
+      next = mpeg_read_be32 (audio, offset + frame_size, length);
+
+      if (check_mp3_header (next) != 0 || (next & MPEG_STREAM_MASK) != (header & MPEG_STREAM_MASK)) {
+	offset++;
+	continue;
+      }
+    }
+
+    chained = 1;
+
+    if (frames == 0) {
+      first_frame_size = frame_size;
+
+      /* the approximate first frame may have been a false sync */
+      mp3->info_frame = mp3->encoder_delay = mp3->encoder_padding = 0;
+      mp3_probe_vbr_headers (mp3, header, &audio[offset], length - offset);
+
+      mp3->initial_header = header;
+      mp3->samplerate     = SAMPLERATE(header);
+      mp3->layer_index    = MPEG_LAYER(header);
+      mp3->version_index  = MPEG_VERSION(header);
+    } else {
+      bitrate = BITRATE(header);
+
+      if (last_bitrate != -1 && bitrate != last_bitrate)
+	mp3->vbr = 1;
+
+      last_bitrate = bitrate;
+    }
+
+    frames++;
+    bytes  += frame_size;
+    offset += frame_size;
+  }
+
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+  if (mapped)
+    munmap (data, mp3->data_size);
+  else
+#endif
+    free (data);
+
+  /* an Xing/Info/VBRI frame contains no audio */
+  if (mp3->info_frame && frames > 0) {
+    frames--;
+    bytes -= first_frame_size;
+  }
+
+  if (frames == 0)
+    return -1;
+
+  mp3->frames     = frames;
+  mp3->xdata_size = (int)bytes;
+
+  mp3_debug ("mp3_count_frames: %i frames, %lli bytes of audio\n", frames, bytes);
+
+  return 0;
+}
+
 static int mp3_scan (struct mp3_file *mp3) {
   int header;
   int ret;
@@ -319,6 +585,13 @@ static int mp3_scan (struct mp3_file *mp3) {
 
   mp3_debug ("mp3_scan: Entering...\n");
 
+  if (mp3->exact && mp3_count_frames (mp3) < 0)
+    mp3_debug ("mp3_scan: could not count frames. using the approximate scan.\n");
+
+  /* a VBR header with a frame count is enough. the data size is optional */
+  if (mp3->frames != 0 && mp3->xdata_size == 0)
+    mp3->xdata_size = mp3->data_size - ftell (mp3->fh);
+
   if (mp3->frames == 0 || mp3->xdata_size == 0) {
     /* This calculation will (from time to time) produce a duration that does not agree with the
        value produced by itunes. */
@@ -377,6 +650,10 @@ static int mp3_scan (struct mp3_file *mp3) {
 
   /* duration (ms) = frames * ms/sec * (samples/frame)/(samples/sec) */
   mp3->samples    = (long long)samples_per_frame[mp3->version_index][mp3->layer_index] * (long long)mp3->frames;
+
+  /* exclude the samples the encoder added at the start and end of the stream */
+  if (mp3->samples > mp3->encoder_delay + mp3->encoder_padding)
+    mp3->samples -= mp3->encoder_delay + mp3->encoder_padding;
   mp3->duration   = (int)(1000.0 * (double)mp3->samples/(double)mp3->samplerate);
   mp3->bitrate    = (int)(((float)mp3->xdata_size * 8.0)/(float)mp3->duration);
 
@@ -389,35 +666,36 @@ static int mp3_scan (struct mp3_file *mp3) {
   return 0;
 }
 
-void mp3_close (struct mp3_file *mp3) {
-  if (mp3->fh)
-    fclose (mp3->fh);
+static void mp3_to_tihm (struct mp3_file *mp3, tihm_t *tihm) {
+  tihm->bitrate = mp3->bitrate;
+  tihm->vbr     = mp3->vbr;
+  tihm->samplerate = mp3->samplerate;
+  tihm->time       = mp3->duration;
+  tihm->size       = mp3->file_size;
+  tihm->mod_date   = mp3->mod_date;
+  tihm->creation_date = mp3->mod_date;
+  tihm->type      = string_to_int ("MP3 ");
+  tihm->is_video  = 0;
 }
 
-int get_mp3_info (char *file_name, tihm_t *tihm) {
+int get_mp3_info (char *file_name, tihm_t *tihm, int flags) {
+  struct media_file media;
   struct mp3_file mp3;
+  int ret;
 
-  if (mp3_open (file_name, &mp3) < 0) {
-    mp3_close (&mp3); /* Make sure everything is cleaned up */
+  if (media_open (file_name, &media) < 0)
     return -1;
-  }
 
-  if (mp3_scan (&mp3) < 0) {
-    mp3_close (&mp3);
-    return -1;
-  }
+  ret = mp3_open (&media, &mp3, flags);
+  if (ret == 0)
+    ret = mp3_scan (&mp3);
 
-  mp3_close (&mp3);
+  media_close (&media);
 
-  tihm->bitrate = mp3.bitrate;
-  tihm->vbr     = mp3.vbr;
-  tihm->samplerate = mp3.samplerate;
-  tihm->time       = mp3.duration;
-  tihm->size       = mp3.file_size;
-  tihm->mod_date   = mp3.mod_date;
-  tihm->creation_date = mp3.mod_date;
-  tihm->type      = string_to_int ("MP3 ");
-  tihm->is_video  = 0;
+  if (ret < 0)
+    return -1;
+
+  mp3_to_tihm (&mp3, tihm);
 
   return 0;
 }
@@ -425,31 +703,25 @@ int get_mp3_info (char *file_name, tihm_t *tihm) {
 /*
   mp3_fill_tihm:
 
-  fills a tihm structure for adding a mp3 to the iTunesDB.
+  fills a tihm structure for adding a mp3 to the iTunesDB. The audio
+  information and the tags are read from the same open file.
 
   Returns:
    < 0 if any error occured
      0 if successful
 */
-int mp3_fill_tihm (char *file_name, tihm_t *tihm){
-  FILE *fh;
+int mp3_fill_tihm (struct media_file *media, tihm_t *tihm, int flags){
+  struct mp3_file mp3;
 
   char type_string[] = "MPEG audio file";
 
-  if (get_mp3_info(file_name, tihm) < 0) {
+  if (mp3_open (media, &mp3, flags) < 0 || mp3_scan (&mp3) < 0)
     return -1;
-  }
-
-  if ((fh = fopen(file_name,"r")) == NULL )
-    return errno;
 
-  if (get_id3_info(fh, file_name, tihm) < 0) {
-    fclose (fh);
+  mp3_to_tihm (&mp3, tihm);
 
+  if (id3_parse_tags (media, &mp3.trailer, tihm) < 0)
     return -1;
-  }
-
-  fclose (fh);
 
   dohm_add (tihm, type_string, strlen (type_string), "UTF-8", IPOD_TYPE);
 
@@ -25,45 +25,26 @@
 #include <time.h>
 
 struct mp4_file {
-  FILE *fh;
+  struct media_file *media;
 
-  int file_size;  /* Bytes */
+  /* offset of the first box after ftyp */
+  off_t position;
+
+  off_t file_size;  /* Bytes */
   int bitrate;    /* bps */
   int samplerate; /* samples/sec */
   int duration; /* ms */
   int mtime, ctime;
   int faac;
   int apple_lossless;
-  size_t meta_offset, meta_size;
-};
-
-struct qt_atom {
-  long size;
-  long type;
-};
+  int video; /* a track holds video (chapter images do not count) */
 
-struct qt_meta {
-  u_int32_t offset;
-
-  /* flag is sometimes the first character of the identifier */
-  u_int8_t  flag;
-  u_int8_t  identifier[3];
-
-  u_int32_t unk0;
-  u_int32_t datastr; /* "data" */
-
-  u_int16_t data[4];
-};
+  /* contents of the moov box (read with a single call) */
+  u_int8_t *moov;
+  size_t moov_size;
 
-/* media header */
-struct mdhd {
-  u_int32_t flags;
-  u_int32_t created;
-  u_int32_t modified;
-  u_int32_t time_scale;
-  u_int32_t duration;
-  u_int16_t language;
-  u_int16_t quality;
+  /* location of the ilst payload in moov */
+  size_t ilst_offset, ilst_size;
 };
 
 struct tag_map {
@@ -89,6 +70,12 @@ static int m4a_bitrates[] = {
 
 #define BITRATE(sample_size, num_samples, time_scale) ((sample_size * 8.0)/(double)(num_samples) * (double)time_scale/1000.0)/1000.0
 
+/* the moov box holds every table we parse. anything larger is not a music file */
+#define MP4_MAX_MOOV_SIZE (64 * 1024 * 1024)
+
+/* maximum nesting of container boxes */
+#define MP4_MAX_DEPTH 16
+
 #define is_media_header(type) (type == string_to_int ("mdhd"))
 /* this list (like this parser) is only as complete as it needs to be */
 #define is_container(type) (type == string_to_int ("trak") || \
@@ -97,23 +84,70 @@ static int m4a_bitrates[] = {
 			    type == string_to_int ("stbl") || \
 			    type == string_to_int ("minf") || \
 			    type == string_to_int ("dinf") || \
-			    type == string_to_int ("udta"))
+			    type == string_to_int ("udta") || \
+			    type == string_to_int ("meta"))
 
-#if defined(HAVE_LIBWAND)
-int read_artwork (FILE *fh, tihm_t *tihm, size_t image_size);
+#if defined(HAVE_ARTWORK)
+int copy_artwork (tihm_t *tihm, u_int8_t *image_data, size_t image_size);
 #endif
 
-static int parse_covr (FILE *fh, struct qt_meta meta, tihm_t *tihm) {
-#if defined(HAVE_LIBWAND)
+static u_int16_t mp4_read16 (u_int8_t *buffer) {
+  return (buffer[0] << 8) | buffer[1];
+}
+
+static u_int32_t mp4_read32 (u_int8_t *buffer) {
+  return ((u_int32_t)buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3];
+}
+
+static u_int64_t mp4_read64 (u_int8_t *buffer) {
+  return ((u_int64_t)mp4_read32 (buffer) << 32) | mp4_read32 (buffer + 4);
+}
+
+/*
+  mp4_box_header (internal):
+
+  Decodes the box header at the start of buffer. length is the number of
+  bytes in buffer and available is the number of bytes left in the parent
+  box (or file). A size of 1 means a 64-bit size follows the type and a size
+  of 0 means the box extends to the end of its parent.
+
+  Returns:
+   < 0 if the header is invalid
+     the length of the header (8 or 16) on success. *size includes the header.
+*/
+static int mp4_box_header (u_int8_t *buffer, u_int64_t length, u_int64_t available,
+			   u_int64_t *size, u_int32_t *type) {
+  int header_size = 8;
+
+  if (length < 8)
+    return -1;
+
+  *size = mp4_read32 (buffer);
+  *type = mp4_read32 (buffer + 4);
+
+  if (*size == 1) {
+    if (length < 16)
+      return -1;
+
+    *size = mp4_read64 (buffer + 8);
+    header_size = 16;
+  } else if (*size == 0)
+    *size = available;
+
+  if (*size < (u_int64_t)header_size || *size > available)
+    return -1;
+
+  return header_size;
+}
+
+static int parse_covr (tihm_t *tihm, u_int8_t *image_data, size_t image_size) {
+#if defined(HAVE_ARTWORK)
   if (tihm->image_data)
     return 0;
 
-  return read_artwork (fh, tihm, meta.offset - sizeof (struct qt_meta));
+  return copy_artwork (tihm, image_data, image_size);
 #else
-  mp3_debug ("Cover artwork found and ignored (libupod compiled without libwand).\n");
-
-  /* skip image data */
-  fseek (fh, meta.offset - sizeof (struct qt_meta), SEEK_CUR);
+  mp3_debug ("Cover artwork found and ignored (libupod compiled without artwork support).\n");
 
   return 0;
 #endif  
@@ -127,68 +161,60 @@ static int parse_covr (FILE *fh, struct qt_meta meta, tihm_t *tihm) {
   This function must be called after mp4_scan.
 */
 int mp4_parse_meta (struct mp4_file *mp4p, tihm_t *tihm) {
-  struct qt_meta meta;
-  struct qt_atom atom;
-  size_t ilist_size, next_offset;
-  int size, i, ret, data_type;
+  u_int8_t *ilst, *item, *data;
+  u_int64_t offset, size, item_size;
+  u_int32_t type, data_size;
+  int i, header_size, length, data_type;
   int buffer_size = 512;
-  unsigned char buffer[buffer_size];
+  unsigned char buffer[buffer_size + 1];
   char meta_tag[5];
   
-  if (mp4p->meta_offset == 0)
-    return -1;
-
-  fseek (mp4p->fh, mp4p->meta_offset + 4, SEEK_SET);
-
-  /* read and skip hdlr atom */
-  fread (&atom, sizeof (struct qt_atom), 1, mp4p->fh);
-  if (atom.type != string_to_int ("hdlr"))
-    return -1;
-
-  fseek (mp4p->fh, atom.size - sizeof(struct qt_atom), SEEK_CUR);
-
-  /* read and ilst atom */
-  fread (&atom, 8, 1, mp4p->fh);  
-  if (atom.type != string_to_int ("ilst"))
+  if (mp4p->moov == NULL || mp4p->ilst_size == 0)
     /* no ilst == no tags */
     return -1;
 
-  ilist_size  = atom.size;
-  
-  for (next_offset = 8 ; next_offset < ilist_size ; ) {
-    /* read meta tag */
-    ret = fread (&meta, sizeof(struct qt_meta), 1, mp4p->fh);
-    if (ret != 1)
+  ilst = mp4p->moov + mp4p->ilst_offset;
+
+  for (offset = 0 ; offset < mp4p->ilst_size ; offset += size) {
+    header_size = mp4_box_header (ilst + offset, mp4p->ilst_size - offset, mp4p->ilst_size - offset,
+				  &size, &type);
+    if (header_size < 0)
       break;
 
+    item      = ilst + offset + header_size;
+    item_size = size - header_size;
+
     memset (meta_tag, 0, 5);
-    if (meta.flag == 0xa9)
-      memcpy (meta_tag, meta.identifier, 3);
+    if ((type >> 24) == 0xa9)
+      for (i = 0 ; i < 3 ; i++)
+	meta_tag[i] = (type >> (16 - 8 * i)) & 0xff;
     else
-      memcpy (meta_tag, &meta.flag, 4);
+      for (i = 0 ; i < 4 ; i++)
+	meta_tag[i] = (type >> (24 - 8 * i)) & 0xff;
 
-    size = meta.offset - sizeof(struct qt_meta);
+    mp3_debug ("mp4.c/mp4_parse_meta: Meta {identifier, size} = {%-4s, 0x%08llx}\n", meta_tag, size);
+
+    /* the value is held in a data box: size, "data", type indicator, locale, value */
+    if (item_size < 16 || mp4_read32 (item + 4) != string_to_int ("data"))
+      continue;
 
-    next_offset += meta.offset;
+    data_size = mp4_read32 (item);
+    if (data_size < 16 || data_size > item_size)
+      continue;
 
-    mp3_debug ("mp4.c/mp4_parse_meta: Meta {identifier, offset} = {%-4s, 0x%08x}\n", meta_tag, meta.offset);
-    mp3_debug ("mp4.c/mp4_parse_meta: ilst offset = %d/%d\n", (next_offset - meta.offset), ilist_size);
+    data   = item + 16;
+    length = data_size - 16;
 
     if (strncmp (meta_tag, "covr", 4) == 0) {
-      parse_covr (mp4p->fh, meta, tihm);
+      parse_covr (tihm, data, length);
 
       continue;
-    } else if (size > buffer_size) {
+    } else if (length > buffer_size)
       /* it is unlikely that any data we want will be larger than the buffer */
-      fseek (mp4p->fh, size, SEEK_CUR);
-
       continue;
-    } else {
-      if (size != buffer_size)
-	buffer[size] = '\0';
 
-      fread (buffer, 1, size, mp4p->fh);
-    }
+    memcpy (buffer, data, length);
+    buffer[length] = '\0';
 
     /* look for a mapping from meta tag to ipod tag */
     for (i = 0, data_type = -1 ; tagmap[i].ipod_tag > -1 ; i++) 
@@ -203,29 +229,32 @@ int mp4_parse_meta (struct mp4_file *mp4p, tihm_t *tihm) {
     if (data_type != -1) {
       /* meta tag data should be stored in the track as a data object */
       if (strncmp (meta_tag, "gnre", 4) == 0) {
-	int genre_num = *((short *)buffer) - 1;
+	int genre_num;
+
+	if (length < 2 || (genre_num = mp4_read16 (buffer) - 1) < 0 || genre_num > 147)
+	  continue;
       
 	/* size includes the \0 */
-	size = strlen(genre_table[genre_num]) + 1;
+	length = strlen(genre_table[genre_num]) + 1;
 
-	strcpy (buffer, genre_table[genre_num]);
+	strcpy ((char *)buffer, genre_table[genre_num]);
       }
 
-      dohm_add(tihm, buffer, size, "UTF-8", data_type);
+      dohm_add(tihm, buffer, length, "UTF-8", data_type);
     } else {
       /* meta tag data should be stored in the track object */
-      if (strncmp (meta_tag, "trkn", 4) == 0) {
-	tihm->track        = big16_2_arch16( ((short *)buffer)[1] );
-	tihm->album_tracks = big16_2_arch16( ((short *)buffer)[2] );
-      } else if (strncmp (meta_tag, "disk", 4) == 0) {
-	tihm->disk_num   = big16_2_arch16( ((short *)buffer)[1] );
-	tihm->disk_total = big16_2_arch16( ((short *)buffer)[2] );
+      if (strncmp (meta_tag, "trkn", 4) == 0 && length >= 6) {
+	tihm->track        = mp4_read16 (buffer + 2);
+	tihm->album_tracks = mp4_read16 (buffer + 4);
+      } else if (strncmp (meta_tag, "disk", 4) == 0 && length >= 6) {
+	tihm->disk_num   = mp4_read16 (buffer + 2);
+	tihm->disk_total = mp4_read16 (buffer + 4);
       } else if (strncmp (meta_tag, "day", 3) == 0) {
 	struct tm release_date;
 	
 	memset (&release_date, 0, sizeof (struct tm));
 	
-	sscanf ((char *)buffer, "%04lu-%02lu-%02luT%02lu:%02lu:%02iZ", &release_date.tm_year,
+	sscanf ((char *)buffer, "%04d-%02d-%02dT%02d:%02d:%02dZ", &release_date.tm_year,
 		&release_date.tm_mon, &release_date.tm_mday, &release_date.tm_hour,
 		&release_date.tm_min, &release_date.tm_sec);
       
@@ -237,8 +266,8 @@ int mp4_parse_meta (struct mp4_file *mp4p, tihm_t *tihm) {
 	release_date.tm_zone = "UTC";
 
 	tihm->release_date = mktime (&release_date);
-      } else if (strncmp (meta_tag, "tmpo", 4) == 0)
-	tihm->bpm = big16_2_arch16 ( ((short *)buffer)[0] );
+      } else if (strncmp (meta_tag, "tmpo", 4) == 0 && length >= 2)
+	tihm->bpm = mp4_read16 (buffer);
     }    
   }
 
@@ -246,165 +275,275 @@ int mp4_parse_meta (struct mp4_file *mp4p, tihm_t *tihm) {
 }
 
 /* stsz atoms contain a table of sample sizes */
-static void mp4_parse_stsz (struct mp4_file *mp4p, unsigned int atom_size) {
-  int current_loc = ftell (mp4p->fh);
-  unsigned int buffer[3];
-  double avg = 0.0;
-  double bmax = 0.0;
-  double bmin = 10000.0;
+static void mp4_parse_stsz (struct mp4_file *mp4p, u_int8_t *payload, u_int64_t payload_size) {
+  u_int8_t *table;
+  u_int64_t total = 0;
+  u_int32_t bmax = 0;
+  u_int32_t bmin = 10000;
   int silent_samples = 0;
   int num_samples = 0;
-  unsigned int sample_size;
-
+  u_int32_t sample_size;
+  double avg, scale;
   int i;
 
   /* i am unsure how to handle multiple stsz atoms, so only use the first "valid" (size > 20) atom is parsed for data. */
-  if (mp4p->bitrate != 0 || atom_size < 0x14)
+  if (mp4p->bitrate != 0 || payload_size < 12)
     return;
 
   mp3_debug ("mp4.c/parse_stsz: entering...\n");
 
-  fread (buffer, 4, 3, mp4p->fh);
-
-  num_samples = big32_2_arch32 (buffer[2]);
+  sample_size = mp4_read32 (payload + 4);
+  num_samples = mp4_read32 (payload + 8);
+  table       = payload + 12;
 
   mp3_debug ("mp4.c/parse_stsz: Atom contains %i samples\n", num_samples);
 
-  for (i = 0 ; i < num_samples ; i++) {
-    fread (buffer, 4, 1, mp4p->fh);
+  if (num_samples <= 0)
+    return;
+
+  if (sample_size != 0) {
+    /* every sample has the same size. there is no table */
+    total = (u_int64_t)sample_size * num_samples;
+    bmin  = bmax = sample_size;
+  } else {
+    /* do not read past the end of the atom */
+    if ((u_int64_t)num_samples > (payload_size - 12) / 4)
+      num_samples = (payload_size - 12) / 4;
 
-    sample_size = big32_2_arch32 (buffer[0]);
+    /* no calls or early exits in here so the compiler can vectorize it */
+    for (i = 0 ; i < num_samples ; i++) {
+      u_int32_t size = mp4_read32 (table + 4 * i);
 
-    /* Silent samples are 7 bytes in size */
-    if (sample_size == 7)
-      silent_samples++;
-    else
-      avg += (double)sample_size;
+      /* Silent samples are 7 bytes in size */
+      silent_samples += (size == 7);
+      total += (size == 7) ? 0 : size;
 
-    bmax = fmax ((double)sample_size, bmax);
-    bmin = fmin ((double)sample_size, bmin);
+      bmax = (size > bmax) ? size : bmax;
+      bmin = (size < bmin) ? size : bmin;
+    }
   }
-  
+
+  if (num_samples == silent_samples) {
+    mp3_debug ("mp4.c/parse_stsz: no usable samples\n");
+    return;
+  }
+
+  avg = (double)total;
+  scale = 1.0;
+
   /* because they can throw off the bitrate calculation, silent samples are not used */
   mp4p->bitrate = (unsigned int)BITRATE(avg, num_samples-silent_samples, mp4p->samplerate);
   
   /* I have no idea why this works for apple lossless (or if it works in all cases) */
   if ((mp4p->bitrate - 32) > m4a_bitrates[14]) {
-    bmin *= 1000.0/4096.0;
-    avg  *= 1000.0/4096.0;
-    bmax *= 1000.0/4096.0;
+    scale = 1000.0/4096.0;
+    avg  *= scale;
 
     mp4p->apple_lossless = 1;
     mp4p->bitrate = (unsigned int)BITRATE(avg, num_samples-silent_samples, mp4p->samplerate);
   }
 
   avg /= (double)(num_samples-silent_samples);
-  
-  mp3_debug ("mp4.c/parse_stsz: Minimum bitrate is: %f kbps\n", BITRATE(bmin, 1, mp4p->samplerate));
-  mp3_debug ("mp4.c/parse_stsz: Agerage bitrate is: %f kbps\n", BITRATE(avg, 1, mp4p->samplerate));
-  mp3_debug ("mp4.c/parse_stsz: Maximum bitrate is: %f kbps\n", BITRATE(bmax, 1, mp4p->samplerate));
 
-  fseek (mp4p->fh, current_loc, SEEK_SET);
+  mp3_debug ("mp4.c/parse_stsz: Minimum bitrate is: %f kbps\n", BITRATE((double)bmin * scale, 1, mp4p->samplerate));
+  mp3_debug ("mp4.c/parse_stsz: Agerage bitrate is: %f kbps\n", BITRATE(avg, 1, mp4p->samplerate));
+  mp3_debug ("mp4.c/parse_stsz: Maximum bitrate is: %f kbps\n", BITRATE((double)bmax * scale, 1, mp4p->samplerate));
 
   mp3_debug ("mp4.c/parse_stsz: complete\n");
 }
 
 
 
-int mp4_open (char *file_name, struct mp4_file *mp4p) {
-  struct qt_atom atom;
-  struct stat statinfo;
-  char buffer[4];
+int mp4_open (struct media_file *media, struct mp4_file *mp4p) {
+  u_int8_t buffer[20];
+  u_int64_t size;
+  u_int32_t type;
+  int header_size;
 
   mp3_debug ("mp4.c/mp4_open: entering...\n");
 
   memset (mp4p, 0, sizeof(struct mp4_file));
 
-  if (stat(file_name, &statinfo) < 0)
-    return -errno;
-
-  mp4p->file_size = statinfo.st_size;
-  mp4p->mtime     = statinfo.st_mtime;
-  mp4p->ctime     = statinfo.st_ctime;
-
-  if ((mp4p->fh = fopen (file_name, "r")) == NULL)
-    return -errno;
+  mp4p->media     = media;
+  mp4p->file_size = media->statinfo.st_size;
+  mp4p->mtime     = media->statinfo.st_mtime;
+  mp4p->ctime     = media->statinfo.st_ctime;
 
   /* read and check identifier of the file type atom */
-  fread (&atom, sizeof(atom), 1, mp4p->fh);
-  if (atom.type != string_to_int ("ftyp")) {
+  header_size = mp4_box_header (buffer, media_read (media, 0, buffer, 20), mp4p->file_size, &size, &type);
+  if (header_size < 0 || header_size + 4 > 20 || type != string_to_int ("ftyp"))
     /* not a valid mpeg4 file */
-    fclose (mp4p->fh);
-
     return -1;
-  }
 
   /* read the file type */
-  fread (buffer, 1, 4, mp4p->fh);
-  if (strncmp (buffer, "mp42", 4) == 0)
+  if (memcmp (buffer + header_size, "mp42", 4) == 0)
     mp4p->faac = 1;
-  else if (0 && strncmp (buffer, "M4A ", 4) != 0 &&
-	   strncmp (buffer, "M4V ", 4) != 0) {
-    fclose (mp4p->fh);
-
+  else if (0 && memcmp (buffer + header_size, "M4A ", 4) != 0 &&
+	   memcmp (buffer + header_size, "M4V ", 4) != 0)
     return -1;
-  }
 
-  fseek (mp4p->fh, atom.size - sizeof(atom) - 4, SEEK_CUR);
+  mp4p->position = size;
 
   mp3_debug ("mp4.c/mp4_open: complete\n");
 
   return 0;
 }
 
-static int mp4_parse_mdhd (struct mp4_file *mp4) {
-  struct mdhd mdhd;
+static void mp4_parse_mdhd (struct mp4_file *mp4, u_int8_t *payload, u_int64_t payload_size) {
+  u_int32_t time_scale;
+  u_int64_t duration;
 
   /* MPEG-4 files can contain multiple media headers. Only the first media header with a valid time_scale is used. */
   if (mp4->samplerate != 0)
-    return 0;
+    return;
+
+  /* version 1 headers use 64-bit times */
+  if (payload_size >= 32 && payload[0] == 1) {
+    time_scale = mp4_read32 (payload + 20);
+    duration   = mp4_read64 (payload + 24);
+  } else if (payload_size >= 20 && payload[0] == 0) {
+    time_scale = mp4_read32 (payload + 12);
+    duration   = mp4_read32 (payload + 16);
+  } else
+    return;
 
-  fread (&mdhd, sizeof (struct mdhd), 1, mp4->fh);
-  fseek (mp4->fh, -sizeof (struct mdhd), SEEK_CUR);
+  if (time_scale == 0)
+    return;
 
-  mp4->samplerate = mdhd.time_scale;
-  mp4->duration   = lround (1000.0 * (double)mdhd.duration/(double)mp4->samplerate);
+  mp4->samplerate = time_scale;
+  mp4->duration   = lround (1000.0 * (double)duration/(double)mp4->samplerate);
 
   mp3_debug ("mp4.c/mp4_scan: sample rate = %i, length = %i ms.\n", mp4->samplerate, mp4->duration);
+}
 
-  return 0;
+/*
+  mp4_video_sample (internal):
+
+  Returns 1 if the first sample description in an stsd box is a video
+  format. Enhanced podcasts and audiobooks carry their chapter artwork in a
+  track with a video handler and jpeg or png samples; those are not video.
+*/
+static int mp4_video_sample (u_int8_t *payload, u_int64_t payload_size) {
+  u_int32_t format;
+
+  /* version and flags, entry count, then the size and format of the first entry */
+  if (payload_size < 16 || mp4_read32 (payload + 4) == 0)
+    return 1;
+
+  format = mp4_read32 (payload + 12);
+
+  return !(format == string_to_int ("jpeg") || format == string_to_int ("png "));
+}
+
+/*
+  mp4_parse_moov (internal):
+
+  Walks the boxes in the in-memory moov box. Containers are entered without
+  recursion by keeping the end offset of every open container on a stack.
+*/
+static void mp4_parse_moov (struct mp4_file *mp4) {
+  u_int64_t stack[MP4_MAX_DEPTH];
+  u_int64_t offset = 0, end, size;
+  u_int32_t type;
+  int depth = 0, header_size;
+  int video_handler = 0; /* the current trak has a video handler */
+
+  stack[depth++] = mp4->moov_size;
+
+  while (depth > 0) {
+    end = stack[depth - 1];
+
+    header_size = mp4_box_header (mp4->moov + offset, end - offset, end - offset, &size, &type);
+    if (header_size < 0) {
+      /* end of the container (or a damaged box). continue with the parent */
+      offset = end;
+      depth--;
+
+      continue;
+    }
+
+    if (is_container (type) && depth < MP4_MAX_DEPTH) {
+      if (type == string_to_int ("trak"))
+	video_handler = 0;
+
+      stack[depth++] = offset + size;
+      offset += header_size;
+
+      /* meta is a full box. its children follow the version and flags */
+      if (type == string_to_int ("meta"))
+	offset = (offset + 4 > stack[depth - 1]) ? stack[depth - 1] : offset + 4;
+
+      continue;
+    }
+
+    if (type == string_to_int ("mdhd"))
+      mp4_parse_mdhd (mp4, mp4->moov + offset + header_size, size - header_size);
+    else if (type == string_to_int ("stsz"))
+      mp4_parse_stsz (mp4, mp4->moov + offset + header_size, size - header_size);
+    else if (type == string_to_int ("hdlr") && size - header_size >= 12 &&
+	     mp4_read32 (mp4->moov + offset + header_size + 8) == string_to_int ("vide"))
+      video_handler = 1;
+    else if (type == string_to_int ("stsd") && video_handler &&
+	     mp4_video_sample (mp4->moov + offset + header_size, size - header_size))
+      mp4->video = 1;
+    else if (type == string_to_int ("ilst") && mp4->ilst_size == 0) {
+      mp4->ilst_offset = offset + header_size;
+      mp4->ilst_size   = size - header_size;
+    }
+
+    offset += size;
+  }
 }
 
 int mp4_scan (struct mp4_file *mp4) {
-  struct qt_atom atom;
-  int i;
+  u_int8_t buffer[16];
+  u_int64_t size = 0;
+  u_int32_t type;
+  off_t position;
+  int i, header_size = -1;
 
-  if (mp4 == NULL || mp4->fh == NULL)
+  if (mp4 == NULL || mp4->media == NULL)
     return -EINVAL;
 
-  while (1) {
-    if (fread (&atom, sizeof(atom), 1, mp4->fh) != 1) {
+  /* find the moov box. it can be before or after the media data (mdat) */
+  for (position = mp4->position ; position < mp4->file_size ; position += size) {
+    header_size = mp4_box_header (buffer, media_read (mp4->media, position, buffer, 16),
+				  mp4->file_size - position, &size, &type);
+    if (header_size < 0) {
       mp3_debug ("mp4.c/mp4_scan: error reading atom header.\n");
       break;
     }
 
-    /* stop parsing on media data atom (audio data follows) */
-    if (atom.type == string_to_int ("mdat") || atom.size == 0)
+    if (type == string_to_int ("moov"))
       break;
+  }
 
-    if (!is_container(atom.type)) {
-      if (atom.type == string_to_int ("meta")) {
-        mp4->meta_offset = ftell (mp4->fh);
-	mp4->meta_size   = atom.size - sizeof(atom);
-      } if (atom.type == string_to_int ("mdhd"))
-	mp4_parse_mdhd (mp4);
-      else if (atom.type == string_to_int ("stsz"))
-	mp4_parse_stsz (mp4, atom.size);
-      
-      fseek (mp4->fh, atom.size - sizeof(atom), SEEK_CUR);
-    }
+  if (header_size < 0 || position >= mp4->file_size) {
+    mp3_debug ("mp4.c/mp4_scan: no moov atom found.\n");
+    return -1;
+  }
+
+  if (size - header_size > MP4_MAX_MOOV_SIZE) {
+    mp3_debug ("mp4.c/mp4_scan: moov atom is too large (%llu bytes).\n", size);
+    return -1;
   }
 
+  mp4->moov_size = size - header_size;
+  mp4->moov      = (u_int8_t *) malloc (mp4->moov_size);
+  if (mp4->moov == NULL)
+    return -errno;
+
+  if (media_read (mp4->media, position + header_size, mp4->moov, mp4->moov_size) != mp4->moov_size) {
+    mp3_debug ("mp4.c/mp4_scan: error reading moov atom.\n");
+
+    free (mp4->moov);
+    mp4->moov = NULL;
+
+    return -1;
+  }
+
+  mp4_parse_moov (mp4);
+
   if (!mp4->faac && !mp4->apple_lossless) {
     /* find closest match in the m4a bitrate table. only needed for
        itunes/quicktime encoded aac files (not losseless) */
@@ -426,26 +565,29 @@ int mp4_scan (struct mp4_file *mp4) {
 }
 
 void mp4_close (struct mp4_file *mp4) {
-  if (mp4 && mp4->fh) {
-    fclose (mp4->fh);
-    mp4->fh = NULL;
+  if (mp4 && mp4->moov) {
+    free (mp4->moov);
+    mp4->moov = NULL;
   }
 }
 
-int mp4_fill_tihm (char *file_name, tihm_t *tihm) {
+int mp4_fill_tihm (struct media_file *media, tihm_t *tihm) {
   char mp4_type_string[]      = "AAC audio file";
   char m4v_type_string[]      = "MPEG-4 video file";
   char lossless_type_string[] = "Apple Lossless audio file";
 
-  int i, ret;
+  char *file_name;
+  int ret;
   struct mp4_file mp4;
 
-  if (file_name == NULL || tihm == NULL)
+  if (media == NULL || tihm == NULL)
     return -EINVAL;
 
+  file_name = media->path;
+
   memset (tihm, 0, sizeof (tihm_t));
 
-  ret = mp4_open (file_name, &mp4);
+  ret = mp4_open (media, &mp4);
   if (ret != 0)
     return ret;
 
@@ -461,7 +603,8 @@ int mp4_fill_tihm (char *file_name, tihm_t *tihm) {
   tihm->mod_date      = mp4.mtime;
   tihm->creation_date = mp4.ctime;
 
-  if (strncasecmp (file_name + (strlen(file_name) - 3), "m4v", 3) != 0) {
+  /* files with a video track (or a m4v extension) are videos */
+  if (!mp4.video && strncasecmp (file_name + (strlen(file_name) - 3), "m4v", 3) != 0) {
     tihm->type     = string_to_int ("M4A ");
     tihm->is_video = 0;
     
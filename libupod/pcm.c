@@ -0,0 +1,175 @@
+/**
+ *   (c) 2007 Nathan Hjelm <hjelmn@users.sourceforge.net>
+ *   v0.1.0 pcm.c
+ *
+ *   Parses uncompressed (WAV and AIFF) audio files
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the Lesser GNU Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the Lesser GNU Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ **/
+
+#include "itunesdbi.h"
+
+#include <math.h>
+
+struct pcm_file {
+  int samplerate; /* samples/sec */
+  int channels;
+  int bits;       /* bits/sample */
+
+  u_int64_t frames;
+};
+
+static u_int32_t pcm_read32 (u_int8_t *buffer, int big_endian) {
+  if (big_endian)
+    return ((u_int32_t)buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3];
+
+  return ((u_int32_t)buffer[3] << 24) | (buffer[2] << 16) | (buffer[1] << 8) | buffer[0];
+}
+
+static u_int16_t pcm_read16 (u_int8_t *buffer, int big_endian) {
+  return big_endian ? ((buffer[0] << 8) | buffer[1]) : ((buffer[1] << 8) | buffer[0]);
+}
+
+/* AIFF stores the sample rate as an 80-bit IEEE extended float */
+static int pcm_read_extended (u_int8_t *buffer) {
+  int exponent = ((buffer[0] & 0x7f) << 8) | buffer[1];
+  u_int64_t mantissa = ((u_int64_t)pcm_read32 (buffer + 2, 1) << 32) | pcm_read32 (buffer + 6, 1);
+
+  if (exponent == 0 || exponent == 0x7fff)
+    return 0;
+
+  return (int)ldexp ((double)mantissa, exponent - 16383 - 63);
+}
+
+/*
+  pcm_parse_chunks (internal):
+
+  Walks the chunks of a RIFF/WAVE or FORM/AIFF file looking for the format
+  and the size of the sample data. The chunk headers are almost always in
+  media->head so this does not touch the file.
+*/
+static int pcm_parse_chunks (struct media_file *media, struct pcm_file *pcm, int aiff) {
+  u_int8_t chunk[26];
+  u_int32_t chunk_size, data_size = 0;
+  u_int64_t offset, end, step;
+  int byte_rate = 0, have_format = 0;
+
+  /* the container size does not include the id and size fields */
+  end = (u_int64_t)pcm_read32 (media->head + 4, aiff) + 8;
+  if (end > (u_int64_t)media->statinfo.st_size)
+    end = media->statinfo.st_size;
+
+  for (offset = 12 ; offset + 8 <= end ; offset += step) {
+    memset (chunk, 0, sizeof (chunk));
+
+    if (media_read (media, offset, chunk, (end - offset < 26) ? end - offset : 26) < 8)
+      break;
+
+    chunk_size = pcm_read32 (chunk + 4, aiff);
+
+    /* in 64 bits so a huge chunk size can not wrap the step to 0 */
+    step = 8 + (u_int64_t)chunk_size + (chunk_size & 1);
+
+    if (!aiff && memcmp (chunk, "fmt ", 4) == 0 && chunk_size >= 16) {
+      /* only uncompressed (PCM) wave files can be played */
+      if (pcm_read16 (chunk + 8, 0) != 1 && pcm_read16 (chunk + 8, 0) != 0xfffe)
+	return -1;
+
+      pcm->channels   = pcm_read16 (chunk + 10, 0);
+      pcm->samplerate = pcm_read32 (chunk + 12, 0);
+      byte_rate       = pcm_read32 (chunk + 16, 0);
+      pcm->bits       = pcm_read16 (chunk + 22, 0);
+
+      have_format = 1;
+    } else if (!aiff && memcmp (chunk, "data", 4) == 0) {
+      /* the data chunk may be truncated */
+      data_size = (offset + 8 + chunk_size > end) ? end - offset - 8 : chunk_size;
+    } else if (aiff && memcmp (chunk, "COMM", 4) == 0 && chunk_size >= 18) {
+      pcm->channels   = pcm_read16 (chunk + 8, 1);
+      pcm->frames     = pcm_read32 (chunk + 10, 1);
+      pcm->bits       = pcm_read16 (chunk + 14, 1);
+      pcm->samplerate = pcm_read_extended (chunk + 16);
+
+      have_format = 1;
+    }
+  }
+
+  if (!have_format || pcm->samplerate <= 0)
+    return -1;
+
+  if (!aiff) {
+    if (byte_rate <= 0)
+      byte_rate = pcm->samplerate * pcm->channels * pcm->bits / 8;
+
+    if (byte_rate <= 0)
+      return -1;
+
+    pcm->frames = (u_int64_t)data_size * pcm->samplerate / byte_rate;
+  }
+
+  return 0;
+}
+
+/*
+  pcm_fill_tihm:
+
+  fills a tihm structure for adding a WAV or AIFF file to the iTunesDB.
+
+  Returns:
+   < 0 if any error occured
+     0 if successful
+*/
+int pcm_fill_tihm (struct media_file *media, tihm_t *tihm) {
+  char wav_type_string[]  = "WAV audio file";
+  char aiff_type_string[] = "AIFF audio file";
+  struct pcm_file pcm;
+  int aiff;
+
+  if (media == NULL || tihm == NULL || media->head_length < 12)
+    return -EINVAL;
+
+  memset (&pcm, 0, sizeof (struct pcm_file));
+
+  aiff = (media->type == MEDIA_AIFF);
+
+  if (pcm_parse_chunks (media, &pcm, aiff) < 0) {
+    mp3_debug ("pcm.c/pcm_fill_tihm: could not find the audio format in %s\n", media->path);
+    return -1;
+  }
+
+  mp3_debug ("pcm.c/pcm_fill_tihm: %i Hz, %i channels, %i bits, %llu frames\n", pcm.samplerate,
+	     pcm.channels, pcm.bits, pcm.frames);
+
+  tihm->samplerate    = pcm.samplerate;
+  tihm->bitrate       = pcm.samplerate * pcm.channels * pcm.bits / 1000;
+  tihm->time          = (u_int32_t)(pcm.frames * 1000 / pcm.samplerate);
+  tihm->size          = media->statinfo.st_size;
+  tihm->mod_date      = media->statinfo.st_mtime;
+  tihm->creation_date = media->statinfo.st_ctime;
+  tihm->is_video      = 0;
+
+  if (aiff) {
+    tihm->type = string_to_int ("AIFF");
+    dohm_add (tihm, (u_int8_t *)aiff_type_string, strlen (aiff_type_string), "UTF-8", IPOD_TYPE);
+  } else {
+    tihm->type = string_to_int ("WAV ");
+    dohm_add (tihm, (u_int8_t *)wav_type_string, strlen (wav_type_string), "UTF-8", IPOD_TYPE);
+  }
+
+  if (tihm->time == 0 || tihm->bitrate == 0)
+    return -1;
+
+  return 0;
+}
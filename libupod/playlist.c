@@ -102,35 +102,40 @@ int db_playlist_number (ipoddb_t *itunesdb, int data_section) {
 }
 
 /**
-  db_playlists_list:
+  db_playlist_list_array:
 
-  Returns a linked list containing the numbers and names of the playlists in
-  the itunesdb.
+  Fills an array with the numbers and names of the playlists in the
+  itunesdb. Each entry is a struct pyhm.
 
   Arguments:
-   ipoddb_t *itunesdb - opened itunesdb
+   ipoddb_t   *itunesdb     - opened itunesdb
+   db_array_t *playlists    - array to fill (initialized by this function)
+   int         data_section - playlist data section (2 or 3)
 
   Returns:
-   NULL on error
-   pointer to head of linked list on success
+   < 0 on error
+     0 on success
 **/
-int db_playlist_list (ipoddb_t *itunesdb, db_list_t **head, int data_section) {
+int db_playlist_list_array (ipoddb_t *itunesdb, db_array_t *playlists, int data_section) {
   db_plhm_t *plhm_data;
   char *temp;
 
   int i, ret;
 
-  if (head == NULL)
+  if (playlists == NULL)
     return -EINVAL;
-  else
-    *head = NULL;
+
+  db_array_init (playlists, 0);
 
   db_log (itunesdb, 0, "db_playlist_list: entering...\n");
 
   if ((ret = db_playlist_retrieve (itunesdb, &plhm_data, NULL, 0, data_section, NULL)) < 0)
     return ret;
 
-  for ( i = plhm_data->list_entries - 1 ; i >= 0 ; i--) {
+  if ((ret = db_array_init (playlists, plhm_data->list_entries)) < 0)
+    return ret;
+
+  for ( i = 0 ; i < plhm_data->list_entries ; i++) {
     struct pyhm *pyhm;
 
     if ((ret = db_playlist_get_name (itunesdb, i, data_section, &temp)) < 0)
@@ -141,7 +146,7 @@ int db_playlist_list (ipoddb_t *itunesdb, db_list_t **head, int data_section) {
     pyhm->name = temp;
     pyhm->name_len = strlen ((char *)temp);
 
-    *head = db_list_prepend (*head, pyhm);
+    db_array_append (playlists, pyhm);
   }
 
   db_log (itunesdb, 0, "db_playlist_list: complete\n");
@@ -149,6 +154,64 @@ int db_playlist_list (ipoddb_t *itunesdb, db_list_t **head, int data_section) {
   return 0;
 }
 
+/**
+  db_playlist_list_array_free:
+
+  Frees the playlists in an array filled by db_playlist_list_array and the
+  array itself.
+**/
+void db_playlist_list_array_free (db_array_t *playlists) {
+  int i;
+
+  if (playlists == NULL)
+    return;
+
+  for (i = 0 ; i < playlists->num_entries ; i++) {
+    struct pyhm *pyhm = (struct pyhm *)db_array_index (playlists, i);
+
+    free (pyhm->name);
+    free (pyhm);
+  }
+
+  db_array_free (playlists);
+}
+
+/**
+  db_playlists_list:
+
+  Returns a linked list containing the numbers and names of the playlists in
+  the itunesdb. New code should use db_playlist_list_array.
+
+  Arguments:
+   ipoddb_t *itunesdb - opened itunesdb
+
+  Returns:
+   < 0 on error
+     0 on success
+**/
+int db_playlist_list (ipoddb_t *itunesdb, db_list_t **head, int data_section) {
+  db_array_t playlists;
+  int ret;
+
+  if (head == NULL)
+    return -EINVAL;
+
+  *head = NULL;
+
+  if ((ret = db_playlist_list_array (itunesdb, &playlists, data_section)) < 0)
+    return ret;
+
+  if ((*head = db_list_from_array (&playlists)) == NULL && playlists.num_entries) {
+    db_playlist_list_array_free (&playlists);
+
+    return -ENOMEM;
+  }
+
+  db_array_free (&playlists);
+
+  return 0;
+}
+
 /**
   db_playlist_list_free:
 
@@ -200,22 +263,59 @@ int db_playlist_video_list (ipoddb_t *itunesdb, int playlist, db_list_t **head)
 }
 
 int db_playlist_track_list (ipoddb_t *itunesdb, int playlist, db_list_t **head, int data_section) {
+  db_array_t tracks;
+  int ret;
+
+  if (head == NULL)
+    return -EINVAL;
+
+  *head = NULL;
+
+  if ((ret = db_playlist_track_list_array (itunesdb, playlist, &tracks, data_section)) < 0)
+    return ret;
+
+  if ((*head = db_list_from_array (&tracks)) == NULL && tracks.num_entries) {
+    db_array_free (&tracks);
+
+    return -ENOMEM;
+  }
+
+  db_array_free (&tracks);
+
+  return ret;
+}
+
+/**
+  db_playlist_track_list_array:
+
+  Fills an array with the references (track ids) contained in a playlist. The
+  entries are stored directly in the array's pointers.
+
+  Argument:
+   ipoddb_t   *itunesdb     - opened itunesdb
+   int         playlist     - playlist index (0 is master)
+   db_array_t *tracks       - array to fill (initialized by this function)
+   int         data_section - playlist data section (2 or 3)
+
+  Returns:
+   < 0 on error
+   >=0 number of references in the array
+**/
+int db_playlist_track_list_array (ipoddb_t *itunesdb, int playlist, db_array_t *tracks, int data_section) {
   tree_node_t *pyhm_header;
 
   struct db_pyhm *pyhm_data;
   struct db_pihm *pihm_data;
 
   int i;
-  int num_entries = 0;
-
   int ret;
 
-  if (head == NULL)
+  if (tracks == NULL)
     return -EINVAL;
 
   db_log (itunesdb, 0, "db_playlist_song_list: entering...\n");
 
-  *head = NULL;
+  db_array_init (tracks, 0);
 
   if ((ret = db_playlist_retrieve (itunesdb, NULL, NULL, playlist, data_section, &pyhm_header)) < 0) {
     db_log (itunesdb, ret, "Could not retrive playlist header.\n");
@@ -225,21 +325,22 @@ int db_playlist_track_list (ipoddb_t *itunesdb, int playlist, db_list_t **head,
   pyhm_data = (struct db_pyhm *) pyhm_header->data;
 
   if (pyhm_data->num_pihm > 0) {
-    num_entries = (pyhm_header->num_children - 2)/2;
-    
-    for (i = pyhm_header->num_children - 1 ; i >= pyhm_data->num_dohm ; i--) {
+    if ((ret = db_array_init (tracks, pyhm_data->num_pihm)) < 0)
+      return ret;
+
+    for (i = pyhm_data->num_dohm ; i < pyhm_header->num_children ; i++) {
       pihm_data = (struct db_pihm *)pyhm_header->children[i]->data;
 
       if (pihm_data->pihm != PIHM)
 	continue;
 
-      (*head) = db_list_prepend (*head, (void *)pihm_data->reference);
+      db_array_append (tracks, (void *)(long)pihm_data->reference);
     }
   }
 
   db_log (itunesdb, 0, "db_playlist_song_list: complete\n");
 
-  return num_entries;
+  return tracks->num_entries;
 }
 
 void db_playlist_song_list_free (db_list_t **head) {
@@ -429,6 +530,218 @@ int db_playlist_delete (ipoddb_t *itunesdb, int playlist, int data_section) {
   return 0;
 }
 
+static int u32_compare (const void *a, const void *b) {
+  u_int32_t x = *(const u_int32_t *)a;
+  u_int32_t y = *(const u_int32_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+/* tihm number and its position in the caller's array (ties sort by position) */
+struct tihm_ref {
+  u_int32_t tihm_num;
+  int position;
+};
+
+static int tihm_ref_compare (const void *a, const void *b) {
+  const struct tihm_ref *x = (const struct tihm_ref *)a;
+  const struct tihm_ref *y = (const struct tihm_ref *)b;
+
+  if (x->tihm_num != y->tihm_num)
+    return (x->tihm_num > y->tihm_num) ? 1 : -1;
+
+  return x->position - y->position;
+}
+
+/*
+  db_playlist_tihm_append:
+
+  Internal function that appends references to num_tihms songs to the playlist
+  pyhm_header. Songs that are already referenced by the playlist (or appear
+  more than once in tihm_nums) are only added once. All the new pihm entries
+  are attached with a single growth of the playlist. The caller is responsible
+  for making sure the songs exist.
+
+  Returns:
+   < 0 on error
+   >= 0 number of references added
+*/
+int db_playlist_tihm_append (ipoddb_t *itunesdb, tree_node_t *pyhm_header, u_int32_t tihm_nums[],
+			     int num_tihms) {
+  struct db_pyhm *pyhm_data;
+  struct tihm_ref *refs = NULL;
+  u_int32_t *members = NULL;
+  char *skip = NULL;
+  tree_node_t **new_pihms = NULL;
+  int num_members = 0, num_new = 0;
+  int i, order, ret = 0;
+
+  if (itunesdb == NULL || pyhm_header == NULL || num_tihms < 0 || (num_tihms && tihm_nums == NULL))
+    return -EINVAL;
+
+  if (num_tihms == 0)
+    return 0;
+
+  pyhm_data = (struct db_pyhm *)pyhm_header->data;
+
+  members   = (u_int32_t *) calloc (pyhm_header->num_children + 1, sizeof (u_int32_t));
+  refs      = (struct tihm_ref *) calloc (num_tihms, sizeof (struct tihm_ref));
+  skip      = (char *) calloc (num_tihms, 1);
+  new_pihms = (tree_node_t **) calloc (num_tihms, sizeof (tree_node_t *));
+  if (members == NULL || refs == NULL || skip == NULL || new_pihms == NULL) {
+    ret = -errno;
+    goto cleanup;
+  }
+
+  /* 100000 after the last song entry should be a safe number to start at */
+  order = itunesdb->last_entry + 100000;
+
+  for (i = pyhm_data->num_dohm ; i < pyhm_header->num_children ; i++) {
+    struct db_pihm *pihm_data = (struct db_pihm *)pyhm_header->children[i]->data;
+
+    if (pihm_data->pihm != PIHM)
+      continue;
+
+    members[num_members++] = pihm_data->reference;
+    order = pihm_data->order + 1;
+  }
+
+  qsort (members, num_members, sizeof (u_int32_t), u32_compare);
+
+  /* find references that already exist or are repeated */
+  for (i = 0 ; i < num_tihms ; i++) {
+    refs[i].tihm_num = tihm_nums[i];
+    refs[i].position = i;
+  }
+
+  qsort (refs, num_tihms, sizeof (struct tihm_ref), tihm_ref_compare);
+
+  for (i = 0 ; i < num_tihms ; i++)
+    if ((i && refs[i].tihm_num == refs[i - 1].tihm_num) ||
+	bsearch (&refs[i].tihm_num, members, num_members, sizeof (u_int32_t), u32_compare))
+      skip[refs[i].position] = 1;
+
+  for (i = 0 ; i < num_tihms ; i++) {
+    if (skip[i])
+      continue;
+
+    if ((ret = db_pihm_create (&new_pihms[num_new], tihm_nums[i], order++, 0)) < 0)
+      goto cleanup;
+
+    num_new++;
+  }
+
+  if ((ret = db_attach_many (pyhm_header, new_pihms, num_new)) < 0)
+    goto cleanup;
+
+  pyhm_data->num_pihm += num_new;
+  ret = num_new;
+  num_new = 0;
+
+ cleanup:
+  for (i = 0 ; i < num_new ; i++)
+    db_free_tree (new_pihms[i]);
+
+  if (members)
+    free (members);
+  if (refs)
+    free (refs);
+  if (skip)
+    free (skip);
+  if (new_pihms)
+    free (new_pihms);
+
+  return ret;
+}
+
+
+/*
+  db_playlist_track_ids:
+
+  Internal function that stores a sorted array of the identifiers of every
+  track in the database in tihm_nums.
+*/
+static int db_playlist_track_ids (ipoddb_t *itunesdb, u_int32_t **tihm_nums, int *num_tihms) {
+  tree_node_t *dshm_header;
+  int i, ret;
+
+  if ((ret = db_dshm_retrieve (itunesdb, &dshm_header, 1)) < 0)
+    return ret;
+
+  *num_tihms = dshm_header->num_children - 1;
+  *tihm_nums = (u_int32_t *) calloc (*num_tihms + 1, sizeof (u_int32_t));
+  if (*tihm_nums == NULL)
+    return -errno;
+
+  for (i = 1 ; i < dshm_header->num_children ; i++)
+    (*tihm_nums)[i - 1] = ((struct db_tihm *)dshm_header->children[i]->data)->identifier;
+
+  qsort (*tihm_nums, *num_tihms, sizeof (u_int32_t), u32_compare);
+
+  return 0;
+}
+
+/**
+  db_playlist_tihm_add_many:
+
+    Adds references to songs to a playlist. References that already exist
+  in the playlist and songs that are not in the database are skipped.
+
+  Arguments:
+   ipoddb_t *itunesdb     - Opened itunesdb
+   int       playlist     - Playlist index (0 is the master playlist)
+   int       data_section - typically 2 for music or 3 for video
+   int       tihm_nums[]  - Song references to add
+   int       num_tihms    - Number of references
+
+  Returns:
+   < 0 on error
+   >=0 number of references added
+**/
+int db_playlist_tihm_add_many (ipoddb_t *itunesdb, int playlist, int data_section, int tihm_nums[],
+			       int num_tihms) {
+  tree_node_t *pyhm_header;
+  u_int32_t *tracks, *valid;
+  int num_tracks, num_valid = 0;
+  int i, ret;
+
+  if (itunesdb == NULL || num_tihms < 0 || (num_tihms && tihm_nums == NULL))
+    return -EINVAL;
+
+  db_log (itunesdb, 0, "db_playlist_tihm_add_many: entering...\n");
+
+  if ((ret = db_playlist_retrieve (itunesdb, NULL, NULL, playlist, data_section, &pyhm_header)) < 0)
+    return ret;
+
+  /* make sure the tihms exist in the database before continuing */
+  if ((ret = db_playlist_track_ids (itunesdb, &tracks, &num_tracks)) < 0)
+    return ret;
+
+  valid = (u_int32_t *) calloc (num_tihms + 1, sizeof (u_int32_t));
+  if (valid == NULL) {
+    free (tracks);
+    return -errno;
+  }
+
+  for (i = 0 ; i < num_tihms ; i++) {
+    u_int32_t tihm_num = (u_int32_t) tihm_nums[i];
+
+    if (bsearch (&tihm_num, tracks, num_tracks, sizeof (u_int32_t), u32_compare))
+      valid[num_valid++] = tihm_num;
+    else
+      db_log (itunesdb, 0, "db_playlist_tihm_add_many: no song with id %i\n", tihm_nums[i]);
+  }
+
+  ret = db_playlist_tihm_append (itunesdb, pyhm_header, valid, num_valid);
+
+  free (tracks);
+  free (valid);
+
+  db_log (itunesdb, 0, "db_playlist_tihm_add_many: complete\n");
+
+  return ret;
+}
+
 /**
   db_playlist_tihm_add:
 
@@ -446,93 +759,160 @@ int db_playlist_delete (ipoddb_t *itunesdb, int playlist, int data_section) {
 int db_playlist_tihm_add (ipoddb_t *itunesdb, int playlist, int data_section, int tihm_num) {
   tree_node_t *pyhm_header, *pihm_header;
   struct db_pyhm *pyhm_data;
-  int order;
-  int entry_num, ret;
-  char *name;
+  int order, ret;
 
   if (itunesdb == NULL)
     return -EINVAL;
 
-  db_log (itunesdb, 0, "db_playlist_tihm_add: entering...\n");
-
   /* make sure the tihm exists in the database before continuing */
   if ((ret = db_tihm_retrieve (itunesdb, NULL, NULL, tihm_num)) < 0)
     return ret;
-    
+
   if ((ret = db_playlist_retrieve (itunesdb, NULL, NULL, playlist, data_section, &pyhm_header)) < 0)
     return ret;
 
-  pyhm_data   = (struct db_pyhm *) pyhm_header->data;
+  /* a single song is appended directly. db_playlist_tihm_add_many is for batches */
+  if (db_pihm_search (pyhm_header, tihm_num) != -1)
+    return 0;
 
-  /* check if the reference already exists in this playlist */
-  entry_num = db_pihm_search (pyhm_header, tihm_num);
+  pyhm_data = (struct db_pyhm *) pyhm_header->data;
 
   if (pyhm_data->num_pihm != 0) {
-    struct db_pihm *pihm_data = (struct db_pihm *)pyhm_header->children[pyhm_header->num_children - 1];
+    struct db_pihm *pihm_data = (struct db_pihm *)pyhm_header->children[pyhm_header->num_children - 1]->data;
 
     order = pihm_data->order + 1;
   } else
     /* 100000 after the last song entry should be a safe number to start at */
     order = itunesdb->last_entry + 100000;
 
-  if (entry_num == -1) {
-    db_pihm_create (&pihm_header, tihm_num, order, 0);
-    db_attach (pyhm_header, pihm_header);
-    
-    pyhm_data->num_pihm += 1;
+  if ((ret = db_pihm_create (&pihm_header, tihm_num, order, 0)) < 0)
+    return ret;
+
+  if ((ret = db_attach (pyhm_header, pihm_header)) < 0) {
+    db_free_tree (pihm_header);
+    return ret;
   }
 
-  db_log (itunesdb, 0, "db_playlist_tihm_add: complete\n");
+  pyhm_data->num_pihm += 1;
 
   return 0;
 }
 
+struct tihm_set {
+  u_int32_t *tihm_nums;
+  int num_tihms;
+};
+
+static int pihm_in_set (tree_node_t *entry, void *arg) {
+  struct db_pihm *pihm_data = (struct db_pihm *)entry->data;
+  struct tihm_set *set = (struct tihm_set *)arg;
+
+  if (pihm_data->pihm != PIHM)
+    return 0;
+
+  return (set == NULL) || bsearch (&pihm_data->reference, set->tihm_nums, set->num_tihms,
+				   sizeof (u_int32_t), u32_compare) != NULL;
+}
+
+/*
+  db_playlist_tihm_purge:
+
+  Internal function that removes every reference in pyhm_header to a song in
+  tihm_nums (sorted) in a single pass. If tihm_nums is NULL all references are
+  removed.
+
+  Returns:
+   < 0 on error
+   >=0 number of references removed
+*/
+static int db_playlist_tihm_purge (tree_node_t *pyhm_header, u_int32_t *tihm_nums, int num_tihms) {
+  struct db_pyhm *pyhm_data = (struct db_pyhm *) pyhm_header->data;
+  struct tihm_set set;
+  int ret;
+
+  set.tihm_nums = tihm_nums;
+  set.num_tihms = num_tihms;
+
+  /* the pihm dohm is a child of the pihm so it is removed with it */
+  ret = db_remove_children (pyhm_header, pyhm_data->num_dohm, pihm_in_set, tihm_nums ? &set : NULL);
+
+  if (ret > 0)
+    pyhm_data->num_pihm -= ret;
+
+  return ret;
+}
+
 /**
-  db_playlist_tihm_remove:
+  db_playlist_tihm_remove_many:
 
-    Removes the reference to song tihm_num from playlist.
+    Removes the references to songs from a playlist.
 
   Arguments:
-   ipoddb_t *itunesdb - Opened itunesdb
-   int         playlist - Playlist index (0 is the master playlist)
-   int         tihm_num - Song reference to remove
+   ipoddb_t *itunesdb     - Opened itunesdb
+   int       playlist     - Playlist index (0 is the master playlist)
+   int       data_section - typically 2 for music or 3 for video
+   int       tihm_nums[]  - Song references to remove
+   int       num_tihms    - Number of references
 
   Returns:
    < 0 on error
-     0 on success
+   >=0 number of references removed
 **/
-int db_playlist_tihm_remove (ipoddb_t *itunesdb, int playlist, int data_section, int tihm_num) {
-  tree_node_t *pyhm_header, *pihm_header, *dohm_header;
-  struct db_pyhm *pyhm_data;
-
-  int entry_num, ret;
+int db_playlist_tihm_remove_many (ipoddb_t *itunesdb, int playlist, int data_section, int tihm_nums[],
+				  int num_tihms) {
+  tree_node_t *pyhm_header;
+  u_int32_t *sorted;
+  int i, ret;
 
-  if (itunesdb == NULL)
+  if (itunesdb == NULL || num_tihms < 0 || (num_tihms && tihm_nums == NULL))
     return -EINVAL;
 
-  db_log (itunesdb, 0, "db_playlist_tihm_remove: entering...\n");
+  db_log (itunesdb, 0, "db_playlist_tihm_remove_many: entering...\n");
 
   if ((ret = db_playlist_retrieve (itunesdb, NULL, NULL, playlist, data_section, &pyhm_header)) < 0)
     return ret;
 
-  pyhm_data   = (struct db_pyhm *) pyhm_header->data;
+  if (num_tihms == 0)
+    return 0;
 
-  /* search and destroy */
-  entry_num = db_pihm_search (pyhm_header, tihm_num);
+  sorted = (u_int32_t *) calloc (num_tihms, sizeof (u_int32_t));
+  if (sorted == NULL)
+    return -errno;
 
-  if (entry_num > -1) {
-    db_detach (pyhm_header, entry_num, &pihm_header);
-    db_detach (pyhm_header, entry_num, &dohm_header);
-    
-    db_free_tree (pihm_header);
-    db_free_tree (dohm_header);
+  for (i = 0 ; i < num_tihms ; i++)
+    sorted[i] = (u_int32_t) tihm_nums[i];
 
-    pyhm_data->num_pihm -= 1;
-  }
+  qsort (sorted, num_tihms, sizeof (u_int32_t), u32_compare);
 
-  db_log (itunesdb, 0, "db_playlist_tihm_remove: complete\n");
+  ret = db_playlist_tihm_purge (pyhm_header, sorted, num_tihms);
 
-  return 0;
+  free (sorted);
+
+  db_log (itunesdb, 0, "db_playlist_tihm_remove_many: complete\n");
+
+  return ret;
+}
+
+/**
+  db_playlist_tihm_remove:
+
+    Removes the reference to song tihm_num from playlist.
+
+  Arguments:
+   ipoddb_t *itunesdb - Opened itunesdb
+   int         playlist - Playlist index (0 is the master playlist)
+   int         tihm_num - Song reference to remove
+
+  Returns:
+   < 0 on error
+     0 on success
+**/
+int db_playlist_tihm_remove (ipoddb_t *itunesdb, int playlist, int data_section, int tihm_num) {
+  int ret;
+
+  ret = db_playlist_tihm_remove_many (itunesdb, playlist, data_section, &tihm_num, 1);
+
+  return (ret < 0) ? ret : 0;
 }
 
 /*
@@ -549,10 +929,7 @@ int db_playlist_tihm_remove (ipoddb_t *itunesdb, int playlist, int data_section,
      0 on success
 */
 int db_playlist_clear (ipoddb_t *itunesdb, int playlist, int data_section) {
-  tree_node_t *pyhm_header, *pihm_header, *dohm_header;
-
-  struct db_pyhm *pyhm_data;
-
+  tree_node_t *pyhm_header;
   int ret;
   
   if (itunesdb == NULL)
@@ -561,30 +938,15 @@ int db_playlist_clear (ipoddb_t *itunesdb, int playlist, int data_section) {
   if ((ret = db_playlist_retrieve (itunesdb, NULL, NULL, playlist, data_section, &pyhm_header)) < 0)
     return ret;
 
-  pyhm_data   = (struct db_pyhm *) pyhm_header->data;
+  ret = db_playlist_tihm_purge (pyhm_header, NULL, 0);
 
-  while (pyhm_data->num_pihm) {
-    struct db_pihm *pihm_data = (struct db_pihm *)pyhm_header->children[pyhm_header->num_children - 1];
-
-    if (pihm_data->pihm == DOHM) {
-      db_detach (pyhm_header, pyhm_header->num_children, &dohm_header);
-      db_free_tree (dohm_header);
-    }
-
-    db_detach (pyhm_header, pyhm_header->num_children, &pihm_header);
-
-    db_free_tree (pihm_header);
-
-    pyhm_data->num_pihm--;
-  }
-
-  return 0;
+  return (ret < 0) ? ret : 0;
 }
 
 /*
   db_playlist_fill:
 
-    Fills a playlist with references to every song.
+    Fills a playlist with references to every song (in song list order).
 
   Arguments:
    ipoddb_t *itunesdb - Opened itunesdb
@@ -595,46 +957,81 @@ int db_playlist_clear (ipoddb_t *itunesdb, int playlist, int data_section) {
      0 on success
 */
 int db_playlist_fill (ipoddb_t *itunesdb, int playlist, int data_section) {
-  tree_node_t *track_dshm, *tlhm_header;
-
-  db_tlhm_t *tlhm_data;
-  struct db_tihm *tihm_data;
-
-  int i, ret;
+  tree_node_t *track_dshm, *pyhm_header;
+  u_int32_t *tihm_nums;
+  int i, num_tihms, ret;
   
   if ((ret = db_playlist_clear (itunesdb, playlist, data_section)) < 0)
     return ret;
 
+  if ((ret = db_playlist_retrieve (itunesdb, NULL, NULL, playlist, data_section, &pyhm_header)) < 0)
+    return ret;
+
   if ((ret = db_dshm_retrieve (itunesdb, &track_dshm, 1)) < 0)
     return -EINVAL;
 
-  tlhm_header= track_dshm->children[0];
-  tlhm_data  = (db_tlhm_t *)tlhm_header->data;
+  num_tihms = track_dshm->num_children - 1;
 
-  for (i = 0 ; i < tlhm_data->list_entries ; i++)
-    db_playlist_tihm_add (itunesdb, playlist, tihm_data->identifier, data_section);
+  tihm_nums = (u_int32_t *) calloc (num_tihms + 1, sizeof (u_int32_t));
+  if (tihm_nums == NULL)
+    return -errno;
 
-  return 0;
+  for (i = 0 ; i < num_tihms ; i++)
+    tihm_nums[i] = ((struct db_tihm *)track_dshm->children[i + 1]->data)->identifier;
+
+  ret = db_playlist_tihm_append (itunesdb, pyhm_header, tihm_nums, num_tihms);
+
+  free (tihm_nums);
+
+  return (ret < 0) ? ret : 0;
 }
 
-/* remove a track reference from every playlist */
-static int db_playlist_remove_all_ds (ipoddb_t *itunesdb, int tihm_num, int data_section) {
-  int i, total;
+/*
+  db_playlist_purge_tihms:
 
-  if (itunesdb == NULL)
+  Internal function that removes every reference to the songs in tihm_nums
+  (sorted) from every playlist in both playlist data sections. Each playlist
+  is filtered in one pass.
+
+  Returns:
+   < 0 on error
+   >=0 number of references removed
+*/
+int db_playlist_purge_tihms (ipoddb_t *itunesdb, u_int32_t *tihm_nums, int num_tihms) {
+  tree_node_t *dshm_header;
+  db_plhm_t *plhm_data;
+  int data_section, i, ret, total = 0;
+
+  if (itunesdb == NULL || num_tihms < 0 || (num_tihms && tihm_nums == NULL))
     return -EINVAL;
 
-  if ((total = db_playlist_number (itunesdb, data_section)) < 0)
-    return total;
-  
-  for (i = 0 ; i < total ; i++)
-    db_playlist_tihm_remove (itunesdb, i, tihm_num, data_section);
+  if (num_tihms == 0)
+    return 0;
 
-  return 0;
+  /* the video/podcast section (3) may not exist */
+  for (data_section = 2 ; data_section <= 3 ; data_section++) {
+    if (db_playlist_retrieve (itunesdb, &plhm_data, &dshm_header, 0, data_section, NULL) < 0)
+      continue;
+
+    for (i = 1 ; i <= plhm_data->list_entries && i < dshm_header->num_children ; i++) {
+      if ((ret = db_playlist_tihm_purge (dshm_header->children[i], tihm_nums, num_tihms)) < 0)
+	return ret;
+
+      total += ret;
+    }
+  }
+
+  return total;
 }
 
+/* remove a track reference from every playlist */
 int db_playlist_remove_all (ipoddb_t *itunesdb, int tihm_num) {
-  return db_playlist_remove_all_ds (itunesdb, tihm_num, (db_isvideo (itunesdb, tihm_num)) ? 3 : 2);
+  u_int32_t tihm = (u_int32_t) tihm_num;
+  int ret;
+
+  ret = db_playlist_purge_tihms (itunesdb, &tihm, 1);
+
+  return (ret < 0) ? ret : 0;
 }
 
 int db_playlist_column_show (ipoddb_t *itunesdb, int playlist, int data_section, int column, u_int16_t width) {
@@ -789,6 +1186,50 @@ int db_playlist_get_name (ipoddb_t *itunesdb, int playlist, int data_section, ch
   return 0;
 }
 
+/* the indices (0x34 dohms) the master playlists carry */
+static int index_sort_by[] = {IPOD_TITLE, IPOD_ALBUM, IPOD_ARTIST, IPOD_GENRE, IPOD_COMPOSER, -1};
+
+/*
+  db_playlist_indices_stale:
+
+  Returns 1 if the indices of the master playlists have to be rebuilt: the
+  track list changed since they were built (or loaded) or one of them is
+  missing. Returns 0 if they can be written as they are.
+*/
+int db_playlist_indices_stale (ipoddb_t *itunesdb) {
+  tree_node_t *dshm_header, *pyhm_header;
+  struct db_pyhm *pyhm_data;
+  struct db_dohm *dohm_data;
+  u_int32_t *iptr;
+  int data_section, i, j;
+
+  if (db_dshm_retrieve (itunesdb, &dshm_header, 1) < 0 ||
+      dshm_header->generation != dshm_header->indices_generation)
+    return 1;
+
+  for (data_section = 2 ; data_section <= 3 ; data_section++) {
+    if (db_playlist_retrieve (itunesdb, NULL, NULL, 0, data_section, &pyhm_header) < 0)
+      continue;
+
+    pyhm_data = (struct db_pyhm *)pyhm_header->data;
+
+    for (i = 0 ; index_sort_by[i] > -1 ; i++) {
+      for (j = 0 ; j < pyhm_data->num_dohm ; j++) {
+	dohm_data = (struct db_dohm *)pyhm_header->children[j]->data;
+	iptr      = (u_int32_t *)&(pyhm_header->children[j]->data[0x18]);
+
+	if (dohm_data->type == 0x34 && iptr[0] == db_dohm_index_type (index_sort_by[i]))
+	  break;
+      }
+
+      if (j == pyhm_data->num_dohm)
+	return 1;
+    }
+  }
+
+  return 0;
+}
+
 int db_playlist_strip_indices (ipoddb_t *itunesdb) {
   db_playlist_strip_indices_ds (itunesdb, 2);
   db_playlist_strip_indices_ds (itunesdb, 3);
@@ -829,15 +1270,79 @@ int db_playlist_strip_indices_ds (ipoddb_t *itunesdb, int data_section) {
 }
 
 int db_playlist_add_indices (ipoddb_t *itunesdb) {
+  tree_node_t *dshm_header;
+
   db_playlist_add_indices_ds (itunesdb, 2);
   db_playlist_add_indices_ds (itunesdb, 3);
+
+  /* the indices now match the track list */
+  if (db_dshm_retrieve (itunesdb, &dshm_header, 1) == 0)
+    dshm_header->indices_generation = dshm_header->generation;
+}
+
+/*
+  db_playlist_get_index:
+
+  Finds the index (0x34 dohm) sorted by sort_by in the master playlist. The
+  index is only used if the track list has not changed since the database was
+  loaded or the indices were last built.
+
+  Arguments:
+   ipoddb_t   *itunesdb - opened itunesdb
+   int         sort_by  - IPOD_TITLE, IPOD_ALBUM, IPOD_ARTIST, IPOD_GENRE or IPOD_COMPOSER
+   u_int32_t **tracks   - set to the track list positions stored in the index
+
+  Returns:
+   < 0 if there is no usable index
+   >=0 number of entries in the index
+*/
+int db_playlist_get_index (ipoddb_t *itunesdb, int sort_by, u_int32_t **tracks) {
+  tree_node_t *dshm_header, *pyhm_header;
+  struct db_pyhm *pyhm_data;
+  struct db_dohm *dohm_data;
+  db_tlhm_t *tlhm_data;
+  u_int32_t *iptr;
+
+  int i, ret, type;
+
+  if (itunesdb == NULL || tracks == NULL || (type = db_dohm_index_type (sort_by)) == -1)
+    return -EINVAL;
+
+  if ((ret = db_dshm_retrieve (itunesdb, &dshm_header, 1)) < 0)
+    return ret;
+
+  if (dshm_header->generation != dshm_header->indices_generation)
+    return -1;
+
+  tlhm_data = (db_tlhm_t *)dshm_header->children[0]->data;
+
+  if ((ret = db_playlist_retrieve (itunesdb, NULL, NULL, 0, 2, &pyhm_header)) < 0)
+    return ret;
+
+  pyhm_data = (struct db_pyhm *)pyhm_header->data;
+
+  for (i = 0 ; i < pyhm_data->num_dohm ; i++) {
+    dohm_data = (struct db_dohm *)pyhm_header->children[i]->data;
+    iptr = (u_int32_t *)&(pyhm_header->children[i]->data[0x18]);
+
+    if (dohm_data->type != 0x34 || iptr[0] != type)
+      continue;
+
+    /* an index that does not cover every track is of no use */
+    if (iptr[1] != tlhm_data->list_entries)
+      return -1;
+
+    *tracks = &iptr[10];
+
+    return iptr[1];
+  }
+
+  return -1;
 }
 
 int db_playlist_add_indices_ds (ipoddb_t *itunesdb, int data_section) {
   tree_node_t *pyhm_header, *dohm_header;
   struct db_pyhm *pyhm_data;
-  int sort_by[] = {IPOD_TITLE, IPOD_ALBUM, IPOD_ARTIST, IPOD_GENRE, IPOD_COMPOSER, -1};
-
   u_int32_t *tracks;
   u_int32_t num_tracks;
 
@@ -853,11 +1358,11 @@ int db_playlist_add_indices_ds (ipoddb_t *itunesdb, int data_section) {
  
   pyhm_data = (struct db_pyhm *)pyhm_header->data;
 
-  for (i = 0 ; sort_by[i] > -1 ; i++) {
-    if (db_tihm_get_sorted_indices (itunesdb, sort_by[i], &tracks, &num_tracks) < 0) 
+  for (i = 0 ; index_sort_by[i] > -1 ; i++) {
+    if (db_tihm_get_sorted_indices (itunesdb, index_sort_by[i], &tracks, &num_tracks) < 0) 
       continue;
 
-    if (db_dohm_index_create (&dohm_header, sort_by[i], num_tracks, tracks) == 0)
+    if (db_dohm_index_create (&dohm_header, index_sort_by[i], num_tracks, tracks) == 0)
       db_pyhm_dohm_attach (pyhm_header, dohm_header);
 
     free (tracks);
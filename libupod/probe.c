@@ -0,0 +1,184 @@
+/**
+ *   (c) 2007 Nathan Hjelm <hjelmn@users.sourceforge.net>
+ *   v0.1.0 probe.c
+ *
+ *   Opens media files once, identifies the container from its first bytes,
+ *   and hands the file to the matching parser.
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the Lesser GNU Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the Lesser GNU Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ **/
+
+#include "itunesdbi.h"
+
+#if !defined(HAVE_FSEEKO)
+#define fseeko fseek
+#endif
+
+/* used when the contents do not identify the file (mp3s with junk at the start) */
+static struct {
+  char *extension;
+  int type;
+} extension_map[] = {{"mp3", MEDIA_MPEG},
+		     {"m4a", MEDIA_MP4},
+		     {"m4p", MEDIA_MP4},
+		     {"m4v", MEDIA_MP4},
+		     {"aac", MEDIA_MP4},
+		     {NULL , MEDIA_UNKNOWN}};
+
+/* returns the media type identified by the first bytes of a file */
+static int media_sniff (u_int8_t *head, size_t length) {
+  if (length >= 12 && memcmp (head + 4, "ftyp", 4) == 0)
+    return MEDIA_MP4;
+
+  if (length >= 12 && memcmp (head, "RIFF", 4) == 0 && memcmp (head + 8, "WAVE", 4) == 0)
+    return MEDIA_RIFF;
+
+  if (length >= 12 && memcmp (head, "FORM", 4) == 0 &&
+      (memcmp (head + 8, "AIFF", 4) == 0 || memcmp (head + 8, "AIFC", 4) == 0))
+    return MEDIA_AIFF;
+
+  if (length >= 10 && memcmp (head, "ID3", 3) == 0)
+    return MEDIA_MPEG;
+
+  /* frame sync with a valid layer, bitrate and sample rate */
+  if (length >= 4 && head[0] == 0xff && (head[1] & 0xe0) == 0xe0 && (head[1] & 0x06) != 0 &&
+      (head[2] & 0xf0) != 0xf0 && (head[2] & 0x0c) != 0x0c)
+    return MEDIA_MPEG;
+
+  return MEDIA_UNKNOWN;
+}
+
+/*
+  media_open:
+
+  Opens path and reads the first MEDIA_HEAD_SIZE bytes into media->head.
+  media->type is set from the contents of the file (or its extension if
+  the contents are not recognized).
+
+  Returns:
+   < 0 on error
+     0 on success
+*/
+int media_open (char *path, struct media_file *media) {
+  char *extension;
+  int i;
+
+  if (path == NULL || media == NULL)
+    return -EINVAL;
+
+  memset (media, 0, sizeof (struct media_file));
+
+  media->path = path;
+
+  if ((media->fh = fopen (path, "r")) == NULL)
+    return -errno;
+
+  if (fstat (fileno (media->fh), &media->statinfo) < 0 ||
+      (media->head = (u_int8_t *) malloc (MEDIA_HEAD_SIZE)) == NULL) {
+    i = -errno;
+    media_close (media);
+
+    return i;
+  }
+
+  media->head_length = fread (media->head, 1, MEDIA_HEAD_SIZE, media->fh);
+
+  media->type = media_sniff (media->head, media->head_length);
+
+  if (media->type == MEDIA_UNKNOWN && (extension = strrchr (path, '.')) != NULL)
+    for (i = 0 ; extension_map[i].extension ; i++)
+      if (strcasecmp (extension + 1, extension_map[i].extension) == 0) {
+	media->type = extension_map[i].type;
+	break;
+      }
+
+  mp3_debug ("media_open: %s has type %i\n", path, media->type);
+
+  return 0;
+}
+
+/*
+  media_read:
+
+  Reads length bytes at offset into buffer. Ranges inside media->head are
+  copied without touching the file.
+
+  Returns:
+   the number of bytes read
+*/
+size_t media_read (struct media_file *media, off_t offset, void *buffer, size_t length) {
+  if (offset < 0)
+    return 0;
+
+  if ((u_int64_t)offset + length <= media->head_length) {
+    memcpy (buffer, media->head + offset, length);
+
+    return length;
+  }
+
+  if (fseeko (media->fh, offset, SEEK_SET) < 0)
+    return 0;
+
+  return fread (buffer, 1, length, media->fh);
+}
+
+void media_close (struct media_file *media) {
+  if (media->fh)
+    fclose (media->fh);
+
+  if (media->head)
+    free (media->head);
+
+  media->fh   = NULL;
+  media->head = NULL;
+}
+
+/*
+  media_fill_tihm:
+
+  Fills tihm from the file at path. The file is opened once and every
+  parser works from the same handle and header buffer. Embedded cover art
+  is left in tihm->image_data.
+
+  Returns:
+   < 0 on error
+     0 on success
+*/
+int media_fill_tihm (char *path, tihm_t *tihm, int flags) {
+  struct media_file media;
+  int ret;
+
+  if ((ret = media_open (path, &media)) < 0)
+    return ret;
+
+  switch (media.type) {
+  case MEDIA_MPEG:
+    ret = mp3_fill_tihm (&media, tihm, flags);
+    break;
+  case MEDIA_MP4:
+    ret = mp4_fill_tihm (&media, tihm);
+    break;
+  case MEDIA_RIFF:
+  case MEDIA_AIFF:
+    ret = pcm_fill_tihm (&media, tihm);
+    break;
+  default:
+    ret = -1;
+  }
+
+  media_close (&media);
+
+  return ret;
+}
@@ -79,6 +79,87 @@ int db_song_remove (ipoddb_t *itunesdb, u_int32_t tihm_num) {
   return 0;
 }
 
+static int tihm_num_compare (const void *a, const void *b) {
+  u_int32_t x = *(const u_int32_t *)a;
+  u_int32_t y = *(const u_int32_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+struct tihm_marks {
+  u_int32_t *tihm_nums;
+  int num_tihms;
+};
+
+static int tihm_is_marked (tree_node_t *entry, void *arg) {
+  struct db_tihm *tihm_data = (struct db_tihm *)entry->data;
+  struct tihm_marks *marks = (struct tihm_marks *)arg;
+
+  return tihm_data->tihm == TIHM &&
+    bsearch (&tihm_data->identifier, marks->tihm_nums, marks->num_tihms, sizeof (u_int32_t),
+	     tihm_num_compare) != NULL;
+}
+
+/**
+  db_song_remove_many:
+
+   Deletes many entries from the song list and every reference to them from
+  all playlists. The song list and each playlist are compacted in a single
+  pass regardless of the number of songs removed.
+
+  Arguments:
+   ipoddb_t  *itunesdb    - opened itunesdb
+   u_int32_t  tihm_nums[] - song references to remove
+   int        num_tihms   - number of references
+
+  Returns:
+   < 0 on error
+   >=0 number of songs removed
+**/
+int db_song_remove_many (ipoddb_t *itunesdb, u_int32_t tihm_nums[], int num_tihms) {
+  tree_node_t *dshm_header;
+  struct tihm_marks marks;
+  db_tlhm_t *tlhm;
+  int ret;
+
+  if (itunesdb == NULL || itunesdb->tree_root == NULL || itunesdb->type != 0 ||
+      num_tihms < 0 || (num_tihms && tihm_nums == NULL))
+    return -EINVAL;
+
+  db_log (itunesdb, 0, "db_song_remove_many: entering...\n");
+
+  if (num_tihms == 0)
+    return 0;
+
+  if ((ret = db_dshm_retrieve (itunesdb, &dshm_header, 1)) < 0) {
+    db_log (itunesdb, ret, "db_song_remove_many: could not get song list header\n");
+    return ret;
+  }
+
+  marks.num_tihms = num_tihms;
+  marks.tihm_nums = (u_int32_t *) calloc (num_tihms, sizeof (u_int32_t));
+  if (marks.tihm_nums == NULL)
+    return -errno;
+
+  memcpy (marks.tihm_nums, tihm_nums, num_tihms * sizeof (u_int32_t));
+  qsort (marks.tihm_nums, num_tihms, sizeof (u_int32_t), tihm_num_compare);
+
+  /* remove the entries (the tlhm is child 0) */
+  if ((ret = db_remove_children (dshm_header, 1, tihm_is_marked, &marks)) > 0) {
+    tlhm = (db_tlhm_t *)dshm_header->children[0]->data;
+    tlhm->list_entries -= ret;
+
+    /* remove from all playlists */
+    db_playlist_purge_tihms (itunesdb, marks.tihm_nums, marks.num_tihms);
+  }
+
+  free (marks.tihm_nums);
+
+  db_log (itunesdb, 0, "db_song_remove_many: complete. removed %i songs\n", ret);
+
+  return ret;
+}
+
 /**
   db_add:
 
@@ -95,10 +176,8 @@ int db_song_remove (ipoddb_t *itunesdb, u_int32_t tihm_num) {
 */
 int db_song_add (ipoddb_t *itunesdb, ipoddb_t *artworkdb, char *path,
 		 char *mac_path, int stars, int show) {
-  tree_node_t *dshm_header, *new_tihm_header;
-
-  db_tlhm_t *tlhm_data;
-  int tihm_num, ret;
+  tree_node_t *dshm_header;
+  int ret;
 
   tihm_t tihm;
 
@@ -122,32 +201,80 @@ int db_song_add (ipoddb_t *itunesdb, ipoddb_t *artworkdb, char *path,
     return -1; /* A song already exists in the database with this path */
   }
 
-  /* Set the new tihm entry's number to 1 + the previous one */
-  tihm_num = itunesdb->last_entry + 1;
-
-  if ((ret = tihm_fill_from_file (&tihm, path, mac_path, stars, tihm_num)) < 0) {
+  if ((ret = tihm_fill_from_file (&tihm, path, mac_path, stars, itunesdb->last_entry + 1, itunesdb->flags)) < 0) {
     db_log (itunesdb, ret, "db_song_add: could not parse audio file.\n");
 
     return ret;
   }
 
-  if ((ret = db_tihm_create (&new_tihm_header, &tihm, itunesdb->flags)) < 0) {
-    db_log (itunesdb, ret, "db_song_add: could not add track.\n");
-    free (new_tihm_header);
+  ret = db_song_add_probed (itunesdb, artworkdb, &tihm, show);
+
+  db_log (itunesdb, ret, "db_song_add: complete\n");
+
+  return ret;
+}
+
+/**
+  db_song_add_probed:
+
+   Adds a song filled in by db_song_probe_batch to the song list. The caller
+  is responsible for making sure the song is not already in the database
+  (db_song_probe_batch does this). The tihm is freed whether or not the song
+  could be added. Artwork is queued for the ArtworkDB with db_photo_queue.
+  If the artwork can not be queued the song is added without it.
+
+  Arguments:
+   ipoddb_t *itunesdb  - Opened iTunesDB
+   ipoddb_t *artworkdb - Opened ArtworkDB (may be NULL)
+   tihm_t   *tihm      - Probed song
+   int       show      - Add a reference to the song to the master playlist
+
+  Returns:
+   < 0 on error
+   >=0 the new tihm number on success
+**/
+int db_song_add_probed (ipoddb_t *itunesdb, ipoddb_t *artworkdb, tihm_t *tihm, int show) {
+  tree_node_t *dshm_header, *new_tihm_header;
+
+  db_tlhm_t *tlhm_data;
+  int tihm_num, ret;
+
+  if (itunesdb == NULL || tihm == NULL || itunesdb->type != 0)
+    return -EINVAL;
+
+  /* find the song list */
+  if ((ret = db_dshm_retrieve (itunesdb, &dshm_header, 1)) < 0) {
+    db_log (itunesdb, 0, "db_song_add_probed: could net get data storage for track list.\n");
+    tihm_free (tihm);
 
     return ret;
   }
 
-  if (artworkdb && tihm.image_data)
-    db_photo_add (artworkdb, tihm.image_data, tihm.image_size, tihm.artwork_id);
+  /* Set the new tihm entry's number to 1 + the previous one */
+  tihm_num = tihm->num = itunesdb->last_entry + 1;
+
+  if (artworkdb && tihm->image_data &&
+      (ret = db_photo_queue (artworkdb, tihm->image_data, tihm->image_size, tihm->artwork_id)) < 0) {
+    db_log (itunesdb, ret, "db_song_add_probed: could not add artwork. adding the track without it.\n");
+    tihm->has_artwork = 0;
+    tihm->artwork_id  = 0;
+  }
+
+  if ((ret = db_tihm_create (&new_tihm_header, tihm, itunesdb->flags)) < 0) {
+    db_log (itunesdb, ret, "db_song_add_probed: could not add track.\n");
+    free (new_tihm_header);
+    tihm_free (tihm);
+
+    return ret;
+  }
 
   new_tihm_header->parent = dshm_header;
   db_attach (dshm_header, new_tihm_header);
 
-  if (tihm.is_podcast)
-    db_podcast_add_tihm (itunesdb, &tihm);
+  if (tihm->is_podcast)
+    db_podcast_add_tihm (itunesdb, tihm);
 
-  tihm_free (&tihm);
+  tihm_free (tihm);
   
   if (show != 0)
     db_song_unhide(itunesdb, tihm_num);
@@ -158,11 +285,366 @@ int db_song_add (ipoddb_t *itunesdb, ipoddb_t *artworkdb, char *path,
 
   itunesdb->last_entry++;
 
-  db_log (itunesdb, ret, "db_song_add: complete\n");
-
   return tihm_num;
 }
 
+struct song_batch_entry {
+  char *path;
+  char *mac_path;
+
+  /* the path as it would be stored in (and read back from) the database */
+  u_int8_t *key;
+
+  tihm_t tihm;
+  int flags; /* database flags (see FLAG_EXACT_DURATION) */
+  int ret;
+};
+
+static int song_batch_key_compare (const void *a, const void *b) {
+  const struct song_batch_entry *entry1 = *(const struct song_batch_entry **)a;
+  const struct song_batch_entry *entry2 = *(const struct song_batch_entry **)b;
+  int cmp;
+
+  if ((cmp = strcasecmp ((char *)entry1->key, (char *)entry2->key)) != 0)
+    return cmp;
+
+  /* keep the first occurrence of a path first */
+  return (entry1 < entry2) ? -1 : (entry1 > entry2);
+}
+
+/* runs on a worker thread: only touches the batch entry */
+static void song_batch_probe (void *arg, int index) {
+  struct song_batch_entry *entry = (struct song_batch_entry *)arg + index;
+
+  if (entry->ret < 0)
+    return;
+
+  /* the identifier is not known until the file is accepted */
+  entry->ret = tihm_fill_from_file (&entry->tihm, entry->path, entry->mac_path, 0, 0, entry->flags);
+}
+
+/*
+  song_batch_prepare (internal):
+
+  Fills in entries for paths/mac_paths, marks the paths that are already in
+  the database (unless probe_flags has PROBE_EXISTING) or repeated in the
+  batch with -EEXIST, then probes the remaining files in parallel (see
+  ipoddb_t.num_threads).
+
+  Returns:
+   < 0 on error
+     0 on success
+*/
+static int song_batch_prepare (ipoddb_t *itunesdb, struct song_batch_entry *entries, char *paths[],
+			       char *mac_paths[], int num_paths, int probe_flags) {
+  tree_node_t *dohm_header;
+  struct song_batch_entry **sorted;
+  struct path_index index;
+  dohm_t dohm;
+  int i, ret;
+
+  sorted = (struct song_batch_entry **) calloc (num_paths, sizeof (struct song_batch_entry *));
+  if (sorted == NULL)
+    return -errno;
+
+  if (probe_flags & PROBE_EXISTING)
+    memset (&index, 0, sizeof (struct path_index));
+  else if ((ret = db_path_index_build (itunesdb, &index)) < 0)
+    db_log (itunesdb, ret, "song_batch_prepare: could not index existing paths. duplicates will not be detected.\n");
+
+  /* filter out paths that are already in the database (this is done before probing to
+     avoid reading files that will not be added) */
+  for (i = 0 ; i < num_paths ; i++) {
+    entries[i].path     = paths[i];
+    entries[i].mac_path = mac_paths[i];
+    entries[i].flags    = itunesdb->flags;
+    sorted[i]           = &entries[i];
+
+    if (paths[i] == NULL || mac_paths[i] == NULL) {
+      entries[i].ret = -EINVAL;
+      entries[i].key = (u_int8_t *)strdup ("");
+      continue;
+    }
+
+    /* store the path the same way db_lookup would */
+    dohm.type = IPOD_PATH;
+    dohm.data = (u_int8_t *)mac_paths[i];
+    dohm_header = NULL;
+
+    if (db_dohm_create (&dohm_header, dohm, 16, itunesdb->flags) < 0 ||
+	db_dohm_get_string (dohm_header, &entries[i].key) < 0) {
+      entries[i].ret = -EINVAL;
+      entries[i].key = (u_int8_t *)strdup ("");
+    }
+
+    db_free_tree (dohm_header);
+
+    if (entries[i].ret == 0 && db_path_index_lookup (&index, entries[i].key) > -1) {
+      db_log (itunesdb, 0, "song_batch_prepare: %s already exists in database.\n", mac_paths[i]);
+      entries[i].ret = -EEXIST;
+    }
+  }
+
+  db_path_index_free (&index);
+
+  qsort (sorted, num_paths, sizeof (struct song_batch_entry *), song_batch_key_compare);
+
+  for (i = 1 ; i < num_paths ; i++)
+    if (sorted[i]->ret == 0 && strcasecmp ((char *)sorted[i - 1]->key, (char *)sorted[i]->key) == 0)
+      sorted[i]->ret = -EEXIST;
+
+  for (i = 0 ; i < num_paths ; i++) {
+    free (entries[i].key);
+    entries[i].key = NULL;
+  }
+
+  free (sorted);
+
+  return upod_parallel_for (upod_thread_count (itunesdb->num_threads), num_paths, song_batch_probe, entries);
+}
+
+/**
+  db_song_probe_batch:
+
+   Reads the tags and audio information of many files in parallel (see
+  ipoddb_t.num_threads) without modifying the database. The probed songs
+  can then be added with db_song_add_probed in whatever order the caller
+  needs. Paths repeated in the batch, or already in the database unless
+  flags has PROBE_EXISTING, are not probed.
+
+  Arguments:
+   ipoddb_t *itunesdb    - Opened iTunesDB
+   char     *paths[]     - Unix paths of the files to probe
+   char     *mac_paths[] - iPod paths (':' seperated) of the files
+   int       num_paths   - Number of files
+   int       flags       - PROBE_EXISTING to probe files already in the database (to update them)
+   tihm_t    tihms[]     - Gets the probed songs. tihms[i] is only filled if results[i] is 0
+                           and must be passed to db_song_add_probed or tihm_free.
+   int       results[]   - Gets 0 if the file was probed, -EEXIST if the file is already in
+                           the database, or another negative error code.
+
+  Returns:
+   < 0 on error
+   >=0 number of files probed on success
+**/
+int db_song_probe_batch (ipoddb_t *itunesdb, char *paths[], char *mac_paths[], int num_paths,
+			 int flags, tihm_t tihms[], int results[]) {
+  struct song_batch_entry *entries;
+  int i, ret, num_probed = 0;
+
+  if (itunesdb == NULL || paths == NULL || mac_paths == NULL || num_paths < 0 ||
+      tihms == NULL || results == NULL || itunesdb->type != 0)
+    return -EINVAL;
+
+  db_log (itunesdb, 0, "db_song_probe_batch: entering...\n");
+
+  if (num_paths == 0)
+    return 0;
+
+  entries = (struct song_batch_entry *) calloc (num_paths, sizeof (struct song_batch_entry));
+  if (entries == NULL)
+    return -errno;
+
+  if ((ret = song_batch_prepare (itunesdb, entries, paths, mac_paths, num_paths, flags)) < 0) {
+    free (entries);
+
+    return ret;
+  }
+
+  for (i = 0 ; i < num_paths ; i++) {
+    if ((results[i] = entries[i].ret) == 0) {
+      tihms[i] = entries[i].tihm;
+      num_probed++;
+    } else {
+      memset (&tihms[i], 0, sizeof (tihm_t));
+
+      if (entries[i].ret != -EEXIST)
+	db_log (itunesdb, entries[i].ret, "db_song_probe_batch: could not parse audio file %s.\n", entries[i].path);
+    }
+  }
+
+  free (entries);
+
+  db_log (itunesdb, 0, "db_song_probe_batch: complete. probed %i of %i files\n", num_probed, num_paths);
+
+  return num_probed;
+}
+
+/**
+  db_song_add_batch:
+
+   Adds many songs to the song list and references to them to the master
+  playlists. The files are probed in parallel (see ipoddb_t.num_threads) then
+  added in the order given so the result does not depend on the number of
+  threads. Paths already in the database (or repeated in the batch) are
+  skipped. Artwork is added with db_photo_add_batch before the tracks are
+  made. A track whose artwork could not be added is added without it.
+
+  Arguments:
+   ipoddb_t *itunesdb   - Opened iTunesDB
+   ipoddb_t *artworkdb  - Opened ArtworkDB (may be NULL)
+   char     *paths[]    - Unix paths of the files to add
+   char     *mac_paths[] - iPod paths (':' seperated) of the files
+   int       num_paths  - Number of files
+   int       results[]  - Optional. Gets the new tihm number of each file, -EEXIST if
+                          the file is already in the database, or another negative
+                          error code.
+
+  Returns:
+   < 0 on error
+   >=0 number of songs added on success
+**/
+int db_song_add_batch (ipoddb_t *itunesdb, ipoddb_t *artworkdb, char *paths[], char *mac_paths[],
+		       int num_paths, int results[]) {
+  tree_node_t *dshm_header, *pyhm_header;
+  tree_node_t **new_tihm_headers;
+  struct song_batch_entry *entries;
+  db_tlhm_t *tlhm_data;
+  u_int32_t *tihm_nums;
+  u_int8_t **images;
+  size_t *image_sizes;
+  u_int64_t *image_ids;
+  int *image_results;
+  int i, ret, num_added = 0, num_images = 0;
+
+  if (itunesdb == NULL || paths == NULL || mac_paths == NULL || num_paths < 0 || itunesdb->type != 0)
+    return -EINVAL;
+
+  db_log (itunesdb, 0, "db_song_add_batch: entering...\n");
+
+  if (num_paths == 0)
+    return 0;
+
+  /* find the song list */
+  if ((ret = db_dshm_retrieve (itunesdb, &dshm_header, 1)) < 0) {
+    db_log (itunesdb, 0, "db_song_add_batch: could net get data storage for track list.\n");
+
+    return ret;
+  }
+
+  entries          = (struct song_batch_entry *) calloc (num_paths, sizeof (struct song_batch_entry));
+  new_tihm_headers = (tree_node_t **) calloc (num_paths, sizeof (tree_node_t *));
+  tihm_nums        = (u_int32_t *) calloc (num_paths, sizeof (u_int32_t));
+  images           = (u_int8_t **) calloc (num_paths, sizeof (u_int8_t *));
+  image_sizes      = (size_t *) calloc (num_paths, sizeof (size_t));
+  image_ids        = (u_int64_t *) calloc (num_paths, sizeof (u_int64_t));
+  image_results    = (int *) calloc (num_paths, sizeof (int));
+
+  if (entries == NULL || new_tihm_headers == NULL || tihm_nums == NULL || images == NULL ||
+      image_sizes == NULL || image_ids == NULL || image_results == NULL)
+    ret = -errno;
+  else
+    ret = song_batch_prepare (itunesdb, entries, paths, mac_paths, num_paths, 0);
+
+  if (ret < 0) {
+    if (entries) free (entries);
+    if (new_tihm_headers) free (new_tihm_headers);
+    if (tihm_nums) free (tihm_nums);
+    if (images) free (images);
+    if (image_sizes) free (image_sizes);
+    if (image_ids) free (image_ids);
+    if (image_results) free (image_results);
+
+    return ret;
+  }
+
+  /* the thumbnails are rendered in parallel and added in order */
+  for (i = 0 ; i < num_paths ; i++)
+    if (entries[i].ret >= 0 && artworkdb && entries[i].tihm.image_data) {
+      images[num_images]      = entries[i].tihm.image_data;
+      image_sizes[num_images] = entries[i].tihm.image_size;
+      image_ids[num_images++] = entries[i].tihm.artwork_id;
+    }
+
+  if (num_images &&
+      (ret = db_photo_add_batch (artworkdb, images, image_sizes, image_ids, num_images, image_results)) < 0)
+    db_log (itunesdb, ret, "db_song_add_batch: could not add artwork.\n");
+
+  /* everything past this point happens in order */
+  for (i = 0, num_images = 0 ; i < num_paths ; i++) {
+    struct song_batch_entry *entry = &entries[i];
+
+    /* tracks must not refer to artwork that was not added */
+    if (entry->ret >= 0 && artworkdb && entry->tihm.image_data && image_results[num_images++] < 0) {
+      db_log (itunesdb, image_results[num_images - 1], "db_song_add_batch: adding %s without artwork.\n",
+	      entry->path);
+      entry->tihm.has_artwork = 0;
+      entry->tihm.artwork_id  = 0;
+    }
+
+    if (entry->ret < 0) {
+      if (entry->ret != -EEXIST)
+	db_log (itunesdb, entry->ret, "db_song_add_batch: could not parse audio file %s.\n", entry->path);
+
+      continue;
+    }
+
+    entry->tihm.num = itunesdb->last_entry + 1;
+
+    if ((ret = db_tihm_create (&new_tihm_headers[num_added], &entry->tihm, itunesdb->flags)) < 0) {
+      db_log (itunesdb, ret, "db_song_add_batch: could not add track %s.\n", entry->path);
+
+      tihm_free (&entry->tihm);
+      entry->ret = ret;
+
+      continue;
+    }
+
+    entry->ret = tihm_nums[num_added++] = ++itunesdb->last_entry;
+  }
+
+  /* add all the tracks to the song list at once */
+  if ((ret = db_attach_many (dshm_header, new_tihm_headers, num_added)) < 0) {
+    db_log (itunesdb, ret, "db_song_add_batch: could not attach tracks.\n");
+
+    for (i = 0 ; i < num_added ; i++)
+      db_free_tree (new_tihm_headers[i]);
+
+    itunesdb->last_entry -= num_added;
+    num_added = 0;
+
+    for (i = 0 ; i < num_paths ; i++)
+      if (entries[i].ret > 0) {
+	tihm_free (&entries[i].tihm);
+	entries[i].ret = ret;
+      }
+  } else {
+    tlhm_data = (db_tlhm_t *)dshm_header->children[0]->data;
+    tlhm_data->list_entries += num_added;
+
+    for (i = 0 ; i < num_paths ; i++)
+      if (entries[i].ret > 0) {
+	if (entries[i].tihm.is_podcast)
+	  db_podcast_add_tihm (itunesdb, &entries[i].tihm);
+
+	tihm_free (&entries[i].tihm);
+      }
+
+    /* reference the new tracks from the master playlists (see db_song_unhide) */
+    if (db_playlist_retrieve (itunesdb, NULL, NULL, 0, 3, &pyhm_header) == 0)
+      db_playlist_tihm_append (itunesdb, pyhm_header, tihm_nums, num_added);
+
+    if (db_playlist_retrieve (itunesdb, NULL, NULL, 0, 2, &pyhm_header) == 0)
+      db_playlist_tihm_append (itunesdb, pyhm_header, tihm_nums, num_added);
+  }
+
+  if (results)
+    for (i = 0 ; i < num_paths ; i++)
+      results[i] = entries[i].ret;
+
+  free (entries);
+  free (new_tihm_headers);
+  free (tihm_nums);
+  free (images);
+  free (image_sizes);
+  free (image_ids);
+  free (image_results);
+
+  db_log (itunesdb, 0, "db_song_add_batch: complete. added %i of %i songs\n", num_added, num_paths);
+
+  return num_added;
+}
+
 /*
   db_hide:
 
@@ -258,29 +740,30 @@ int db_song_set_artwork (ipoddb_t *itunesdb, u_int32_t tihm_num,
 }
 
 /**
-  db_song_list:
+  db_song_list_array:
 
-   Returns a linked list of the songs that are currently in the song list
-  of the iTunesDB.
+   Fills an array with the songs that are currently in the song list of the
+  iTunesDB. Each entry is a tihm_t.
 
   Arguments:
-   ipoddb_t *itunesdb - opened itunesdb
+   ipoddb_t   *itunesdb - opened itunesdb
+   db_array_t *songs    - array to fill (initialized by this function)
 
   Returns:
-   NULL on error
-   ptr  on success
+   < 0 on error
+     0 on success
 **/
-int db_song_list (ipoddb_t *itunesdb, db_list_t **head) {
+int db_song_list_array (ipoddb_t *itunesdb, db_array_t *songs) {
   tree_node_t *dshm_header, *tihm_header, *tlhm_header;
   db_tlhm_t *tlhm_data;
   int i, *iptr;
   int ret;
   tihm_t *tihm;
 
-  if (head == NULL || itunesdb == NULL || itunesdb->type != 0)
+  if (songs == NULL || itunesdb == NULL || itunesdb->type != 0)
     return -EINVAL;
 
-  *head = NULL;
+  db_array_init (songs, 0);
 
   /* get the tree node containing the song list */
   if ((ret = db_dshm_retrieve (itunesdb, &dshm_header, 0x1)) < 0)
@@ -293,7 +776,10 @@ int db_song_list (ipoddb_t *itunesdb, db_list_t **head) {
   if (tlhm_data->list_entries == 0)
     return -1;
 
-  for (i = dshm_header->num_children - 1 ; i > 0 ; i--) {
+  if ((ret = db_array_init (songs, dshm_header->num_children - 1)) < 0)
+    return ret;
+
+  for (i = 1 ; i < dshm_header->num_children ; i++) {
     tihm_header = dshm_header->children[i];
     iptr = (int *)tihm_header->data;
 
@@ -304,18 +790,148 @@ int db_song_list (ipoddb_t *itunesdb, db_list_t **head) {
 
     tihm = calloc (1, sizeof (tihm_t));
 
-    if (db_tihm_fill (tihm_header, tihm) < 0) {
+    if (db_tihm_fill (tihm_header, tihm, itunesdb->string_pool) < 0) {
       free (tihm);
 
       continue;
     }
-    
-    *head = db_list_prepend (*head, (void *)tihm);
+
+    db_array_append (songs, (void *)tihm);
   }
 
   return 0;
 }
 
+/**
+  db_song_list_array_free:
+
+   Frees the songs in an array filled by db_song_list_array or
+  sd_song_list_array and the array itself.
+**/
+void db_song_list_array_free (db_array_t *songs) {
+  int i;
+
+  if (songs == NULL)
+    return;
+
+  for (i = 0 ; i < songs->num_entries ; i++) {
+    tihm_free ((tihm_t *)db_array_index (songs, i));
+    free (db_array_index (songs, i));
+  }
+
+  db_array_free (songs);
+}
+
+/**
+  db_song_list_sorted:
+
+   Fills an array with up to limit songs starting at position offset of the
+  song list sorted by sort_by. The sorted order is read from the index stored
+  in the master playlist so only the returned songs are touched. If the index
+  is missing or out of date the order is computed from the song list.
+
+  Arguments:
+   ipoddb_t   *itunesdb - opened itunesdb
+   int         sort_by  - IPOD_TITLE, IPOD_ALBUM, IPOD_ARTIST, IPOD_GENRE or IPOD_COMPOSER
+   int         offset   - first position to return
+   int         limit    - maximum number of songs to return (< 0 for all)
+   db_array_t *songs    - array to fill (free with db_song_list_array_free)
+
+  Returns:
+   < 0 on error
+   >=0 number of songs in the array
+**/
+int db_song_list_sorted (ipoddb_t *itunesdb, int sort_by, int offset, int limit, db_array_t *songs) {
+  tree_node_t *dshm_header;
+  u_int32_t *tracks, *live_tracks = NULL;
+  u_int32_t num_tracks;
+  tihm_t *tihm;
+  int i, ret;
+
+  if (songs == NULL || itunesdb == NULL || itunesdb->type != 0 || offset < 0 ||
+      db_dohm_index_type (sort_by) == -1)
+    return -EINVAL;
+
+  db_array_init (songs, 0);
+
+  if ((ret = db_dshm_retrieve (itunesdb, &dshm_header, 0x1)) < 0)
+    return ret;
+
+  if ((ret = db_playlist_get_index (itunesdb, sort_by, &tracks)) >= 0)
+    num_tracks = ret;
+  else {
+    db_log (itunesdb, 0, "db_song_list_sorted: no usable index. sorting song list\n");
+
+    if ((ret = db_tihm_get_sorted_indices (itunesdb, sort_by, &live_tracks, &num_tracks)) < 0)
+      return ret;
+
+    tracks = live_tracks;
+  }
+
+  if (limit < 0 || limit > (int)num_tracks - offset)
+    limit = ((int)num_tracks > offset) ? (int)num_tracks - offset : 0;
+
+  if ((ret = db_array_init (songs, limit)) < 0) {
+    free (live_tracks);
+    return ret;
+  }
+
+  for (i = offset ; i < offset + limit ; i++) {
+    if (tracks[i] + 1 >= dshm_header->num_children)
+      continue;
+
+    tihm = calloc (1, sizeof (tihm_t));
+
+    if (db_tihm_fill (dshm_header->children[tracks[i] + 1], tihm, itunesdb->string_pool) < 0) {
+      free (tihm);
+
+      continue;
+    }
+
+    db_array_append (songs, (void *)tihm);
+  }
+
+  free (live_tracks);
+
+  return songs->num_entries;
+}
+
+/**
+  db_song_list:
+
+   Returns a linked list of the songs that are currently in the song list
+  of the iTunesDB. New code should use db_song_list_array.
+
+  Arguments:
+   ipoddb_t *itunesdb - opened itunesdb
+
+  Returns:
+   < 0 on error
+     0 on success
+**/
+int db_song_list (ipoddb_t *itunesdb, db_list_t **head) {
+  db_array_t songs;
+  int ret;
+
+  if (head == NULL)
+    return -EINVAL;
+
+  *head = NULL;
+
+  if ((ret = db_song_list_array (itunesdb, &songs)) < 0)
+    return ret;
+
+  if ((*head = db_list_from_array (&songs)) == NULL && songs.num_entries) {
+    db_song_list_array_free (&songs);
+
+    return -ENOMEM;
+  }
+
+  db_array_free (&songs);
+
+  return 0;
+}
+
 /**
   db_song_list_free:
 
@@ -340,3 +956,202 @@ void db_song_list_free (db_list_t **head) {
 
   *head = NULL;
 }
+
+/**
+  db_track_cursor_open:
+
+   Positions a cursor before the first song in the song list. The cursor
+  reads the database in place and does not allocate memory so there is
+  nothing to free when done with it.
+
+  Arguments:
+   ipoddb_t          *itunesdb - opened itunesdb
+   db_track_cursor_t *cursor   - caller owned cursor
+
+  Returns:
+   < 0 on error
+     0 on success
+**/
+int db_track_cursor_open (ipoddb_t *itunesdb, db_track_cursor_t *cursor) {
+  tree_node_t *dshm_header;
+  int ret;
+
+  if (itunesdb == NULL || cursor == NULL || itunesdb->type != 0)
+    return -EINVAL;
+
+  if ((ret = db_dshm_retrieve (itunesdb, &dshm_header, 0x1)) < 0)
+    return ret;
+
+  cursor->itunesdb   = itunesdb;
+  cursor->track_list = dshm_header;
+  cursor->index      = 0;
+
+  return 0;
+}
+
+/**
+  db_track_cursor_next:
+
+   Moves a cursor to the next song.
+
+  Returns:
+   < 0 on error
+     0 if there are no more songs
+     1 if the cursor is on a song
+**/
+int db_track_cursor_next (db_track_cursor_t *cursor) {
+  tree_node_t *dshm_header;
+
+  if (cursor == NULL || cursor->track_list == NULL)
+    return -EINVAL;
+
+  dshm_header = cursor->track_list;
+
+  /* child 0 is the list header */
+  while (++cursor->index < dshm_header->num_children)
+    if (((struct db_tihm *)dshm_header->children[cursor->index]->data)->tihm == TIHM)
+      return 1;
+
+  cursor->index = dshm_header->num_children;
+
+  return 0;
+}
+
+static tree_node_t *db_track_cursor_tihm (db_track_cursor_t *cursor) {
+  if (cursor == NULL || cursor->track_list == NULL || cursor->index < 1 ||
+      cursor->index >= cursor->track_list->num_children)
+    return NULL;
+
+  return cursor->track_list->children[cursor->index];
+}
+
+/**
+  db_track_cursor_get_u32:
+
+   Reads a numeric field (see enum track_fields) of the current song.
+
+  Returns:
+   the value of the field (0 if the cursor is not on a song)
+**/
+u_int32_t db_track_cursor_get_u32 (db_track_cursor_t *cursor, int field) {
+  tree_node_t *tihm_header = db_track_cursor_tihm (cursor);
+
+  return (tihm_header != NULL) ? db_tihm_get_u32 (tihm_header, field) : 0;
+}
+
+/**
+  db_track_cursor_get_string:
+
+   Copies a string (dohm_type is one of IPOD_TITLE, IPOD_PATH, etc.) of the
+  current song into buf as UTF-8. The string is truncated to fit buf_len
+  bytes (including the terminator).
+
+  Returns:
+     -1 if the song does not have the string
+   < -1 on error
+   >= 0 the length of the whole string (a value >= buf_len means it was truncated)
+**/
+int db_track_cursor_get_string (db_track_cursor_t *cursor, int dohm_type, char *buf, size_t buf_len) {
+  tree_node_t *tihm_header, *dohm_header;
+
+  if ((tihm_header = db_track_cursor_tihm (cursor)) == NULL || (buf == NULL && buf_len))
+    return -EINVAL;
+
+  if (db_dohm_retrieve (tihm_header, &dohm_header, dohm_type) < 0)
+    return -1;
+
+  return db_dohm_get_string_buf (dohm_header, (u_int8_t *)buf, buf_len);
+}
+
+/**
+  db_song_list_fields:
+
+   Returns an array with the requested fields of every song in the song
+  list. mask is built from FIELD_STRING (IPOD_TITLE, ...) and
+  FIELD_VALUE (TRACK_TIME, ...). Fields that are not in the mask are
+  neither read nor converted. The array and all of its strings are stored in
+  a single allocation which is freed with db_song_list_fields_free.
+
+  Arguments:
+   ipoddb_t           *itunesdb - opened itunesdb
+   u_int64_t           mask     - fields to extract
+   db_track_fields_t **tracks   - where to store the array
+
+  Returns:
+   < 0 on error
+   >=0 number of songs in the array
+**/
+int db_song_list_fields (ipoddb_t *itunesdb, u_int64_t mask, db_track_fields_t **tracks) {
+  db_track_cursor_t cursor;
+  size_t string_bytes = 0;
+  int num_tracks = 0, i, field, length;
+  char *strings;
+  int ret;
+
+  if (tracks == NULL)
+    return -EINVAL;
+
+  *tracks = NULL;
+
+  if ((ret = db_track_cursor_open (itunesdb, &cursor)) < 0)
+    return ret;
+
+  /* size the results so only one allocation is needed */
+  while (db_track_cursor_next (&cursor) == 1) {
+    num_tracks++;
+
+    for (field = 1 ; field < TRACK_NUM_STRINGS ; field++)
+      if ((mask & FIELD_STRING(field)) &&
+	  (length = db_track_cursor_get_string (&cursor, field, NULL, 0)) >= 0)
+	string_bytes += length + 1;
+  }
+
+  if (num_tracks == 0)
+    return 0;
+
+  *tracks = (db_track_fields_t *) calloc (1, num_tracks * sizeof (db_track_fields_t) + string_bytes);
+  if (*tracks == NULL)
+    return -errno;
+
+  strings = (char *)&(*tracks)[num_tracks];
+
+  db_track_cursor_open (itunesdb, &cursor);
+
+  for (i = 0 ; db_track_cursor_next (&cursor) == 1 ; i++) {
+    db_track_fields_t *track = &(*tracks)[i];
+
+    track->num = db_track_cursor_get_u32 (&cursor, TRACK_ID);
+
+    for (field = 0 ; field < TRACK_NUM_FIELDS ; field++)
+      if (mask & FIELD_VALUE(field))
+	track->values[field] = db_track_cursor_get_u32 (&cursor, field);
+
+    for (field = 1 ; field < TRACK_NUM_STRINGS ; field++) {
+      if (!(mask & FIELD_STRING(field)))
+	continue;
+
+      /* the space left was counted in the first pass */
+      if ((length = db_track_cursor_get_string (&cursor, field, strings, string_bytes)) < 0)
+	continue;
+
+      track->strings[field] = strings;
+      strings      += length + 1;
+      string_bytes -= length + 1;
+    }
+  }
+
+  return num_tracks;
+}
+
+/**
+  db_song_list_fields_free:
+
+   Frees an array returned by db_song_list_fields.
+**/
+void db_song_list_fields_free (db_track_fields_t **tracks) {
+  if (tracks == NULL || *tracks == NULL)
+    return;
+
+  free (*tracks);
+  *tracks = NULL;
+}
@@ -0,0 +1,232 @@
+/**
+ *   (c) 2007 Nathan Hjelm <hjelmn@users.sourceforge.net>
+ *   v0.1.0 string_pool.c
+ *
+ *   Interned (shared, immutable) UTF-8 strings for track list results. The
+ *   pool is keyed on the raw bytes and encoding of each string as stored in
+ *   the database, so a string is only converted to UTF-8 the first time it
+ *   is seen. UTF-16 strings keep a copy of their raw bytes next to the UTF-8
+ *   form. Nothing is evicted: the pool grows by every distinct string until
+ *   the database is freed.
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the Lesser GNU Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the Lesser GNU Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ **/
+
+#include "itunesdbi.h"
+
+/* raw string encodings */
+#define POOL_UTF8    0
+#define POOL_UTF16LE 1
+#define POOL_UTF16BE 2
+
+struct pool_entry {
+  u_int32_t hash;
+  int encoding;
+  int raw_length;
+
+  u_int8_t *raw;  /* same as utf8 for UTF-8 strings */
+  u_int8_t *utf8;
+};
+
+struct string_pool {
+  struct pool_entry *entries;
+  int num_entries;
+  int size; /* always a power of two */
+};
+
+static int pool_encoding (char *encoding) {
+  if (encoding == NULL || strncmp (encoding, "UTF-16", 6) != 0)
+    return POOL_UTF8;
+
+  /* UTF-16 without a byte order is stored big endian (see libupod_to_utf8_buf) */
+  return (strcmp (encoding, "UTF-16LE") == 0) ? POOL_UTF16LE : POOL_UTF16BE;
+}
+
+/* FNV-1a over the encoding and the raw bytes */
+static u_int32_t pool_hash (int encoding, u_int8_t *raw, int raw_length) {
+  u_int32_t hash = (2166136261u ^ encoding) * 16777619u;
+  int i;
+
+  for (i = 0 ; i < raw_length ; i++)
+    hash = (hash ^ raw[i]) * 16777619u;
+
+  return hash;
+}
+
+static int pool_grow (struct string_pool *pool) {
+  struct pool_entry *entries;
+  int new_size = pool->size ? 2 * pool->size : 256;
+  int i, j;
+
+  entries = calloc (new_size, sizeof (struct pool_entry));
+  if (entries == NULL)
+    return -errno;
+
+  for (i = 0 ; i < pool->size ; i++) {
+    if (pool->entries[i].utf8 == NULL)
+      continue;
+
+    for (j = pool->entries[i].hash & (new_size - 1) ; entries[j].utf8 ; j = (j + 1) & (new_size - 1));
+
+    entries[j] = pool->entries[i];
+  }
+
+  if (pool->entries)
+    free (pool->entries);
+
+  pool->entries = entries;
+  pool->size    = new_size;
+
+  return 0;
+}
+
+/**
+  db_string_pool_enable:
+
+   Makes the song list functions (db_song_list, db_song_list_array,
+  db_song_list_sorted) intern their strings: identical values are converted
+  once and every song shares the same read-only buffer. The strings stay
+  valid until db_free is called on the database so song lists must not be
+  used after that. The pool keeps every distinct string it has seen (the
+  raw bytes of UTF-16 strings as well as the UTF-8 form) until then. Call this after the database has been loaded or created.
+
+  Arguments:
+   ipoddb_t *itunesdb - opened itunesdb
+
+  Returns:
+   < 0 on error
+     0 on success
+**/
+int db_string_pool_enable (ipoddb_t *itunesdb) {
+  if (itunesdb == NULL)
+    return -EINVAL;
+
+  if (itunesdb->string_pool == NULL &&
+      (itunesdb->string_pool = db_string_pool_create ()) == NULL)
+    return -errno;
+
+  return 0;
+}
+
+/*
+  db_string_pool_create:
+
+  Returns a new empty string pool or NULL on error.
+*/
+struct string_pool *db_string_pool_create (void) {
+  return (struct string_pool *) calloc (1, sizeof (struct string_pool));
+}
+
+/*
+  db_string_pool_intern:
+
+  Returns the UTF-8 version of the raw string stored in encoding. encoding
+  may be NULL if raw is already UTF-8 and only needs to be terminated. The
+  first occurrence of a string is converted and stored; later occurrences
+  (same bytes in the same encoding) return the same buffer without being
+  converted again. The pool owns the returned buffer.
+
+  Returns:
+   NULL on error
+   pointer to the shared string on success
+*/
+u_int8_t *db_string_pool_intern (struct string_pool *pool, u_int8_t *raw, int raw_length,
+				 char *encoding) {
+  struct pool_entry *entry;
+  u_int32_t hash;
+  int i, length, pool_enc;
+
+  if (pool == NULL || raw == NULL || raw_length < 0)
+    return NULL;
+
+  /* keep the load factor below 3/4 */
+  if (4 * (pool->num_entries + 1) > 3 * pool->size && pool_grow (pool) < 0)
+    return NULL;
+
+  pool_enc = pool_encoding (encoding);
+  hash     = pool_hash (pool_enc, raw, raw_length);
+
+  for (i = hash & (pool->size - 1) ; pool->entries[i].utf8 ; i = (i + 1) & (pool->size - 1)) {
+    entry = &pool->entries[i];
+
+    if (entry->hash == hash && entry->encoding == pool_enc && entry->raw_length == raw_length &&
+	memcmp (entry->raw, raw, raw_length) == 0)
+      return entry->utf8;
+  }
+
+  /* not seen before. convert it */
+  entry = &pool->entries[i];
+
+  if (pool_enc == POOL_UTF8) {
+    /* already UTF-8 (see db_dohm_get_string) */
+    if ((entry->utf8 = (u_int8_t *) malloc (raw_length + 1)) == NULL)
+      return NULL;
+
+    memcpy (entry->utf8, raw, raw_length);
+    entry->utf8[raw_length] = '\0';
+    entry->raw = entry->utf8;
+  } else {
+    length = (int) libupod_to_utf8_buf (NULL, 0, raw, raw_length, encoding);
+
+    entry->raw  = (u_int8_t *) malloc (raw_length + 1);
+    entry->utf8 = (u_int8_t *) malloc (length + 1);
+    if (entry->raw == NULL || entry->utf8 == NULL) {
+      if (entry->raw) free (entry->raw);
+      if (entry->utf8) free (entry->utf8);
+
+      entry->raw = entry->utf8 = NULL;
+
+      return NULL;
+    }
+
+    memcpy (entry->raw, raw, raw_length);
+    libupod_to_utf8_buf (entry->utf8, length + 1, raw, raw_length, encoding);
+  }
+
+  entry->hash       = hash;
+  entry->encoding   = pool_enc;
+  entry->raw_length = raw_length;
+
+  pool->num_entries++;
+
+  return entry->utf8;
+}
+
+/*
+  db_string_pool_free:
+
+  Frees a string pool and every string in it.
+*/
+void db_string_pool_free (struct string_pool *pool) {
+  int i;
+
+  if (pool == NULL)
+    return;
+
+  for (i = 0 ; i < pool->size ; i++) {
+    if (pool->entries[i].utf8 == NULL)
+      continue;
+
+    if (pool->entries[i].raw != pool->entries[i].utf8)
+      free (pool->entries[i].raw);
+
+    free (pool->entries[i].utf8);
+  }
+
+  if (pool->entries)
+    free (pool->entries);
+
+  free (pool);
+}
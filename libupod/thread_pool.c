@@ -0,0 +1,134 @@
+/**
+ *   (c) 2007 Nathan Hjelm <hjelmn@users.sourceforge.net>
+ *   v0.1.0 thread_pool.c
+ *
+ *   Minimal worker pool used to run independent jobs (e.g. probing media files)
+ *   in parallel. Falls back to running jobs serially without pthreads.
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the Lesser GNU Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the Lesser GNU Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ **/
+
+#include "itunesdbi.h"
+
+#if defined(HAVE_LIBPTHREAD)
+#include <pthread.h>
+
+struct parallel_for {
+  pthread_mutex_t lock;
+
+  int next;
+  int count;
+
+  upod_work_fn func;
+  void *arg;
+};
+
+static void *parallel_for_worker (void *arg) {
+  struct parallel_for *work = (struct parallel_for *)arg;
+  int index;
+
+  while (1) {
+    pthread_mutex_lock (&work->lock);
+    index = work->next++;
+    pthread_mutex_unlock (&work->lock);
+
+    if (index >= work->count)
+      break;
+
+    work->func (work->arg, index);
+  }
+
+  return NULL;
+}
+#endif
+
+/*
+  upod_thread_count:
+
+  Returns the number of worker threads to use. A request of 0 (or less) means
+  one thread per online processor.
+*/
+int upod_thread_count (int requested) {
+  long online = 1;
+
+  if (requested > 0)
+    return requested;
+
+#if defined(_SC_NPROCESSORS_ONLN)
+  online = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+
+  return (online > 0) ? (int)online : 1;
+}
+
+/*
+  upod_parallel_for:
+
+  Calls func (arg, i) for every i in [0, count) using up to num_threads
+  threads. Jobs are handed out in increasing order but may complete in any
+  order so func must only touch state belonging to index i.
+
+  Returns:
+   < 0 on error
+     0 on success
+*/
+int upod_parallel_for (int num_threads, int count, upod_work_fn func, void *arg) {
+  int i;
+#if defined(HAVE_LIBPTHREAD)
+  struct parallel_for work;
+  pthread_t *threads;
+  int started;
+#endif
+
+  if (func == NULL || count < 0)
+    return -EINVAL;
+
+  if (num_threads > count)
+    num_threads = count;
+
+#if defined(HAVE_LIBPTHREAD)
+  if (num_threads > 1) {
+    threads = (pthread_t *) calloc (num_threads, sizeof (pthread_t));
+    if (threads == NULL)
+      return -errno;
+
+    pthread_mutex_init (&work.lock, NULL);
+    work.next  = 0;
+    work.count = count;
+    work.func  = func;
+    work.arg   = arg;
+
+    for (started = 0 ; started < num_threads - 1 ; started++)
+      if (pthread_create (&threads[started], NULL, parallel_for_worker, &work) != 0)
+	break;
+
+    /* the calling thread helps out (and finishes the work if no threads could be started) */
+    parallel_for_worker (&work);
+
+    for (i = 0 ; i < started ; i++)
+      pthread_join (threads[i], NULL);
+
+    pthread_mutex_destroy (&work.lock);
+    free (threads);
+
+    return 0;
+  }
+#endif
+
+  for (i = 0 ; i < count ; i++)
+    func (arg, i);
+
+  return 0;
+}
@@ -220,7 +220,7 @@ int tihm_db_fill (tree_node_t *tihm_header, tihm_t *tihm) {
   return 0;
 }
 
-int tihm_fill_from_file (tihm_t *tihm, char *path, char *ipod_path, int stars, int tihm_num) {
+int tihm_fill_from_file (tihm_t *tihm, char *path, char *ipod_path, int stars, int tihm_num, int flags) {
   int i;
   
   if (tihm == NULL)
@@ -228,23 +228,12 @@ int tihm_fill_from_file (tihm_t *tihm, char *path, char *ipod_path, int stars, i
 
   memset (tihm, 0, sizeof (tihm_t));
 
-  if (strncasecmp (path + (strlen(path) - 3), "mp3", 3) == 0) {
-    if (mp3_fill_tihm (path, tihm) < 0) {
-      tihm_free (tihm); /* structure may have been partially filled before error */
-      
-      return -1;
-    }
-  } else if ( (strncasecmp (path + (strlen(path) - 3), "m4a", 3) == 0)  ||
-	      (strncasecmp (path + (strlen(path) - 3), "m4p", 3) == 0)  ||
-	      (strncasecmp (path + (strlen(path) - 3), "m4v", 3) == 0)  ||
-	      (strncasecmp (path + (strlen(path) - 3), "aac", 3) == 0) ) {
-    if (mp4_fill_tihm (path, tihm) < 0) {
-      tihm_free (tihm); /* structure may have been partially filled before error */
+  /* the parser is chosen from the contents of the file */
+  if (media_fill_tihm (path, tihm, flags) < 0) {
+    tihm_free (tihm); /* structure may have been partially filled before error */
 
-      return -1;
-    }
-  } else
     return -1;
+  }
   
   dohm_add (tihm, (u_int8_t *)ipod_path, strlen(ipod_path), "UTF-8", IPOD_PATH);
 
@@ -298,7 +287,7 @@ int db_tihm_create (tree_node_t **entry, tihm_t *tihm, int flags) {
   return 0;
 }
 
-int db_tihm_fill (tree_node_t *tihm_header, tihm_t *tihm) {
+int db_tihm_fill (tree_node_t *tihm_header, tihm_t *tihm, struct string_pool *strings) {
   struct db_tihm *tihm_data;
   
   if (tihm_header == NULL || tihm == NULL)
@@ -341,7 +330,67 @@ int db_tihm_fill (tree_node_t *tihm_header, tihm_t *tihm) {
   tihm->has_artwork = (tihm_data->has_artwork != 0xffffffff) ? 1 : 0;
   tihm->artwork_id  = tihm_data->iihm_id;
   
-  db_dohm_fill (tihm_header, &(tihm->dohms));
+  db_dohm_fill (tihm_header, &(tihm->dohms), strings);
+  tihm->pooled_strings = (strings != NULL);
+
+  return 0;
+}
+
+/*
+  db_tihm_get_u32:
+
+  Reads a single numeric field (see enum track_fields) directly from a tihm
+  cell. The values match those db_tihm_fill would store in a tihm_t.
+*/
+u_int32_t db_tihm_get_u32 (tree_node_t *tihm_header, int field) {
+  struct db_tihm *tihm_data = (struct db_tihm *)tihm_header->data;
+
+  switch (field) {
+  case TRACK_ID:
+    return tihm_data->identifier;
+  case TRACK_TYPE:
+    return tihm_data->type;
+  case TRACK_BITRATE:
+    return tihm_data->bit_rate;
+  case TRACK_SAMPLERATE:
+    return tihm_data->sample_rate >> 16;
+  case TRACK_SIZE:
+    return tihm_data->file_size;
+  case TRACK_TIME:
+    return tihm_data->duration;
+  case TRACK_NUMBER:
+    return tihm_data->order;
+  case TRACK_ALBUM_TRACKS:
+    return tihm_data->album_tracks;
+  case TRACK_DISK_NUM:
+    return tihm_data->disk_num;
+  case TRACK_DISK_TOTAL:
+    return tihm_data->disk_total;
+  case TRACK_YEAR:
+    return tihm_data->year;
+  case TRACK_START_TIME:
+    return tihm_data->start_time;
+  case TRACK_STOP_TIME:
+    return tihm_data->stop_time;
+  case TRACK_VOLUME_ADJUSTMENT:
+    return tihm_data->volume_adjustment;
+  case TRACK_TIMES_PLAYED:
+    return tihm_data->num_played[0];
+  case TRACK_STARS:
+    return (tihm_data->flags >> 24) / 0x14;
+  case TRACK_BPM:
+    return tihm_data->unk1 >> 16;
+  case TRACK_PLAYED_DATE:
+    return DATE_TO_POSIX(tihm_data->last_played_date);
+  case TRACK_MOD_DATE:
+    return DATE_TO_POSIX(tihm_data->modification_date);
+  case TRACK_CREATION_DATE:
+    return DATE_TO_POSIX(tihm_data->creation_date);
+  case TRACK_RELEASE_DATE:
+    return DATE_TO_POSIX(tihm_data->release_date);
+  case TRACK_HAS_ARTWORK:
+    return (tihm_data->has_artwork != 0xffffffff) ? 1 : 0;
+  }
 
   return 0;
 }
@@ -349,7 +398,11 @@ int db_tihm_fill (tree_node_t *tihm_header, tihm_t *tihm) {
 /**
    db_song_modify:
 
-   Updates the song database entry tihm_num.
+   Updates the song database entry tihm_num. If tihm has any dohms they
+   replace the entry's dohms. The play counts, last played date and bookmark
+   are kept since they do not come from the file, as is the rating unless
+   tihm->stars is set. The new dohms are all made before anything is changed
+   so on error the entry is left as it was.
 
    Arguments:
     ipoddb_t *itunesdb - opened itunesdb
@@ -357,19 +410,67 @@ int db_tihm_fill (tree_node_t *tihm_header, tihm_t *tihm) {
     tihm_t     *tihm     - data to change
 
    Returns:
-    -1 on error
-     0 on success
+    -ENOENT if there is no entry tihm_num
+    < 0 on other errors (the entry is not changed)
+      0 on success
 **/
 int db_song_modify (ipoddb_t *itunesdb, int tihm_num, tihm_t *tihm) {
-  tree_node_t *tihm_header;
+  tree_node_t *tihm_header, *dohm_header, **new_dohms;
+  struct db_tihm *tihm_data, old_data;
+  int i, j, ret = 0;
+
+  if (itunesdb == NULL || tihm == NULL)
+    return -EINVAL;
 
   if (db_tihm_retrieve (itunesdb, &tihm_header, NULL, tihm_num) < 0)
-    return -1;
+    return -ENOENT;
+
+  tihm_data = (struct db_tihm *)tihm_header->data;
+  memcpy (&old_data, tihm_data, sizeof (struct db_tihm));
+
+  if (tihm->num_dohm) {
+    if ((new_dohms = (tree_node_t **) calloc (tihm->num_dohm, sizeof (tree_node_t *))) == NULL)
+      return -errno;
+
+    for (i = 0 ; i < tihm->num_dohm ; i++)
+      if ((ret = db_dohm_create (&new_dohms[i], tihm->dohms[i], 16, itunesdb->flags)) < 0)
+	break;
+
+    /* the new dohms go after the old ones until all of them are attached */
+    if (i < tihm->num_dohm || (ret = db_attach_many (tihm_header, new_dohms, tihm->num_dohm)) < 0) {
+      for (j = 0 ; j < i ; j++)
+	db_free_tree (new_dohms[j]);
+
+      free (new_dohms);
+
+      return ret;
+    }
+
+    free (new_dohms);
+
+    while (tihm_header->num_children > tihm->num_dohm) {
+      db_detach (tihm_header, 0, &dohm_header);
+      db_free_tree (dohm_header);
+    }
+  }
+
+  /* the rating and vbr bits are or'd in by tihm_db_fill */
+  tihm_data->flags &= ~(0xff000001);
 
   tihm_db_fill (tihm_header, tihm);
 
-  /* The database entry's size will not change so it is unnecessary to
-     update size fields for the parents. */
+  tihm_data->identifier = tihm_num;
+
+  if (tihm->num_dohm == 0)
+    tihm_data->num_dohm = old_data.num_dohm;
+
+  if (tihm->stars == 0)
+    tihm_data->flags |= old_data.flags & 0xff000000;
+
+  tihm_data->num_played[0]    = old_data.num_played[0];
+  tihm_data->num_played[1]    = old_data.num_played[1];
+  tihm_data->last_played_date = old_data.last_played_date;
+  tihm_data->bookmark_time    = old_data.bookmark_time;
 
   return 0;
 }
@@ -381,5 +482,8 @@ void tihm_free (tihm_t *tihm) {
   if (tihm->image_data)
     free (tihm->image_data);
 
-  dohm_free (tihm->dohms, tihm->num_dohm);
+  if (tihm->pooled_strings)
+    free (tihm->dohms);
+  else
+    dohm_free (tihm->dohms, tihm->num_dohm);
 }
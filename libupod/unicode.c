@@ -80,6 +80,10 @@ static int encoding_utf16 (char *encoding) {
   return (strncmp (encoding, "UTF-16", 6) == 0);
 }
 
+static int encoding_latin1 (char *encoding) {
+  return (strcmp (encoding, "ISO-8859-1") == 0);
+}
+
 static int encoding_equiv (char *encoding1, char *encoding2) {
   if (encoding_utf8 (encoding1) || encoding_ascii (encoding1)) {
     if (encoding_utf8 (encoding2) || encoding_ascii (encoding2))
@@ -101,6 +105,19 @@ void libupod_convstr (void **dst, size_t *dst_len, void *src, size_t src_len,
   dst_is_utf8  = encoding_equiv (dst_encoding, "UTF-8");
   dst_is_ascii = encoding_ascii (dst_encoding);
 
+  if (encoding_latin1 (src_encoding) && dst_is_utf8 && !dst_is_ascii) {
+    /* ISO-8859-1 to UTF-8. characters above 0x7f take two bytes */
+    length = (int) libupod_to_utf8_buf (NULL, 0, src, src_len, src_encoding);
+
+    if (dst_len)
+      *dst_len = length;
+
+    if ((*dst = calloc (length + 1, 1)) != NULL)
+      libupod_to_utf8_buf (*dst, length + 1, src, src_len, src_encoding);
+
+    return;
+  }
+
   if (encoding_equiv (src_encoding, dst_encoding)) {
     length = src_len;
   } else if (encoding_equiv (src_encoding, "UTF-8") && encoding_utf16 (dst_encoding)) {
@@ -182,6 +199,79 @@ void libupod_convstr (void **dst, size_t *dst_len, void *src, size_t src_len,
 }
 #endif
 
+/*
+  libupod_to_utf8_buf:
+
+  Converts a UTF-8/ASCII, ISO-8859-1 or UTF-16 string to UTF-8 directly into dst without
+  allocating memory or modifying src. At most dst_size - 1 bytes are written
+  (multi-byte characters are never split) and dst is always terminated.
+
+  Returns:
+   the length of the full converted string (like snprintf)
+*/
+size_t libupod_to_utf8_buf (u_int8_t *dst, size_t dst_size, void *src, size_t src_len,
+			    char *src_encoding) {
+  u_int8_t *src8 = (u_int8_t *)src;
+  u_int8_t encoded[3];
+  size_t i, length = 0;
+  int le, n, width;
+
+  if (!encoding_utf16 (src_encoding) && !encoding_latin1 (src_encoding)) {
+    for (i = 0 ; i < src_len && src8[i] != '\0' ; i++, length++)
+      if (length + 1 < dst_size)
+	dst[length] = src8[i];
+
+    if (dst_size && length >= dst_size) {
+      /* do not leave part of a multi-byte character at the end */
+      for (i = dst_size - 1 ; i > 0 && (src8[i] & 0xc0) == 0x80 ; i--);
+
+      dst[i] = '\0';
+
+      return length;
+    }
+  } else {
+    le    = (strcmp (src_encoding, "UTF-16LE") == 0);
+    width = encoding_latin1 (src_encoding) ? 1 : 2;
+
+    for (i = 0 ; i + width <= src_len ; i += width) {
+      /* read the code unit without touching the source. ISO-8859-1 maps
+	 straight to the first 256 code points */
+      u_int16_t c = (width == 1) ? src8[i] :
+	(le ? (src8[i] | (src8[i+1] << 8)) : ((src8[i] << 8) | src8[i+1]));
+
+      if (c == 0)
+	break;
+
+      if (c < 0x80) {
+	encoded[0] = c;
+	n = 1;
+      } else if (c < 0x800) {
+	encoded[0] = 0xc0 | (c >> 6);
+	encoded[1] = 0x80 | (c & 0x3f);
+	n = 2;
+      } else {
+	encoded[0] = 0xe0 | (c >> 12);
+	encoded[1] = 0x80 | ((c >> 6) & 0x3f);
+	encoded[2] = 0x80 | (c & 0x3f);
+	n = 3;
+      }
+
+      if (length + n < dst_size)
+	memcpy (&dst[length], encoded, n);
+      else if (dst_size)
+	/* stop filling once a character does not fit */
+	dst_size = length + 1;
+
+      length += n;
+    }
+  }
+
+  if (dst_size)
+    dst[(length < dst_size) ? length : dst_size - 1] = '\0';
+
+  return length;
+}
+
 /* 
    to_unicode_hack:
 
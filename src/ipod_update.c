@@ -38,6 +38,9 @@
 
 #define PACKAGE "upod"
 
+/* state of the files in the database after the last update */
+#define MANIFEST "iPod_Control/iTunes/upod_manifest"
+
 void usage (void);
 void version (void);
 
@@ -85,38 +88,105 @@ static u_int8_t *path_mac_unix (char *mac_path, char *ipod_prefix) {
   return path;
 }
 
-int dblist_cmp (void *data1, void *data2) {
-  return (strcmp ((char *)data1, (char *)data2) == 0) ? 1 : 0;
+/* the .hidden_songs entries that apply to the current folder. open addressing
+   on the path so every file can be looked up in constant time */
+struct hidden_set {
+  char **paths; /* NULL for an empty slot */
+  int size;     /* power of two */
+  int num_used; /* slots that are not empty (removed entries included) */
+};
+
+/* marks a slot whose entry was removed so later entries can still be found */
+static char hidden_removed[] = "";
+
+/* FNV-1a */
+static unsigned int hidden_hash (char *path) {
+  unsigned int hash = 2166136261u;
+
+  for ( ; *path ; path++)
+    hash = (hash ^ (unsigned char)*path) * 16777619u;
+
+  return hash;
 }
 
-db_list_t *db_list_delete_link (db_list_t *p, db_list_t *x) {
-  db_list_t *y;
-  for (y = db_list_first (p) ; y && y != x ; y = db_list_next (y));
+/* returns the slot of the hidden entry matching subpath or -1 */
+int hidden_find (struct hidden_set *hidden, char *subpath) {
+  int i;
+
+  if (hidden->size == 0)
+    return -1;
+
+  for (i = hidden_hash (subpath) & (hidden->size - 1) ; hidden->paths[i] ;
+       i = (i + 1) & (hidden->size - 1))
+    if (hidden->paths[i] != hidden_removed && strcmp (hidden->paths[i], subpath) == 0)
+      return i;
+
+  return -1;
+}
+
+/* adds path (the set takes it over). removed slots are dropped when the set grows */
+int hidden_add (struct hidden_set *hidden, char *path) {
+  char **paths, **old_paths = hidden->paths;
+  int i, j, new_size, old_size = hidden->size;
+
+  if (hidden_find (hidden, path) >= 0) {
+    free (path);
+    return 0;
+  }
+
+  /* keep the load factor below 3/4 */
+  if (4 * (hidden->num_used + 1) > 3 * hidden->size) {
+    new_size = hidden->size ? 2 * hidden->size : 64;
+
+    if ((paths = (char **) calloc (new_size, sizeof (char *))) == NULL) {
+      free (path);
+      return -errno;
+    }
 
-  if (!y)
-    return p;
+    hidden->paths    = paths;
+    hidden->size     = new_size;
+    hidden->num_used = 0;
 
-  if (y->prev)
-    y->prev->next = y->next;
-  else
-    p = y->next;
+    for (i = 0 ; i < old_size ; i++) {
+      if (old_paths[i] == NULL || old_paths[i] == hidden_removed)
+	continue;
 
-  if (y->next)
-    y->next->prev = y->prev;
+      for (j = hidden_hash (old_paths[i]) & (new_size - 1) ; paths[j] ; j = (j + 1) & (new_size - 1));
 
-  free (y);
-  return p;
+      paths[j] = old_paths[i];
+      hidden->num_used++;
+    }
+
+    if (old_paths)
+      free (old_paths);
+  }
+
+  for (i = hidden_hash (path) & (hidden->size - 1) ; hidden->paths[i] ; i = (i + 1) & (hidden->size - 1));
+
+  hidden->paths[i] = path;
+  hidden->num_used++;
+
+  return 0;
 }
 
-db_list_t *db_list_find_custom (db_list_t *p, void *data, int (*compf)(void *, void *)) {
-  db_list_t *y;
+void hidden_remove (struct hidden_set *hidden, int i) {
+  free (hidden->paths[i]);
 
-  for (y = db_list_first (p) ; y ; y = db_list_next (y)) {
-    if (compf (y->data, data))
-      return y;
+  hidden->paths[i] = hidden_removed;
+}
+
+/* frees every entry. the set can be reused */
+void hidden_clear (struct hidden_set *hidden) {
+  int i;
+
+  for (i = 0 ; i < hidden->size ; i++) {
+    if (hidden->paths[i] && hidden->paths[i] != hidden_removed)
+      free (hidden->paths[i]);
+
+    hidden->paths[i] = NULL;
   }
 
-  return NULL;
+  hidden->num_used = 0;
 }
 
 void print_parsed (void) {
@@ -129,47 +199,350 @@ void print_parsed (void) {
   fflush (stdout);
 }
 
-int parse_dir (char *path, char *ipod_prefix, ipoddb_t *itunesdb, ipoddb_t *artworkdb, ipoddb_t *shuffledb,
-	       db_list_t *hidden, int playlist, int ipod_shuffle) {
+/*
+  itdbupdate works in two stages. The first walks the Music folder and
+  records everything a serial update would do (in the same order) as a list
+  of items. The second goes through the items a window at a time: the new
+  and changed files in the window are probed in parallel, then the window
+  is applied to the database from a single thread so the result does not
+  depend on the number of threads. Only one window of probed tracks (and
+  their artwork) is held at a time.
+
+  The size, modification time and inode of every file in the database are
+  saved in a manifest next to the iTunesDB. Files that have not changed
+  since the last update are neither probed nor looked up in the database.
+*/
+/* most files probed (and held) at once by update_database */
+#define UPDATE_WINDOW 256
+
+enum file_state {
+  FILE_NEW,       /* probe and add */
+  FILE_CHANGED,   /* probe and update the track */
+  FILE_UNCHANGED  /* nothing to probe */
+};
+
+enum update_item_type {
+  ITEM_PLAYLIST,      /* start of a folder in the Music folder */
+  ITEM_PLAYLIST_END,
+  ITEM_DIR,           /* start of a folder */
+  ITEM_DIR_END,
+  ITEM_HIDDEN,        /* a line of a .hidden_songs file */
+  ITEM_FILE
+};
+
+struct manifest_entry {
+  char *mac_path;
+
+  u_int64_t size;
+  u_int64_t mtime;
+  u_int64_t inode;
+
+  int tihm_num; /* -1 if the file could not be added */
+  int hidden;
+
+  int seen; /* the file was found by the walk */
+};
+
+struct manifest {
+  struct manifest_entry *entries;
+  int num_entries;
+};
+
+struct update_item {
+  int type;
+
+  /* path of the file or folder, playlist name, or hidden path */
+  char *path;
+
+  /* ITEM_PLAYLIST: create a playlist for the folder
+     ITEM_FILE: index of the file in the probe arrays
+     ITEM_DIR_END: index of the matching ITEM_DIR */
+  int index;
+
+  /* ITEM_FILE: index of the containing ITEM_DIR
+     ITEM_DIR: number of songs added */
+  int dir;
+
+  /* ITEM_DIR: number of songs updated */
+  int updated;
+
+  /* the remaining fields are only used by ITEM_FILE */
+  char *subpath; /* last two components of path */
+
+  u_int64_t size;
+  u_int64_t mtime;
+  u_int64_t inode;
+
+  /* manifest entry of the file (NULL if the file is new) */
+  struct manifest_entry *known;
+  int state;
+
+  /* state of the file after the update (saved in the new manifest) */
+  int tihm_num;
+  int hidden;
+};
+
+struct update_walk {
+  db_array_t items;
+
+  /* all files found */
+  db_array_t paths;
+  db_array_t mac_paths;
+};
+
+static int manifest_entry_compare (const void *a, const void *b) {
+  return strcmp (((const struct manifest_entry *)a)->mac_path, ((const struct manifest_entry *)b)->mac_path);
+}
+
+static struct manifest_entry *manifest_lookup (struct manifest *manifest, char *mac_path) {
+  struct manifest_entry key;
+
+  if (manifest->num_entries == 0)
+    return NULL;
+
+  key.mac_path = mac_path;
+
+  return bsearch (&key, manifest->entries, manifest->num_entries, sizeof (struct manifest_entry),
+		  manifest_entry_compare);
+}
+
+void manifest_free (struct manifest *manifest) {
+  int i;
+
+  for (i = 0 ; i < manifest->num_entries ; i++)
+    free (manifest->entries[i].mac_path);
+
+  if (manifest->entries)
+    free (manifest->entries);
+
+  memset (manifest, 0, sizeof (struct manifest));
+}
+
+/*
+  manifest_load:
+
+  Reads the manifest written by the last update. The manifest is ignored if
+  the iTunesDB at db_path was changed since the manifest was written (by
+  another program) since the track numbers may no longer be valid.
+
+  Returns:
+   < 0 if the manifest could not be used
+     0 on success
+*/
+int manifest_load (struct manifest *manifest, char *path, char *db_path) {
+  char line[2048];
+  unsigned long long size, mtime, inode;
+  struct stat statinfo;
+  int tihm_num, hidden, length, offset;
+  FILE *fh;
+
+  memset (manifest, 0, sizeof (struct manifest));
+
+  if ((fh = fopen (path, "r")) == NULL)
+    return -errno;
+
+  if (stat (db_path, &statinfo) < 0 || fgets (line, sizeof (line), fh) == NULL ||
+      sscanf (line, "upod manifest 1 %llu %llu", &size, &mtime) != 2 ||
+      size != (u_int64_t)statinfo.st_size || mtime != (u_int64_t)statinfo.st_mtime) {
+    fclose (fh);
+
+    return -1;
+  }
+
+  while (fgets (line, sizeof (line), fh) != NULL) {
+    struct manifest_entry *entries;
+
+    length = strlen (line);
+    if (length && line[length - 1] == '\n')
+      line[--length] = '\0';
+
+    if (sscanf (line, "%llu %llu %llu %i %i %n", &size, &mtime, &inode, &tihm_num, &hidden, &offset) != 5 ||
+	offset >= length)
+      continue;
+
+    if ((manifest->num_entries & 1023) == 0) {
+      entries = realloc (manifest->entries, (manifest->num_entries + 1024) * sizeof (struct manifest_entry));
+      if (entries == NULL)
+	break;
+
+      manifest->entries = entries;
+    }
+
+    manifest->entries[manifest->num_entries].mac_path = strdup (line + offset);
+    manifest->entries[manifest->num_entries].size     = size;
+    manifest->entries[manifest->num_entries].mtime    = mtime;
+    manifest->entries[manifest->num_entries].inode    = inode;
+    manifest->entries[manifest->num_entries].tihm_num = tihm_num;
+    manifest->entries[manifest->num_entries].hidden   = hidden;
+    manifest->entries[manifest->num_entries].seen     = 0;
+    manifest->num_entries++;
+  }
+
+  fclose (fh);
+
+  qsort (manifest->entries, manifest->num_entries, sizeof (struct manifest_entry), manifest_entry_compare);
+
+  return 0;
+}
+
+/*
+  manifest_write:
+
+  Saves the state of every file in the database after the update. Must be
+  called after the iTunesDB at db_path has been written.
+*/
+int manifest_write (struct update_walk *walk, char *path, char *db_path) {
+  struct stat statinfo;
+  char *tmp_path;
+  FILE *fh;
+  int i;
+
+  if (stat (db_path, &statinfo) < 0)
+    return -errno;
+
+  if ((tmp_path = calloc (1, strlen (path) + 5)) == NULL)
+    return -ENOMEM;
+
+  sprintf (tmp_path, "%s.tmp", path);
+
+  if ((fh = fopen (tmp_path, "w")) == NULL) {
+    perror (tmp_path);
+    free (tmp_path);
+
+    return -errno;
+  }
+
+  fprintf (fh, "upod manifest 1 %llu %llu\n", (unsigned long long)statinfo.st_size,
+	   (unsigned long long)statinfo.st_mtime);
+
+  for (i = 0 ; i < walk->items.num_entries ; i++) {
+    struct update_item *item = (struct update_item *)db_array_index (&walk->items, i);
+
+    if (item->type != ITEM_FILE)
+      continue;
+
+    /* files that could not be added are saved so they are not probed again until they change */
+    fprintf (fh, "%llu %llu %llu %i %i %s\n", (unsigned long long)item->size,
+	     (unsigned long long)item->mtime, (unsigned long long)item->inode, item->tihm_num,
+	     item->hidden, (char *)db_array_index (&walk->mac_paths, item->index));
+  }
+
+  if (fclose (fh) != 0 || rename (tmp_path, path) < 0) {
+    perror (path);
+    unlink (tmp_path);
+    free (tmp_path);
+
+    return -1;
+  }
+
+  free (tmp_path);
+
+  return 0;
+}
+
+/* matches the files found by the walk with the manifest of the last update */
+void manifest_compare (struct update_walk *walk, struct manifest *manifest) {
+  int i;
+
+  for (i = 0 ; i < walk->items.num_entries ; i++) {
+    struct update_item *item = (struct update_item *)db_array_index (&walk->items, i);
+
+    if (item->type != ITEM_FILE)
+      continue;
+
+    item->known = manifest_lookup (manifest, (char *)db_array_index (&walk->mac_paths, item->index));
+
+    if (item->known) {
+      item->known->seen = 1;
+
+      if (item->known->size != item->size || item->known->mtime != item->mtime ||
+	  item->known->inode != item->inode)
+	item->state = (item->known->tihm_num >= 0) ? FILE_CHANGED : FILE_NEW;
+      else
+	item->state = FILE_UNCHANGED;
+    }
+  }
+}
+
+static struct update_item *update_item_append (struct update_walk *walk, int type, char *path, int index) {
+  struct update_item *item;
+
+  item = (struct update_item *) calloc (1, sizeof (struct update_item));
+  if (item == NULL)
+    return NULL;
+
+  item->type     = type;
+  item->path     = path ? strdup (path) : NULL;
+  item->index    = index;
+  item->tihm_num = -1;
+
+  if (db_array_append (&walk->items, item) < 0) {
+    free (item->path);
+    free (item);
+
+    return NULL;
+  }
+
+  return item;
+}
+
+void update_walk_free (struct update_walk *walk) {
+  int i;
+
+  for (i = 0 ; i < walk->items.num_entries ; i++) {
+    struct update_item *item = (struct update_item *)db_array_index (&walk->items, i);
+
+    free (item->path);
+    free (item);
+  }
+
+  for (i = 0 ; i < walk->mac_paths.num_entries ; i++)
+    free (db_array_index (&walk->mac_paths, i));
+
+  db_array_free (&walk->items);
+  db_array_free (&walk->paths);
+  db_array_free (&walk->mac_paths);
+}
+
+int walk_dir (char *path, char *ipod_prefix, struct update_walk *walk) {
   char scratch[1024];
 
   DIR *dirp;
   FILE *fh;
   struct dirent *dirent;
   struct stat statinfo;
-  int tihm_num, i;
-  int songs_added = 0;
-
-  char *subpath;
+  struct update_item *item;
+  int i, dir_index;
 
   dirp = opendir (path);
 
   if (dirp == NULL)
     return 0;
 
+  dir_index = walk->items.num_entries;
+  update_item_append (walk, ITEM_DIR, NULL, 0);
+
   sprintf (scratch, "%s/.hidden_songs", path);
   if (stat (scratch, &statinfo) == 0) {
     fh = fopen (scratch, "r");
     if (fh == NULL) {
       perror (scratch);
+      closedir (dirp);
 
       return -errno;
     }
 
     while (fgets (scratch, 1024, fh) > 0) {
-      char *tmp;
-
       if (scratch[strlen(scratch) - 1] == '\n')
 	scratch[strlen(scratch) - 1] = '\0';
 
-      tmp = strdup (scratch);
-
-      hidden = db_list_append (hidden, tmp);
+      update_item_append (walk, ITEM_HIDDEN, scratch, 0);
     }
+
+    fclose (fh);
   }
 
   while ((dirent = readdir (dirp)) != NULL) {
-    char *mac_path;
     int slashs = 0;
 
     if (dirent->d_name[0] == '.')
@@ -187,62 +560,34 @@ int parse_dir (char *path, char *ipod_prefix, ipoddb_t *itunesdb, ipoddb_t *artw
       }
     }
 
-    subpath = &scratch[i];
-
     if (stat (scratch, &statinfo) < 0)
       continue;
 
     if (!S_ISDIR (statinfo.st_mode)) {
-      db_list_t *tmp;
-
-      print_parsed ();
-      mac_path = path_unix_mac_root (scratch + strlen(ipod_prefix) + 1);
-
-      tihm_num = db_song_add (itunesdb, artworkdb, scratch, mac_path, 0, 1);
-
-      if ((tmp = db_list_find_custom (hidden, subpath, dblist_cmp)) != NULL) {
-	/* song appears in a .hidden_songs file. remove the song from the main playlist */
-	if (tihm_num < 0 && ((tihm_num = db_lookup (itunesdb, IPOD_PATH, mac_path)) >= 0)) {
-	  db_song_hide (itunesdb, tihm_num);
-	  tihm_num = -1;
-	} else
-	  db_song_hide (itunesdb, tihm_num);
-	
-	free (tmp->data);
-	hidden = db_list_delete_link (hidden, tmp);
-      } else {
-	if (tihm_num < 0 && ((tihm_num = db_lookup (itunesdb, IPOD_PATH, mac_path)) >= 0)) {
-	  db_song_unhide (itunesdb, tihm_num);
-	  tihm_num = -1;
-	}
-      }
-      
-      free (mac_path);
-
-      if (shuffledb)
-	tihm_num = sd_song_add (shuffledb, scratch + 1, 0, 0, 0);
-      
-
-      if (tihm_num >= 0) {
-	if (playlist != -1)
-	  db_playlist_tihm_add (itunesdb, playlist, 2, tihm_num);
-	
-	songs_added++;
-      }
+      item = update_item_append (walk, ITEM_FILE, scratch, walk->paths.num_entries);
+      if (item == NULL)
+	continue;
+
+      item->subpath = item->path + i;
+      item->dir     = dir_index;
+      item->size    = statinfo.st_size;
+      item->mtime   = statinfo.st_mtime;
+      item->inode   = statinfo.st_ino;
+
+      db_array_append (&walk->paths, item->path);
+      db_array_append (&walk->mac_paths, path_unix_mac_root (scratch + strlen(ipod_prefix) + 1));
     } else
-      parse_dir (scratch, ipod_prefix, itunesdb, artworkdb, shuffledb, hidden, playlist, ipod_shuffle);
+      walk_dir (scratch, ipod_prefix, walk);
   }
 
   closedir (dirp);
 
-  if (songs_added)
-    printf ("Added %s: %i songs\n", path, songs_added);
+  update_item_append (walk, ITEM_DIR_END, path, dir_index);
 
   return 0;
 }
 
-int parse_playlists (char *path, char *ipod_prefix, ipoddb_t *itunesdb, ipoddb_t *artworkdb,
-		     ipoddb_t *shuffledb, int ipod_shuffle) {
+int walk_playlists (char *path, char *ipod_prefix, struct update_walk *walk, int ipod_shuffle) {
   char scratch[1024];
 
   DIR *dirp;
@@ -256,7 +601,7 @@ int parse_playlists (char *path, char *ipod_prefix, ipoddb_t *itunesdb, ipoddb_t
   }
 
   while ((dirent = readdir (dirp)) != NULL) {
-    int playlist = -1;
+    int playlist = 0;
 
     if (dirent->d_name[0] == '.')
       continue;
@@ -266,20 +611,13 @@ int parse_playlists (char *path, char *ipod_prefix, ipoddb_t *itunesdb, ipoddb_t
     if (stat (scratch, &statinfo) < 0)
       continue;
 
-    if (ipod_shuffle == 0) {
-      if (S_ISDIR (statinfo.st_mode) && 
-	  strcasecmp(dirent->d_name, "main_playlist")) {
-	playlist = db_lookup_playlist (itunesdb, dirent->d_name);
-	
-	if (playlist < 0) {
-	  printf ("Creating playlist: %s\n", dirent->d_name);
-	  playlist = db_playlist_create (itunesdb, dirent->d_name, 2);
-	}
-      }
-    }
+    if (ipod_shuffle == 0 && S_ISDIR (statinfo.st_mode) &&
+	strcasecmp(dirent->d_name, "main_playlist"))
+      playlist = 1;
 
-    parse_dir (scratch, ipod_prefix, itunesdb, artworkdb, shuffledb, NULL, playlist, ipod_shuffle);
-    printf ("\n");
+    update_item_append (walk, ITEM_PLAYLIST, dirent->d_name, playlist);
+    walk_dir (scratch, ipod_prefix, walk);
+    update_item_append (walk, ITEM_PLAYLIST_END, NULL, 0);
   }
   
   closedir (dirp);
@@ -287,6 +625,260 @@ int parse_playlists (char *path, char *ipod_prefix, ipoddb_t *itunesdb, ipoddb_t
   return 0;
 }
 
+/* the item is a new or changed file */
+static int item_needs_probe (struct update_item *item) {
+  return item->type == ITEM_FILE && item->state != FILE_UNCHANGED;
+}
+
+/*
+  probe_files:
+
+  Probes the files in items first to last - 1 that are in state (FILE_NEW or
+  FILE_CHANGED). The results of the n-th file in the range that needs
+  probing (see item_needs_probe) are stored in tihms[n]/results[n].
+*/
+static int probe_files (ipoddb_t *itunesdb, struct update_walk *walk, int first, int last, int state,
+			tihm_t *tihms, int *results) {
+  char **paths, **mac_paths;
+  tihm_t *probed_tihms;
+  int *files, *probed_results;
+  int i, num_files = 0, slot = 0, ret = 0;
+
+  paths          = (char **) calloc (UPDATE_WINDOW, sizeof (char *));
+  mac_paths      = (char **) calloc (UPDATE_WINDOW, sizeof (char *));
+  files          = (int *) calloc (UPDATE_WINDOW, sizeof (int));
+  probed_tihms   = (tihm_t *) calloc (UPDATE_WINDOW, sizeof (tihm_t));
+  probed_results = (int *) calloc (UPDATE_WINDOW, sizeof (int));
+
+  if (paths == NULL || mac_paths == NULL || files == NULL || probed_tihms == NULL || probed_results == NULL) {
+    ret = -errno;
+    goto done;
+  }
+
+  for (i = first ; i < last ; i++) {
+    struct update_item *item = (struct update_item *)db_array_index (&walk->items, i);
+
+    if (!item_needs_probe (item))
+      continue;
+
+    if (item->state == state) {
+      paths[num_files]     = (char *)db_array_index (&walk->paths, item->index);
+      mac_paths[num_files] = (char *)db_array_index (&walk->mac_paths, item->index);
+      files[num_files++]   = slot;
+    }
+
+    slot++;
+  }
+
+  if (num_files == 0)
+    goto done;
+
+  if ((ret = db_song_probe_batch (itunesdb, paths, mac_paths, num_files,
+				  (state == FILE_CHANGED) ? PROBE_EXISTING : 0,
+				  probed_tihms, probed_results)) < 0)
+    goto done;
+
+  for (i = 0 ; i < num_files ; i++) {
+    tihms[files[i]]   = probed_tihms[i];
+    results[files[i]] = probed_results[i];
+  }
+
+ done:
+  if (paths) free (paths);
+  if (mac_paths) free (mac_paths);
+  if (files) free (files);
+  if (probed_tihms) free (probed_tihms);
+  if (probed_results) free (probed_results);
+
+  return ret;
+}
+
+/* adds (or updates) a probed file in the database (and the current playlist) */
+static void apply_file (struct update_walk *walk, struct update_item *item, tihm_t *tihm, int probed,
+			ipoddb_t *itunesdb, ipoddb_t *artworkdb, ipoddb_t *shuffledb,
+			struct hidden_set *hidden, int playlist) {
+  char *mac_path = (char *)db_array_index (&walk->mac_paths, item->index);
+  struct update_item *dir_item = (struct update_item *)db_array_index (&walk->items, item->dir);
+  int tihm_num = -1, existing = -1, hidden_index, ret;
+
+  print_parsed ();
+
+  if (item->known)
+    existing = item->known->tihm_num;
+
+  if (probed && item->state == FILE_CHANGED) {
+    /* the file changed since the last update. update the track in place. the track
+       must not refer to artwork that could not be queued */
+    if (artworkdb && tihm->image_data &&
+	db_photo_queue (artworkdb, tihm->image_data, tihm->image_size, tihm->artwork_id) < 0) {
+      tihm->has_artwork = 0;
+      tihm->artwork_id  = 0;
+    }
+
+    ret = db_song_modify (itunesdb, existing, tihm);
+
+    if (ret == -ENOENT) {
+      /* the track is no longer in the database. add it again */
+      existing = -1;
+      tihm_num = db_song_add_probed (itunesdb, artworkdb, tihm, 1);
+    } else {
+      if (ret == 0)
+	dir_item->updated++;
+      else {
+	/* the track was left as it was. forget the file's mtime so it is probed again next time */
+	fprintf (stderr, "Could not update %s: %s\n", item->path, strerror (-ret));
+	item->mtime = 0;
+      }
+
+      tihm_free (tihm);
+    }
+  } else if (probed)
+    tihm_num = db_song_add_probed (itunesdb, artworkdb, tihm, 1);
+
+  /* the manifest says whether a known file is in the database */
+  if (tihm_num < 0 && item->known == NULL)
+    existing = db_lookup (itunesdb, IPOD_PATH, mac_path);
+
+  /* hiding (or unhiding) a song that was already hidden (or shown) by the last
+     update does not change anything */
+  if ((hidden_index = hidden_find (hidden, item->subpath)) >= 0) {
+    /* song appears in a .hidden_songs file. remove the song from the main playlist */
+    if (tihm_num < 0 && existing >= 0) {
+      if (item->known == NULL || !item->known->hidden)
+	db_song_hide (itunesdb, existing);
+      tihm_num = -1;
+    } else
+      db_song_hide (itunesdb, tihm_num);
+    
+    hidden_remove (hidden, hidden_index);
+  } else {
+    if (tihm_num < 0 && existing >= 0) {
+      if (item->known == NULL || item->known->hidden)
+	db_song_unhide (itunesdb, existing);
+      tihm_num = -1;
+    }
+  }
+
+  item->tihm_num = (tihm_num >= 0) ? tihm_num : existing;
+  item->hidden   = (hidden_index >= 0);
+  
+  if (shuffledb)
+    tihm_num = sd_song_add (shuffledb, item->path + 1, 0, 0, 0);
+  
+  if (tihm_num >= 0) {
+    if (playlist != -1)
+      db_playlist_tihm_add (itunesdb, playlist, 2, tihm_num);
+    
+    dir_item->dir++;
+  }
+}
+
+/*
+  update_database:
+
+  Probes the new and changed files found by walk_playlists and applies the
+  results to the database in the order the files were found. The items are
+  handled in windows of at most UPDATE_WINDOW files to probe.
+*/
+int update_database (struct update_walk *walk, ipoddb_t *itunesdb, ipoddb_t *artworkdb,
+		     ipoddb_t *shuffledb) {
+  struct hidden_set hidden;
+  tihm_t *tihms;
+  int *results;
+  int playlist = -1;
+  int i, first, last, slot, num_probed = 0, ret = 0;
+
+  memset (&hidden, 0, sizeof (hidden));
+
+  tihms   = (tihm_t *) calloc (UPDATE_WINDOW, sizeof (tihm_t));
+  results = (int *) calloc (UPDATE_WINDOW, sizeof (int));
+
+  if (tihms == NULL || results == NULL) {
+    ret = -errno;
+    goto done;
+  }
+
+  for (first = 0 ; first < walk->items.num_entries ; first = last) {
+    for (last = first, num_probed = 0 ; last < walk->items.num_entries && num_probed < UPDATE_WINDOW ; last++)
+      if (item_needs_probe ((struct update_item *)db_array_index (&walk->items, last)))
+	num_probed++;
+
+    for (i = 0 ; i < num_probed ; i++)
+      results[i] = -1;
+
+    if ((ret = probe_files (itunesdb, walk, first, last, FILE_NEW, tihms, results)) < 0 ||
+	(ret = probe_files (itunesdb, walk, first, last, FILE_CHANGED, tihms, results)) < 0)
+      goto done;
+
+    for (i = first, slot = 0 ; i < last ; i++) {
+      struct update_item *item = (struct update_item *)db_array_index (&walk->items, i);
+      struct update_item *dir_item;
+
+      switch (item->type) {
+      case ITEM_PLAYLIST:
+	playlist = -1;
+
+	if (item->index) {
+	  playlist = db_lookup_playlist (itunesdb, item->path);
+	  
+	  if (playlist < 0) {
+	    printf ("Creating playlist: %s\n", item->path);
+	    playlist = db_playlist_create (itunesdb, item->path, 2);
+	  }
+	}
+
+	break;
+      case ITEM_PLAYLIST_END:
+	printf ("\n");
+
+	/* songs hidden anywhere under a folder only apply to that folder */
+	hidden_clear (&hidden);
+
+	break;
+      case ITEM_HIDDEN:
+	hidden_add (&hidden, item->path);
+	item->path = NULL;
+
+	break;
+      case ITEM_FILE:
+	if (item_needs_probe (item)) {
+	  apply_file (walk, item, &tihms[slot], results[slot] == 0, itunesdb, artworkdb, shuffledb,
+		      &hidden, playlist);
+	  results[slot++] = -1;
+	} else
+	  apply_file (walk, item, NULL, 0, itunesdb, artworkdb, shuffledb, &hidden, playlist);
+
+	break;
+      case ITEM_DIR_END:
+	dir_item = (struct update_item *)db_array_index (&walk->items, item->index);
+
+	if (dir_item->dir)
+	  printf ("Added %s: %i songs\n", item->path, dir_item->dir);
+	if (dir_item->updated)
+	  printf ("Updated %s: %i songs\n", item->path, dir_item->updated);
+
+	break;
+      }
+    }
+  }
+
+ done:
+  /* songs that were probed but not added */
+  for (i = 0 ; results && i < num_probed ; i++)
+    if (results[i] == 0)
+      tihm_free (&tihms[i]);
+
+  hidden_clear (&hidden);
+
+  if (hidden.paths)
+    free (hidden.paths);
+
+  if (tihms) free (tihms);
+  if (results) free (results);
+
+  return ret;
+}
+
 int write_itdatabase (ipoddb_t *itunesdb) {
   struct stat statinfo;
   int mode = S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;
@@ -350,22 +942,30 @@ int write_awdatabase (ipoddb_t *artworkdb) {
   return db_write (*artworkdb, ARTWORKDB);
 }
 
-/* remove files that no longer exist from the database */
-int cleanup_database (ipoddb_t *itunesdb, char *ipod_prefix) {
-  db_list_t *tmp, *song_list = NULL;
+/* remove files that no longer exist from the database. tracks whose files were found
+   by the walk (see manifest_compare) are not checked again */
+int cleanup_database (ipoddb_t *itunesdb, char *ipod_prefix, struct manifest *manifest) {
+  struct manifest_entry *entry;
+  db_array_t song_list;
   tihm_t *tihm;
   char *unix_path;
-  int i;
+  u_int32_t *missing = NULL;
+  int num_missing = 0;
+  int i, j;
 
   struct stat statinfo;
 
-  db_song_list (itunesdb, &song_list);
+  if (db_song_list_array (itunesdb, &song_list) < 0)
+    return -1;
 
-  if (song_list == NULL)
+  missing = calloc (song_list.num_entries + 1, sizeof (u_int32_t));
+  if (missing == NULL) {
+    db_song_list_array_free (&song_list);
     return -1;
+  }
 
-  for (tmp = db_list_first (song_list) ; tmp ; tmp = db_list_next (tmp)) {
-    tihm = (tihm_t *)tmp->data;
+  for (j = 0 ; j < song_list.num_entries ; j++) {
+    tihm = (tihm_t *)db_array_index (&song_list, j);
 
     for (i = 0 ; i < tihm->num_dohm ; i++)
       if (tihm->dohms[i].type == IPOD_PATH)
@@ -373,17 +973,27 @@ int cleanup_database (ipoddb_t *itunesdb, char *ipod_prefix) {
     if (i == tihm->num_dohm)
       continue;
 
+    entry = manifest_lookup (manifest, (char *)tihm->dohms[i].data);
+    if (entry && entry->seen && entry->tihm_num == tihm->num)
+      continue;
+
     unix_path = path_mac_unix (tihm->dohms[i].data, ipod_prefix);
 
     if (stat (unix_path, &statinfo) < 0) {
       printf ("%s(%s): no longer exists. Removing from the iTunesDB\n", unix_path, tihm->dohms[i].data);
-      db_song_remove (itunesdb, tihm->num);
+      missing[num_missing++] = tihm->num;
     }
 
     free (unix_path);
   }
 
-  db_song_list_free (&song_list);
+  db_song_list_array_free (&song_list);
+
+  /* remove all the missing songs at once */
+  if (num_missing)
+    db_song_remove_many (itunesdb, missing, num_missing);
+
+  free (missing);
 
   return 0;
 }
@@ -401,10 +1011,17 @@ int main (int argc, char *argv[]) {
   char *itunesdb_path;
   char *itunessd_path;
   char *artworkdb_path;
+  char *manifest_path;
   char *music_path;
 
+  struct update_walk walk;
+  struct manifest manifest;
+
   int ret;
   int ipod_shuffle = 0;
+  int num_threads = 0;
+  int rescan = 0;
+  int dither = 0;
 
   struct option long_options[] = {
     {"noartwork",     0, 0, 'n'},
@@ -416,9 +1033,14 @@ int main (int argc, char *argv[]) {
     {"version",       0, 0, 'v'},
     {"shuffle",       0, 0, 's'},
     {"prefix",        1, 0, 'p'},
+    {"exact",         0, 0, 'x'},
+    {"jobs",          1, 0, 'j'},
+    {"rescan",        0, 0, 'r'},
+    {"dither",        0, 0, 'D'},
+    {0, 0, 0, 0}
   };
 
-  while ((c = getopt_long (argc, argv, "?c:dtvp:", long_options,
+  while ((c = getopt_long (argc, argv, "?c:dtvp:xj:rD", long_options,
 			   &option_index)) != -1) {
     switch (c) {
     case 'a':
@@ -454,6 +1076,18 @@ int main (int argc, char *argv[]) {
     case 'v':
       version ();
       break;
+    case 'x':
+      flags |= FLAG_EXACT_DURATION;
+      break;
+    case 'j':
+      num_threads = atoi (optarg);
+      break;
+    case 'r':
+      rescan = 1;
+      break;
+    case 'D':
+      dither = 1;
+      break;
     case 's':
       ipod_shuffle = 1;
       noartwork = 1;
@@ -483,6 +1117,11 @@ int main (int argc, char *argv[]) {
   itunessd_path  = calloc (1, strlen (ITUNESSD) + strlen (ipod_prefix) + 2);
   sprintf (itunessd_path, "%s/%s", ipod_prefix, ITUNESSD);
 
+  manifest_path  = calloc (1, strlen (MANIFEST) + strlen (ipod_prefix) + 2);
+  sprintf (manifest_path, "%s/%s", ipod_prefix, MANIFEST);
+
+  memset (&manifest, 0, sizeof (manifest));
+
   if (noartwork == 0) {
     db_set_debug (&artworkdb, debug_level, stderr);
     artworkdb_path  = calloc (1, strlen (ARTWORKDB) + strlen (ipod_prefix) + 2);
@@ -496,7 +1135,10 @@ int main (int argc, char *argv[]) {
       exit (1);
     }
 
-    if (ipod_shuffle = 1) {
+    if (rescan == 0 && manifest_load (&manifest, manifest_path, itunesdb_path) < 0)
+      manifest_free (&manifest);
+
+    if (ipod_shuffle == 1) {
       if ((ret = sd_load (&shuffledb, itunessd_path, flags)) < 0) {
 	fprintf (stderr, "Could not open iTunesSD: %s\n", itunessd_path);
 	
@@ -547,19 +1189,47 @@ int main (int argc, char *argv[]) {
     }
   }
 
-  cleanup_database (&itunesdb, ipod_prefix);
+  itunesdb.num_threads  = num_threads;
+  artworkdb.num_threads = num_threads;
 
-  if (noartwork == 0)
-    artworkdb.supports_artwork = supports_artwork;
+  if (dither)
+    artworkdb.flags |= FLAG_DITHER_ARTWORK;
+
+  /* find every file in the Music folder and compare them with the last update */
+  memset (&walk, 0, sizeof (walk));
 
   music_path = calloc (1, strlen(ipod_prefix) + 20);
   sprintf (music_path, "%s/iPod_Control/Music", ipod_prefix);
-  parse_playlists (music_path, ipod_prefix, &itunesdb, (noartwork) ? NULL : &artworkdb,
-		   (ipod_shuffle == 0) ? NULL : &shuffledb, ipod_shuffle);
-  
+  walk_playlists (music_path, ipod_prefix, &walk, ipod_shuffle);
+  free (music_path);
+
+  manifest_compare (&walk, &manifest);
+
+  /* tree sizes are updated once when the batch is committed and the indices
+     once when the database is written */
+  db_begin_batch (&itunesdb);
+
+  cleanup_database (&itunesdb, ipod_prefix, &manifest);
+
+  if (noartwork == 0)
+    artworkdb.supports_artwork = supports_artwork;
+
+  update_database (&walk, &itunesdb, (noartwork) ? NULL : &artworkdb,
+		   (ipod_shuffle == 0) ? NULL : &shuffledb);
+
+  db_commit_batch (&itunesdb);
+
   ret = write_itdatabase (&itunesdb);
   printf ("%i B written to the iTunesDB: %s\n", ret, itunesdb.path);
 
+  /* without a matching manifest the next update checks every file */
+  if (ret < 0 || manifest_write (&walk, manifest_path, itunesdb.path) < 0)
+    unlink (manifest_path);
+
+  update_walk_free (&walk);
+  manifest_free (&manifest);
+  free (manifest_path);
+
   if (ipod_shuffle == 1) {
     ret = write_itsd (&shuffledb);
     printf ("%i B written to the iTunesSD: %s\n", ret, shuffledb.path);
@@ -593,6 +1263,12 @@ void usage (void) {
   printf ("  -d, --debug           increase debuging verbosity\n");
   printf ("  -t, --itunes_compat   turn on itunes compatability for files\n"
 	  "                        with non-ASCII characters in their name\n");
+  printf ("  -x, --exact           count every mp3 frame for exact durations\n");
+  printf ("  -j, --jobs=<n>        number of files to read (or covers to render) at once\n"
+	  "                        (default: one per processor)\n");
+  printf ("  -r, --rescan          check every file instead of only files that\n"
+	  "                        changed since the last update\n");
+  printf ("  -D, --dither          dither artwork thumbnails\n");
   printf ("  -?, --help            print this screen\n");
   printf ("  -v, --version         print version\n");
 
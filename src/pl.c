@@ -95,16 +95,27 @@ int main(int argc, char *argv[]) {
     if (db_playlist_clear (&itunesdb, strtol(argv[3], NULL, 10), 2) == 0) {
       db_write (itunesdb, argv[1]);
     }
-  } else if (add) {
-    for (i = 4 ; i < argc ; i++)
-      db_playlist_tihm_add (&itunesdb, strtol(argv[3], NULL, 10), 2, strtol(argv[i], NULL, 10));
+  } else if (add || remove) {
+    int *tihm_nums = calloc (argc, sizeof (int));
+
+    if (tihm_nums == NULL) {
+      printf("Could not allocate memory.\n");
+      db_free(&itunesdb);
+      exit(2);
+    }
 
-    db_write (itunesdb, argv[1]);
-  } else if (remove) {
     for (i = 4 ; i < argc ; i++)
-      db_playlist_tihm_remove (&itunesdb, strtol(argv[3], NULL, 10), 2, strtol(argv[i], NULL, 10));
+      tihm_nums[i - 4] = strtol(argv[i], NULL, 10);
 
-    db_write (itunesdb, argv[1]);
+    if (add)
+      ret = db_playlist_tihm_add_many (&itunesdb, strtol(argv[3], NULL, 10), 2, tihm_nums, argc - 4);
+    else
+      ret = db_playlist_tihm_remove_many (&itunesdb, strtol(argv[3], NULL, 10), 2, tihm_nums, argc - 4);
+
+    free (tihm_nums);
+
+    if (ret >= 0)
+      db_write (itunesdb, argv[1]);
   } else {
     if ((ret = db_playlist_song_list (&itunesdb, atoi(argv[3]),
 				      &reflist)) > 0) {